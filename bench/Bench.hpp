@@ -0,0 +1,145 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+// Minimal benchmark harness: every case is a callable doing `ops` operations,
+// it is run several times and the fastest run is kept.
+namespace bench {
+
+struct Result {
+  std::string name;
+  std::size_t ops = 0;
+  double seconds = 0.0;
+  // Extra numbers reported with the case (errors, counts, sizes)
+  std::map<std::string, double> counters;
+  // Names of the counters that failed their check
+  std::vector<std::string> failedChecks;
+
+  double nsPerOp() const { return ops ? seconds * 1e9 / ops : 0.0; }
+  double opsPerSec() const { return seconds > 0.0 ? ops / seconds : 0.0; }
+};
+
+// Command line settings shared by all suites
+struct Config {
+  // Only cases whose name contains this run (empty: all)
+  std::string filter;
+  // Entity counts of the synthetic scene suites
+  std::vector<std::size_t> sceneSizes = {10000, 100000, 1000000};
+  // Fraction of entities getting each component in synthetic scenes
+  double renderShare = 0.5;
+  double scriptShare = 0.01;
+  // Biggest scene saved and loaded as JSON
+  std::size_t maxSerializedEntities = 1000000;
+  // Results are also written here as JSON when set
+  std::string jsonPath;
+};
+
+class Runner {
+public:
+  Runner() = default;
+  explicit Runner(const Config &config) : config(config) {}
+
+  const Config &getConfig() const { return config; }
+
+  bool wants(const std::string &name) const {
+    return config.filter.empty() ||
+           name.find(config.filter) != std::string::npos;
+  }
+
+  // For skipping the setup of a whole suite: false only if no case named
+  // "<group>..." can pass the filter. group ends with '/'.
+  bool wantsGroup(const std::string &group) const {
+    std::size_t slash = config.filter.find('/');
+    if (slash == std::string::npos)
+      return true;
+    // The filter crosses a group boundary, its head has to end the group
+    std::size_t headSize = slash + 1;
+    return group.size() >= headSize &&
+           group.compare(group.size() - headSize, headSize, config.filter, 0,
+                         headSize) == 0;
+  }
+
+  template <typename F>
+  const Result &run(const std::string &name, std::size_t ops, F &&fn,
+                    int repeats = 5) {
+    if (!wants(name)) {
+      lastSkipped = true;
+      static const Result skipped;
+      return skipped;
+    }
+    lastSkipped = false;
+    double best = 0.0;
+    for (int i = 0; i < repeats; ++i) {
+      auto start = std::chrono::steady_clock::now();
+      fn();
+      std::chrono::duration<double> elapsed =
+          std::chrono::steady_clock::now() - start;
+      if (i == 0 || elapsed.count() < best)
+        best = elapsed.count();
+    }
+    results.push_back({name, ops, best, {}, {}});
+    const Result &r = results.back();
+    std::printf("%-48s %12.2f ns/op %14.0f ops/s\n", r.name.c_str(),
+                r.nsPerOp(), r.opsPerSec());
+    std::fflush(stdout);
+    return r;
+  }
+
+  // Attaches a number to the last case, and prints it
+  void counter(const std::string &key, double value) {
+    if (results.empty() || lastSkipped)
+      return;
+    results.back().counters[key] = value;
+    std::printf("  %s: %g\n", key.c_str(), value);
+  }
+
+  // A counter that has to lie in [min, max]. A value outside is reported,
+  // and the bench exits with an error after all suites ran.
+  void check(const std::string &key, double value, double min, double max) {
+    if (results.empty() || lastSkipped)
+      return;
+    counter(key, value);
+    if (value >= min && value <= max)
+      return;
+    results.back().failedChecks.push_back(key);
+    std::printf("  FAILED: %s = %g, expected [%g, %g]\n", key.c_str(), value,
+                min, max);
+    ++failures;
+  }
+  void checkEqual(const std::string &key, double value, double expected) {
+    check(key, value, expected, expected);
+  }
+  void checkAtMost(const std::string &key, double value, double max) {
+    check(key, value, -std::numeric_limits<double>::infinity(), max);
+  }
+
+  // Number of failed checks so far
+  std::size_t getFailures() const { return failures; }
+
+  const std::vector<Result> &getResults() const { return results; }
+
+private:
+  Config config;
+  std::vector<Result> results;
+  bool lastSkipped = false;
+  std::size_t failures = 0;
+};
+
+// Keeps the optimizer from discarding a computed value
+template <typename T> inline void doNotOptimize(const T &value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const T *sink;
+  sink = &value;
+#endif
+}
+
+} // namespace bench
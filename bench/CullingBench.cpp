@@ -0,0 +1,52 @@
+#include "Suites.hpp"
+#include "math/Culling.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+namespace {
+
+const std::size_t SPHERE_COUNT = 1000000;
+
+} // namespace
+
+void runCullingBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("culling/"))
+    return;
+  // Same camera as RenderSystem, spheres scattered around it
+  glm::mat4 view =
+      glm::translate(glm::mat4(1.0f), -glm::vec3(0.0f, 0.0f, 3.0f));
+  glm::mat4 projection =
+      glm::perspective(glm::radians(45.0f), 800.0f / 600.0f, 0.1f, 100.0f);
+  Frustum frustum = extractFrustum(projection * view);
+
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> coord(-100.0f, 100.0f);
+  std::uniform_real_distribution<float> size(0.05f, 2.0f);
+  SphereSoA spheres;
+  for (std::size_t i = 0; i < SPHERE_COUNT; ++i)
+    spheres.push(glm::vec3(coord(rng), coord(rng), coord(rng)), size(rng));
+
+  std::vector<std::uint8_t> reference(SPHERE_COUNT);
+  std::vector<std::uint8_t> result(SPHERE_COUNT);
+  std::size_t visibleCount = 0;
+  // Also computed outside the cases, which the filter may skip
+  cullSpheres(SimdLevel::Scalar, frustum, spheres, reference.data());
+
+  runner.run("culling/scalar", SPHERE_COUNT, [&] {
+    visibleCount = cullSpheres(SimdLevel::Scalar, frustum, spheres,
+                               reference.data());
+  });
+  runner.counter("visible", double(visibleCount));
+
+  if (detectSimdLevel() >= SimdLevel::SSE2) {
+    runner.run("culling/sse2", SPHERE_COUNT, [&] {
+      visibleCount =
+          cullSpheres(SimdLevel::SSE2, frustum, spheres, result.data());
+    });
+    std::size_t mismatches = 0;
+    for (std::size_t i = 0; i < SPHERE_COUNT; ++i)
+      mismatches += reference[i] != result[i];
+    runner.checkEqual("mismatches vs scalar", double(mismatches), 0.0);
+  }
+}
@@ -0,0 +1,304 @@
+#include "ResourceManager.hpp"
+#include "Suites.hpp"
+#include "SyntheticScene.hpp"
+#include "core/ThreadPool.hpp"
+#include "serialization/BinaryScene.hpp"
+#include "serialization/Serialization.hpp"
+#include "system/ScriptingSystem.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::string MODEL_PATH = "assets/models/rat.obj";
+
+// Few repeats for the cases rebuilding a whole world
+const int SETUP_REPEATS = 3;
+
+bench::SceneMix mixFrom(const bench::Config &config) {
+  bench::SceneMix mix;
+  mix.renderShare = config.renderShare;
+  mix.scriptShare = config.scriptShare;
+  mix.modelPath = MODEL_PATH;
+  return mix;
+}
+
+void runModelCases(bench::Runner &runner) {
+  // Parsing every time, as on the first use of a model
+  double parseSeconds =
+      runner
+          .run("engine/loadModel rat.obj cold", 1,
+               [] {
+                 ResourceManager resources;
+                 bench::doNotOptimize(resources.loadModel(MODEL_PATH));
+               })
+          .seconds;
+
+  // Warm cooked mesh cache, as on every start after the first
+  if (runner.wants("engine/loadModel rat.obj cooked")) {
+    const std::string cacheDir =
+        (std::filesystem::temp_directory_path() / "ecs_bench_mesh_cache")
+            .string();
+    std::error_code ec;
+    std::filesystem::remove_all(cacheDir, ec);
+    ResourceManager parsing;
+    parsing.setMeshCacheDir(cacheDir);
+    std::shared_ptr<Model> parsed = parsing.loadModel(MODEL_PATH);
+    std::shared_ptr<Model> cooked;
+    double cookedSeconds =
+        runner
+            .run("engine/loadModel rat.obj cooked", 1,
+                 [&] {
+                   ResourceManager resources;
+                   resources.setMeshCacheDir(cacheDir);
+                   cooked = resources.loadModel(MODEL_PATH);
+                 })
+            .seconds;
+    runner.checkEqual("cooked mismatch",
+                      double(!parsed || !cooked ||
+                             parsed->vertices != cooked->vertices ||
+                             parsed->indices != cooked->indices ||
+                             parsed->lods != cooked->lods ||
+                             parsed->boundsRadius != cooked->boundsRadius),
+                      0.0);
+    if (parseSeconds > 0.0)
+      runner.counter("parse / cooked time", parseSeconds / cookedSeconds);
+
+    // A cache file of the right size whose vertex count is garbage is
+    // reported and the source imported again
+    for (const auto &entry :
+         std::filesystem::directory_iterator(cacheDir, ec)) {
+      std::fstream file(entry.path(),
+                        std::ios::in | std::ios::out | std::ios::binary);
+      const std::uint32_t vertexCount = 0xfffffff0u;
+      file.seekp(8); // after magic and version
+      file.write(reinterpret_cast<const char *>(&vertexCount),
+                 sizeof(vertexCount));
+    }
+    ResourceManager reimporting;
+    reimporting.setMeshCacheDir(cacheDir);
+    std::shared_ptr<Model> reimported = reimporting.loadModel(MODEL_PATH);
+    runner.checkEqual("corrupt cache mismatch",
+                      double(!parsed || !reimported ||
+                             parsed->vertices != reimported->vertices),
+                      0.0);
+    std::filesystem::remove_all(cacheDir, ec);
+  }
+
+  ResourceManager resources;
+  std::shared_ptr<Model> model = resources.loadModel(MODEL_PATH);
+  const std::size_t lookups = 100000;
+  runner.run("engine/loadModel rat.obj cached", lookups, [&] {
+    for (std::size_t i = 0; i < lookups; ++i)
+      bench::doNotOptimize(resources.loadModel(MODEL_PATH));
+  });
+  runner.counter("triangles",
+                 model ? double(model->lod(0).indexCount / 3) : 0.0);
+
+  // Distinct files, as a scene with several models would request them
+  if (!runner.wants("engine/loadModel 8 files") &&
+      !runner.wants("engine/loadModelAsync 8 files"))
+    return;
+  std::vector<std::string> paths;
+  std::error_code ec;
+  for (int i = 0; i < 8; ++i) {
+    std::filesystem::path copy = std::filesystem::temp_directory_path() /
+                                 ("ecs_bench_model_" + std::to_string(i) +
+                                  ".obj");
+    std::filesystem::copy_file(
+        MODEL_PATH, copy, std::filesystem::copy_options::overwrite_existing,
+        ec);
+    paths.push_back(copy.string());
+  }
+  runner.run("engine/loadModel 8 files", paths.size(), [&] {
+    ResourceManager cold;
+    for (const std::string &path : paths)
+      bench::doNotOptimize(cold.loadModel(path));
+  });
+  ThreadPool pool;
+  runner.run("engine/loadModelAsync 8 files", paths.size(), [&] {
+    ResourceManager cold;
+    cold.setThreadPool(&pool);
+    std::vector<ModelFuture> futures;
+    for (const std::string &path : paths)
+      futures.push_back(cold.loadModelAsync(path));
+    for (const std::string &path : paths)
+      bench::doNotOptimize(cold.loadModel(path));
+  });
+  runner.counter("workers", double(pool.getWorkerCount()));
+  for (const std::string &path : paths)
+    std::filesystem::remove(path, ec);
+}
+
+struct SceneFormatCases {
+  const char *save;
+  const char *load;
+  const char *extension;
+  bool (*saveFn)(const World &, const std::string &);
+  bool (*loadFn)(World &, ResourceManager &, const std::string &);
+};
+
+const SceneFormatCases BINARY = {"saveSceneBinary", "loadSceneBinary", ".bin",
+                                 saveSceneBinary, loadSceneBinary};
+const SceneFormatCases JSON = {"saveScene", "loadScene", ".json", saveScene,
+                               loadScene};
+
+// Order-independent hash of everything the scene files store
+std::uint64_t sceneChecksum(const World &world) {
+  std::hash<std::string> hashString;
+  auto mix = [](std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    return h ^ (h >> 33);
+  };
+  std::uint64_t sum = 0;
+  for (const Archetype &arch : world.getArchetypes()) {
+    if (arch.has<TransformComponent>())
+      for (const TransformComponent &tc : arch.column<TransformComponent>()) {
+        std::uint64_t h = tc.parent != INVALID_ENTITY;
+        for (const auto *v : {&tc.position, &tc.rotation, &tc.scale})
+          for (float f : *v)
+            h = mix(h ^ std::bit_cast<std::uint32_t>(f));
+        sum += h;
+      }
+    if (arch.has<RenderComponent>())
+      for (const RenderComponent &rc : arch.column<RenderComponent>())
+        sum += mix(hashString(rc.modelPath) + 1);
+    if (arch.has<LuaScriptComponent>())
+      for (const LuaScriptComponent &sc : arch.column<LuaScriptComponent>())
+        sum += mix(hashString(sc.getScriptPath()) + 2);
+  }
+  return sum;
+}
+
+// Saves and loads world through a temporary file in one format, returns the
+// load time (0 if filtered out)
+double runRoundTrip(bench::Runner &runner, const std::string &prefix,
+                  const World &world, const SceneFormatCases &format) {
+  const std::string saveName = prefix + format.save;
+  const std::string loadName = prefix + format.load;
+  if (!runner.wants(saveName) && !runner.wants(loadName))
+    return 0.0;
+  const std::size_t count = world.getEntities().size();
+  const std::filesystem::path file =
+      std::filesystem::temp_directory_path() /
+      ("ecs_bench_scene_" + std::to_string(count) + format.extension);
+  std::error_code ec;
+
+  bool saved = false;
+  runner.run(
+      saveName, count, [&] { saved = format.saveFn(world, file.string()); },
+      SETUP_REPEATS);
+  // The file has to exist even if the save case was filtered out
+  if (!runner.wants(saveName))
+    saved = format.saveFn(world, file.string());
+  runner.counter("file bytes", double(std::filesystem::file_size(file, ec)));
+
+  // Loading appends, so every run starts from an empty world
+  std::unique_ptr<World> loaded;
+  ResourceManager resources;
+  bool ok = false;
+  auto load = [&] {
+    loaded = std::make_unique<World>();
+    ok = saved && format.loadFn(*loaded, resources, file.string());
+  };
+  double seconds = runner.run(loadName, count, load, SETUP_REPEATS).seconds;
+  if (loaded)
+    runner.checkEqual("round trip mismatch",
+                      double(!ok || loaded->getEntities().size() != count ||
+                             sceneChecksum(*loaded) != sceneChecksum(world)),
+                      0.0);
+  std::filesystem::remove(file, ec);
+  return seconds;
+}
+
+void runSceneCases(bench::Runner &runner, std::size_t count,
+                   const std::shared_ptr<Model> &model) {
+  const bench::Config &config = runner.getConfig();
+  const bench::SceneMix mix = mixFrom(config);
+  const std::string prefix = "engine/" + std::to_string(count) + "/";
+
+  runner.run(
+      prefix + "create entities", count,
+      [&] {
+        World world;
+        for (std::size_t i = 0; i < count; ++i)
+          bench::doNotOptimize(world.createEntity());
+      },
+      SETUP_REPEATS);
+
+  runner.run(
+      prefix + "create + add components", count,
+      [&] {
+        World world;
+        bench::doNotOptimize(bench::generateScene(world, count, mix, model));
+      },
+      SETUP_REPEATS);
+
+  // The remaining cases share one world
+  const char *shared[] = {"get<Transform> random", "view<T, R> iterate",
+                          "ScriptingSystem::update", "Scene"};
+  if (std::none_of(std::begin(shared), std::end(shared),
+                   [&](const char *name) { return runner.wants(prefix + name); }))
+    return;
+
+  World world;
+  std::vector<Entity> entities =
+      bench::generateScene(world, count, mix, model);
+  const std::size_t renderCount = world.count<RenderComponent>();
+  const std::size_t scriptCount = world.count<LuaScriptComponent>();
+
+  std::vector<Entity> shuffled = entities;
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(3));
+  runner.run(prefix + "get<Transform> random", count, [&] {
+    float sum = 0.0f;
+    for (Entity e : shuffled)
+      sum += world.get<TransformComponent>(e)->position[0];
+    bench::doNotOptimize(sum);
+  });
+
+  runner.run(prefix + "view<T, R> iterate", renderCount, [&] {
+    float sum = 0.0f;
+    world.view<TransformComponent, RenderComponent>().each(
+        [&](Entity, TransformComponent &tc, RenderComponent &) {
+          sum += tc.position[0];
+        });
+    bench::doNotOptimize(sum);
+  });
+
+  if (runner.wants(prefix + "ScriptingSystem::update")) {
+    ScriptingSystem scripting(&world);
+    scripting.init();
+    // The first update loads the script files
+    scripting.update(0.016f);
+    runner.run(prefix + "ScriptingSystem::update", scriptCount,
+               [&] { scripting.update(0.016f); });
+  }
+
+  double binarySeconds = runRoundTrip(runner, prefix, world, BINARY);
+  if (count > config.maxSerializedEntities)
+    return;
+  double jsonSeconds = runRoundTrip(runner, prefix, world, JSON);
+  if (binarySeconds > 0.0 && jsonSeconds > 0.0)
+    runner.counter("JSON / binary load time", jsonSeconds / binarySeconds);
+}
+} // namespace
+
+void runEngineBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("engine/"))
+    return;
+  runModelCases(runner);
+
+  ResourceManager resources;
+  std::shared_ptr<Model> model = resources.loadModel(MODEL_PATH);
+  for (std::size_t count : runner.getConfig().sceneSizes)
+    runSceneCases(runner, count, model);
+}
@@ -0,0 +1,92 @@
+#include "Suites.hpp"
+#include "math/MeshOptimizer.hpp"
+#include "serialization/ObjImporter.hpp"
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+namespace {
+
+const std::string MODEL_PATH = "assets/models/rat.obj";
+
+// Quads per side of the grid, whose triangles are shuffled
+const unsigned GRID_SIDE = 256;
+
+Model makeShuffledGrid() {
+  Model model;
+  for (unsigned y = 0; y <= GRID_SIDE; ++y)
+    for (unsigned x = 0; x <= GRID_SIDE; ++x) {
+      float u = float(x) / float(GRID_SIDE), v = float(y) / float(GRID_SIDE);
+      model.vertices.insert(model.vertices.end(),
+                            {u, 0.0f, v, 0.0f, 1.0f, 0.0f, u, v});
+    }
+  std::vector<std::array<unsigned int, 3>> triangles;
+  const unsigned row = GRID_SIDE + 1;
+  for (unsigned y = 0; y < GRID_SIDE; ++y)
+    for (unsigned x = 0; x < GRID_SIDE; ++x) {
+      unsigned int i = y * row + x;
+      triangles.push_back({i, i + row, i + 1});
+      triangles.push_back({i + 1, i + row, i + row + 1});
+    }
+  std::shuffle(triangles.begin(), triangles.end(), std::mt19937(42));
+  for (const auto &t : triangles)
+    model.indices.insert(model.indices.end(), t.begin(), t.end());
+  model.computeBounds();
+  return model;
+}
+
+// Triangles as vertex data, each rotated to start at its smallest corner
+// (which keeps the winding), sorted. Equal for the same triangle set.
+std::vector<std::array<float, 3 * Model::VERTEX_FLOATS>>
+triangleSet(const Model &model) {
+  std::vector<std::array<float, 3 * Model::VERTEX_FLOATS>> set;
+  set.reserve(model.indices.size() / 3);
+  for (std::size_t i = 0; i + 2 < model.indices.size(); i += 3) {
+    std::array<std::array<float, Model::VERTEX_FLOATS>, 3> corners;
+    for (int c = 0; c < 3; ++c) {
+      const float *v =
+          &model.vertices[model.indices[i + c] * Model::VERTEX_FLOATS];
+      std::copy(v, v + Model::VERTEX_FLOATS, corners[c].begin());
+    }
+    std::rotate(corners.begin(),
+                std::min_element(corners.begin(), corners.end()),
+                corners.end());
+    std::array<float, 3 * Model::VERTEX_FLOATS> triangle;
+    for (int c = 0; c < 3; ++c)
+      std::copy(corners[c].begin(), corners[c].end(),
+                triangle.begin() + c * Model::VERTEX_FLOATS);
+    set.push_back(triangle);
+  }
+  std::sort(set.begin(), set.end());
+  return set;
+}
+
+void runModel(bench::Runner &runner, const std::string &label,
+              const Model &source) {
+  Model model;
+  MeshOptimizeStats stats;
+  runner.run("mesh/optimizeMesh " + label, source.indices.size() / 3, [&] {
+    model = source;
+    stats = optimizeMesh(model);
+  }, 5);
+  runner.counter("ACMR before", stats.before.acmr);
+  // optimizeMesh keeps the old order rather than make it worse
+  runner.checkAtMost("ACMR after", stats.after.acmr, stats.before.acmr);
+  runner.counter("ATVR before", stats.before.atvr);
+  runner.counter("ATVR after", stats.after.atvr);
+  runner.counter("clusters", double(stats.clusters));
+  runner.checkEqual("triangle mismatch",
+                    double(triangleSet(model) != triangleSet(source)), 0.0);
+}
+
+} // namespace
+
+void runMeshOptimizerBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("mesh/"))
+    return;
+  Model rat;
+  if (importObj(MODEL_PATH, rat))
+    runModel(runner, "rat.obj", rat);
+  runModel(runner, "shuffled grid", makeShuffledGrid());
+}
@@ -0,0 +1,156 @@
+#include "Suites.hpp"
+#include "math/MeshOptimizer.hpp"
+#include "math/MeshSimplifier.hpp"
+#include "serialization/ObjImporter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::string MODEL_PATH = "assets/models/rat.obj";
+
+// Quads per side of the flat grid
+const unsigned GRID_SIDE = 64;
+
+// Closest point on triangle abc to p (Ericson, Real-Time Collision
+// Detection 5.1.5)
+glm::vec3 closestOnTriangle(const glm::vec3 &p, const glm::vec3 &a,
+                            const glm::vec3 &b, const glm::vec3 &c) {
+  glm::vec3 ab = b - a, ac = c - a, ap = p - a;
+  float d1 = glm::dot(ab, ap), d2 = glm::dot(ac, ap);
+  if (d1 <= 0.0f && d2 <= 0.0f)
+    return a;
+  glm::vec3 bp = p - b;
+  float d3 = glm::dot(ab, bp), d4 = glm::dot(ac, bp);
+  if (d3 >= 0.0f && d4 <= d3)
+    return b;
+  float vc = d1 * d4 - d3 * d2;
+  if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+    return a + ab * (d1 / (d1 - d3));
+  glm::vec3 cp = p - c;
+  float d5 = glm::dot(ab, cp), d6 = glm::dot(ac, cp);
+  if (d6 >= 0.0f && d5 <= d6)
+    return c;
+  float vb = d5 * d2 - d1 * d6;
+  if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+    return a + ac * (d2 / (d2 - d6));
+  float va = d3 * d6 - d5 * d4;
+  if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+    return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+  float denom = 1.0f / (va + vb + vc);
+  return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+// Largest distance from a vertex of the full mesh to the level's surface,
+// relative to boundsRadius. Measured independently of the quadrics.
+float maxDeviation(const Model &model, const Model::Lod &lod) {
+  const Model::Lod full = model.lod(0);
+  float worst = 0.0f;
+  for (std::size_t i = full.indexOffset; i < full.indexOffset + full.indexCount;
+       ++i) {
+    glm::vec3 p = model.position(model.indices[i]);
+    float best = INFINITY;
+    for (std::size_t t = lod.indexOffset; t < lod.indexOffset + lod.indexCount;
+         t += 3) {
+      glm::vec3 q = closestOnTriangle(p, model.position(model.indices[t]),
+                                      model.position(model.indices[t + 1]),
+                                      model.position(model.indices[t + 2]));
+      best = std::min(best, glm::length(p - q));
+    }
+    worst = std::max(worst, best);
+  }
+  return model.boundsRadius > 0.0f ? worst / model.boundsRadius : 0.0f;
+}
+
+Model makeFlatGrid() {
+  Model model;
+  for (unsigned y = 0; y <= GRID_SIDE; ++y)
+    for (unsigned x = 0; x <= GRID_SIDE; ++x) {
+      float u = float(x) / float(GRID_SIDE), v = float(y) / float(GRID_SIDE);
+      model.vertices.insert(model.vertices.end(),
+                            {u, 0.0f, v, 0.0f, 1.0f, 0.0f, u, v});
+    }
+  const unsigned row = GRID_SIDE + 1;
+  for (unsigned y = 0; y < GRID_SIDE; ++y)
+    for (unsigned x = 0; x < GRID_SIDE; ++x) {
+      unsigned int i = y * row + x;
+      model.indices.insert(model.indices.end(),
+                           {i, i + row, i + 1, i + 1, i + row, i + row + 1});
+    }
+  model.computeBounds();
+  return model;
+}
+
+} // namespace
+
+void runMeshSimplifierBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("lod/"))
+    return;
+
+  Model source;
+  if (importObj(MODEL_PATH, source)) {
+    optimizeMesh(source); // as ResourceManager imports it
+    Model model;
+    runner.run("lod/generateLods rat.obj", 1, [&] {
+      model = source;
+      generateLods(model);
+    }, 5);
+    if (model.lods.empty()) {
+      model = source;
+      generateLods(model);
+    }
+    runner.counter("levels", double(model.lods.size()));
+    const double fullTriangles = model.lods[0].indexCount / 3.0;
+    // Every level within the error bound and smaller than the one before
+    std::size_t notSmaller = 0;
+    for (std::size_t level = 1; level < model.lods.size(); ++level) {
+      const Model::Lod &lod = model.lods[level];
+      const std::string name = "LOD" + std::to_string(level);
+      runner.counter(name + " triangles / full",
+                     lod.indexCount / 3.0 / fullTriangles);
+      runner.checkAtMost(name + " quadric error", lod.error, MAX_LOD_ERROR);
+      runner.checkAtMost(name + " max deviation", maxDeviation(model, lod),
+                         MAX_LOD_ERROR);
+      notSmaller += lod.indexCount >= model.lods[level - 1].indexCount;
+    }
+    runner.checkEqual("levels not smaller than the previous",
+                      double(notSmaller), 0.0);
+  }
+
+  // A plane loses every interior vertex at zero error; the locked border
+  // stays
+  Model grid = makeFlatGrid();
+  std::vector<unsigned int> simplified;
+  float gridError = 0.0f;
+  runner.run("lod/simplifyMesh flat grid", grid.indices.size() / 3, [&] {
+    simplified = simplifyMesh(grid, grid.indices, 0, MAX_LOD_ERROR, &gridError);
+  }, 5);
+  runner.counter("triangles / full",
+                 double(simplified.size()) / double(grid.indices.size()));
+  runner.checkAtMost("quadric error", gridError, MAX_LOD_ERROR);
+
+  // An entity moving back and forth across a switching distance
+  Model lodModel;
+  lodModel.indices.resize(3 * 7);
+  lodModel.lods = {{0, 12, 0.0f}, {12, 6, 0.01f}, {18, 3, 0.05f}};
+  auto countSwitches = [&](float hysteresis) {
+    std::size_t switches = 0;
+    std::uint32_t lod = 0;
+    for (int frame = 0; frame < 1000; ++frame) {
+      // Around 100 pixels, where LOD1 costs exactly one pixel of error
+      float pixelRadius = 100.0f * (1.0f + 0.05f * std::sin(frame * 0.3f));
+      std::uint32_t next = lodModel.selectLod(
+          pixelRadius, lod, Model::LOD_PIXEL_ERROR, hysteresis);
+      switches += next != lod;
+      lod = next;
+    }
+    return switches;
+  };
+  std::size_t switches = 0;
+  runner.run("lod/selectLod 1000 frames near a threshold", 1000,
+             [&] { switches = countSwitches(Model::LOD_HYSTERESIS); });
+  runner.counter("switches", double(switches));
+  runner.counter("switches without hysteresis", double(countSwitches(0.0f)));
+}
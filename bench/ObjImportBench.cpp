@@ -0,0 +1,126 @@
+#include "Suites.hpp"
+#include "core/ThreadPool.hpp"
+#include "serialization/ObjImporter.hpp"
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace {
+
+const std::string MODEL_PATH = "assets/models/rat.obj";
+
+// Synthetic file of about this size, like a large art asset
+const std::size_t SYNTHETIC_MEGABYTES = 64;
+
+bool sameModel(const Model &a, const Model &b) {
+  if (a.vertices != b.vertices || a.indices != b.indices ||
+      a.materials.size() != b.materials.size())
+    return false;
+  for (std::size_t i = 0; i < a.materials.size(); ++i) {
+    const Model::MaterialInfo &x = a.materials[i];
+    const Model::MaterialInfo &y = b.materials[i];
+    if (x.name != y.name || x.diffuse_texname != y.diffuse_texname ||
+        x.ambient_texname != y.ambient_texname ||
+        x.specular_texname != y.specular_texname ||
+        x.diffuse_color != y.diffuse_color ||
+        x.ambient_color != y.ambient_color ||
+        x.specular_color != y.specular_color || x.shininess != y.shininess)
+      return false;
+  }
+  return true;
+}
+
+// Grid of quads with positions, texcoords and normals. Every other row of
+// faces uses negative (relative) indices.
+void writeSyntheticObj(const std::string &path, std::size_t megabytes) {
+  // About 120 bytes of v/vt/vn and 60 of f per grid vertex
+  const std::size_t side = static_cast<std::size_t>(
+      std::sqrt(double(megabytes) * 1024 * 1024 / 180.0));
+  std::ofstream out(path, std::ios::binary);
+  char line[256];
+  out << "# synthetic grid " << side << "x" << side << "\n";
+  for (std::size_t y = 0; y < side; ++y)
+    for (std::size_t x = 0; x < side; ++x) {
+      float fx = float(x) / float(side), fy = float(y) / float(side);
+      std::snprintf(line, sizeof(line),
+                    "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n",
+                    fx * 100.0f - 50.0f, std::sin(fx * 20.0f) * 2.0f,
+                    fy * -100.0f + 50.0f, fx, fy, 0.0f, 1.0f, 0.0f);
+      out << line;
+    }
+  const long total = static_cast<long>(side * side);
+  for (std::size_t y = 0; y + 1 < side; ++y)
+    for (std::size_t x = 0; x + 1 < side; ++x) {
+      long i[4] = {long(y * side + x) + 1, long(y * side + x + 1) + 1,
+                   long((y + 1) * side + x + 1) + 1,
+                   long((y + 1) * side + x) + 1};
+      if (y % 2)
+        for (long &v : i)
+          v -= total + 1;
+      std::snprintf(line, sizeof(line),
+                    "f %ld/%ld/%ld %ld/%ld/%ld %ld/%ld/%ld %ld/%ld/%ld\n",
+                    i[0], i[0], i[0], i[1], i[1], i[1], i[2], i[2], i[2],
+                    i[3], i[3], i[3]);
+      out << line;
+    }
+}
+
+// Runs importObj and the tinyobjloader reference on path
+void runFile(bench::Runner &runner, const std::string &label,
+             const std::string &path, ThreadPool &pool) {
+  std::error_code ec;
+  const double megabytes =
+      double(std::filesystem::file_size(path, ec)) / (1024.0 * 1024.0);
+  auto throughput = [&](const bench::Result &r) {
+    if (r.seconds > 0.0)
+      runner.counter("MB/s", megabytes / r.seconds);
+  };
+
+  Model reference;
+  const bool referenceOk = importObjTinyobj(path, reference);
+  throughput(runner.run("obj/tinyobjloader " + label, 1, [&] {
+    Model model;
+    bench::doNotOptimize(importObjTinyobj(path, model));
+  }, 3));
+
+  Model model;
+  throughput(runner.run("obj/importObj " + label + " 1 thread", 1, [&] {
+    model = Model();
+    bench::doNotOptimize(importObj(path, model));
+  }, 3));
+  runner.checkEqual("mismatch vs tinyobjloader",
+                    double(!referenceOk || !sameModel(model, reference)), 0.0);
+
+  throughput(runner.run("obj/importObj " + label + " pool", 1, [&] {
+    model = Model();
+    bench::doNotOptimize(importObj(path, model, &pool));
+  }, 3));
+  runner.checkEqual("mismatch vs tinyobjloader",
+                    double(!referenceOk || !sameModel(model, reference)), 0.0);
+  runner.counter("threads", double(pool.getWorkerCount() + 1));
+}
+
+} // namespace
+
+void runObjImportBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("obj/"))
+    return;
+  ThreadPool pool;
+  runFile(runner, "rat.obj", MODEL_PATH, pool);
+
+  const std::string label =
+      "synthetic " + std::to_string(SYNTHETIC_MEGABYTES) + " MB";
+  if (!runner.wants("obj/tinyobjloader " + label) &&
+      !runner.wants("obj/importObj " + label + " 1 thread") &&
+      !runner.wants("obj/importObj " + label + " pool"))
+    return;
+  const std::string path =
+      (std::filesystem::temp_directory_path() / "ecs_bench_synthetic.obj")
+          .string();
+  writeSyntheticObj(path, SYNTHETIC_MEGABYTES);
+  runFile(runner, label, path, pool);
+  std::error_code ec;
+  std::filesystem::remove(path, ec);
+}
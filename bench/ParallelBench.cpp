@@ -0,0 +1,78 @@
+#include "Suites.hpp"
+#include "core/World.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <thread>
+
+namespace {
+
+const std::size_t ENTITY_COUNT = 1000000;
+
+glm::mat4 composeModelMatrix(const TransformComponent &tc) {
+  glm::mat4 m = glm::translate(
+      glm::mat4(1.0f),
+      glm::vec3(tc.position[0], tc.position[1], tc.position[2]));
+  m = glm::rotate(m, glm::radians(tc.rotation[0]), glm::vec3(1, 0, 0));
+  m = glm::rotate(m, glm::radians(tc.rotation[1]), glm::vec3(0, 1, 0));
+  m = glm::rotate(m, glm::radians(tc.rotation[2]), glm::vec3(0, 0, 1));
+  return glm::scale(m, glm::vec3(tc.scale[0], tc.scale[1], tc.scale[2]));
+}
+
+} // namespace
+
+void runParallelBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("parallel/"))
+    return;
+  World world;
+  for (std::size_t i = 0; i < ENTITY_COUNT; ++i) {
+    Entity e = world.createEntity();
+    TransformComponent tc;
+    tc.position = {float(i % 100), float(i / 100 % 100), float(i / 10000)};
+    tc.rotation = {float(i % 360), 0.0f, 0.0f};
+    world.addComponent(e, tc);
+    world.addComponent(e, RenderComponent{});
+  }
+  std::vector<glm::mat4> matrices(ENTITY_COUNT);
+
+  unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<unsigned> threadCounts;
+  for (unsigned t = 1; t < hw; t *= 2)
+    threadCounts.push_back(t);
+  threadCounts.push_back(hw);
+
+  for (unsigned threads : threadCounts) {
+    // The calling thread helps, so threads - 1 workers
+    std::unique_ptr<ThreadPool> pool;
+    if (threads > 1)
+      pool = std::make_unique<ThreadPool>(threads - 1);
+    char name[64];
+
+    std::snprintf(name, sizeof(name), "parallel/transform update, %u threads",
+                  threads);
+    runner.run(name, ENTITY_COUNT, [&] {
+      world.parallelForEach<TransformComponent>(
+          pool.get(), [](Entity, TransformComponent &tc) {
+            tc.rotation[1] += 0.016f * 45.0f;
+            tc.position[1] += 0.001f;
+          });
+    });
+
+    std::snprintf(name, sizeof(name), "parallel/model matrices, %u threads",
+                  threads);
+    runner.run(name, ENTITY_COUNT, [&] {
+      world.view<const TransformComponent, const RenderComponent>()
+          .parallelEachChunk(
+              pool.get(),
+              [&](const Chunk<const TransformComponent,
+                              const RenderComponent> &chunk) {
+                const TransformComponent *tcs =
+                    chunk.get<const TransformComponent>();
+                for (std::size_t i = 0; i < chunk.size; ++i)
+                  matrices[chunk.offset + i] = composeModelMatrix(tcs[i]);
+              });
+      bench::doNotOptimize(matrices.back());
+    });
+  }
+}
@@ -0,0 +1,88 @@
+#include "Suites.hpp"
+#include "system/RenderQueue.hpp"
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+const std::size_t PACKET_COUNT = 100000;
+const std::size_t MODEL_COUNT = 64;
+const std::size_t MATERIAL_COUNT = 8;
+
+// Counts calls instead of issuing them
+class CountingBackend : public RenderBackend {
+public:
+  std::size_t calls = 0;
+  std::size_t instances = 0;
+
+  void beginSubmit(const std::vector<DrawPacket> &) override { ++calls; }
+  void setShader(std::uint32_t) override { ++calls; }
+  void setMaterial(std::uint32_t) override { ++calls; }
+  void setModel(Model *, std::uint32_t) override { ++calls; }
+  void drawInstances(std::size_t, std::size_t count) override {
+    ++calls;
+    instances += count;
+  }
+  void endSubmit() override { ++calls; }
+};
+
+} // namespace
+
+void runRenderQueueBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("render queue/"))
+    return;
+  std::vector<Model> models(MODEL_COUNT);
+  for (std::size_t i = 0; i < MODEL_COUNT; ++i)
+    models[i].sortId = static_cast<std::uint32_t>(i + 1);
+  glm::mat4 transform(1.0f);
+
+  // Packets in scene order, as the render system would emit them
+  std::mt19937 rng(7);
+  std::vector<DrawPacket> input(PACKET_COUNT);
+  for (DrawPacket &p : input) {
+    Model *model = &models[rng() % MODEL_COUNT];
+    p.shader = 0;
+    p.material = static_cast<std::uint32_t>(rng() % MATERIAL_COUNT);
+    p.model = model;
+    p.transform = &transform;
+    p.lod = 0;
+    p.key = RenderQueue::makeKey(p.shader, p.material, model->sortId, p.lod,
+                                 float(rng() % 10000) / 10000.0f);
+  }
+
+  RenderQueue queue;
+  queue.reserve(PACKET_COUNT);
+  runner.run("render queue/push + radix sort", PACKET_COUNT, [&] {
+    queue.clear();
+    for (const DrawPacket &p : input)
+      queue.push(p);
+    queue.sort();
+  });
+
+  std::vector<DrawPacket> reference;
+  runner.run("render queue/push + std::stable_sort", PACKET_COUNT, [&] {
+    reference = input;
+    std::stable_sort(reference.begin(), reference.end(),
+                     [](const DrawPacket &a, const DrawPacket &b) {
+                       return a.key < b.key;
+                     });
+  });
+  std::size_t mismatches = 0;
+  // Either case may have been filtered out
+  if (reference.size() == PACKET_COUNT && queue.size() == PACKET_COUNT)
+    for (std::size_t i = 0; i < PACKET_COUNT; ++i)
+      mismatches += reference[i].key != queue.getPackets()[i].key ||
+                    reference[i].model != queue.getPackets()[i].model;
+  runner.checkEqual("mismatches vs std::stable_sort", double(mismatches),
+                    0.0);
+
+  CountingBackend backend;
+  RenderQueue::Stats stats;
+  runner.run("render queue/submit", PACKET_COUNT,
+             [&] { stats = queue.submit(backend); });
+  // The per-entity path issued one draw per packet
+  runner.counter("draws", double(stats.draws));
+  runner.counter("material changes", double(stats.materialChanges));
+  runner.counter("model changes", double(stats.modelChanges));
+}
@@ -0,0 +1,115 @@
+#include "ResourceManager.hpp"
+#include "Suites.hpp"
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::string MODEL_PATH = "assets/models/rat.obj";
+
+// Distinct paths, the first REFERENCED_COUNT held as entities would
+const int MODEL_COUNT = 16;
+const int REFERENCED_COUNT = 4;
+// Unreferenced models the budget leaves room for
+const int KEPT_UNUSED = 4;
+
+const std::size_t TRIM_CALLS = 10000;
+
+} // namespace
+
+void runResidencyBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("residency/"))
+    return;
+
+  const std::filesystem::path dir =
+      std::filesystem::temp_directory_path() / "ecs_bench_residency";
+  std::error_code ec;
+  std::filesystem::remove_all(dir, ec);
+  std::filesystem::create_directories(dir / "cache", ec);
+  std::vector<std::string> paths;
+  for (int i = 0; i < MODEL_COUNT; ++i) {
+    std::filesystem::path copy = dir / ("model_" + std::to_string(i) + ".obj");
+    std::filesystem::copy_file(MODEL_PATH, copy, ec);
+    paths.push_back(copy.string());
+  }
+
+  ResourceManager resources;
+  resources.setMeshCacheDir((dir / "cache").string());
+  std::vector<std::shared_ptr<Model>> referenced;
+  for (int i = 0; i < MODEL_COUNT; ++i) {
+    std::shared_ptr<Model> model = resources.loadModel(paths[i]);
+    if (!model) {
+      std::filesystem::remove_all(dir, ec);
+      return;
+    }
+    if (i < REFERENCED_COUNT)
+      referenced.push_back(model);
+    // One frame per request, so the unused ones age in path order
+    resources.trim();
+  }
+
+  // Within budget: only the bookkeeping a frame pays
+  runner.run("residency/trim 16 models within budget", TRIM_CALLS, [&] {
+    for (std::size_t i = 0; i < TRIM_CALLS; ++i)
+      resources.trim();
+  });
+
+  // Room for the referenced models and the KEPT_UNUSED newest others
+  const std::size_t modelBytes = referenced[0]->cpuBytes();
+  resources.setMemoryBudget(modelBytes * (REFERENCED_COUNT + KEPT_UNUSED));
+  std::size_t unloaded = 0;
+  runner.run("residency/trim over budget", 1,
+             [&] { unloaded = resources.trim(); }, 1);
+  resources.trim(); // in case the case was filtered out
+  std::size_t lruViolations = 0;
+  for (const ResourceManager::ModelMemory &m : resources.getModelMemory())
+    for (int i = REFERENCED_COUNT; i < MODEL_COUNT - KEPT_UNUSED; ++i)
+      lruViolations += m.path == paths[i];
+  ResourceManager::MemoryStats stats = resources.getMemoryStats();
+  runner.counter("unloaded", double(unloaded));
+  runner.checkEqual("LRU order violations", double(lruViolations), 0.0);
+  runner.counter("resident bytes / budget",
+                 double(stats.cpuBytes + stats.gpuBytes) / stats.budget);
+  std::size_t referencedLost = 0;
+  for (const std::shared_ptr<Model> &model : referenced)
+    referencedLost += model.use_count() == 1;
+  runner.checkEqual("referenced unloaded", double(referencedLost), 0.0);
+
+  // An unloaded path comes back from the cooked cache
+  std::shared_ptr<Model> reloaded;
+  runner.run("residency/reload unloaded model cooked", 1, [&] {
+    reloaded = resources.loadModel(paths[REFERENCED_COUNT]);
+  }, 1);
+  runner.counter("reloads", double(resources.getMemoryStats().reloads));
+  runner.checkEqual("reload mismatch",
+                    double(!reloaded ||
+                           reloaded->vertices != referenced[0]->vertices ||
+                           reloaded->lods != referenced[0]->lods),
+                    0.0);
+
+  // What an uploaded model keeps with ResourceManager's CPU copy dropped
+  Model released = *referenced[0];
+  released.releaseCpuData();
+  runner.counter("cpu bytes released / kept",
+                 double(released.cpuBytes()) / double(modelBytes));
+
+  // Held only through futures nobody resolved, as RenderComponent::
+  // pendingModel is in a headless run: one of a model loaded before, one
+  // the request loaded
+  std::vector<ModelFuture> pending = {
+      resources.loadModelAsync(paths[MODEL_COUNT - 1]),
+      resources.loadModelAsync(paths[REFERENCED_COUNT + 1])};
+  referenced.clear();
+  reloaded.reset();
+  resources.unloadUnused();
+  runner.checkEqual("models held by futures after unloadUnused",
+                    double(resources.getMemoryStats().models),
+                    double(pending.size()));
+  pending.clear();
+  resources.unloadUnused();
+  runner.checkEqual("models after unloadUnused",
+                    double(resources.getMemoryStats().models), 0.0);
+  std::filesystem::remove_all(dir, ec);
+}
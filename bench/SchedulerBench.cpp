@@ -0,0 +1,92 @@
+#include "Suites.hpp"
+#include "system/SystemScheduler.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace {
+
+// Detects overlapping execution of conflicting systems at runtime
+struct AccessTracker {
+  std::atomic<int> readers[COMPONENT_TYPE_COUNT] = {};
+  std::atomic<int> writers[COMPONENT_TYPE_COUNT] = {};
+  std::atomic<int> violations{0};
+
+  void enter(const SystemAccess &a) {
+    for (std::size_t c = 0; c < COMPONENT_TYPE_COUNT; ++c) {
+      ComponentMask bit = ComponentMask(1) << c;
+      if (a.writes & bit) {
+        if (writers[c].fetch_add(1) != 0 || readers[c].load() != 0)
+          violations.fetch_add(1);
+      } else if (a.reads & bit) {
+        readers[c].fetch_add(1);
+        if (writers[c].load() != 0)
+          violations.fetch_add(1);
+      }
+    }
+  }
+  void leave(const SystemAccess &a) {
+    for (std::size_t c = 0; c < COMPONENT_TYPE_COUNT; ++c) {
+      ComponentMask bit = ComponentMask(1) << c;
+      if (a.writes & bit)
+        writers[c].fetch_sub(1);
+      else if (a.reads & bit)
+        readers[c].fetch_sub(1);
+    }
+  }
+};
+
+void spin(std::chrono::microseconds duration) {
+  auto until = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < until) {
+  }
+}
+
+} // namespace
+
+void runSchedulerBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("scheduler/"))
+    return;
+  const SystemAccess accesses[] = {
+      SystemAccess().write<TransformComponent>(),
+      SystemAccess().read<TransformComponent, RenderComponent>(),
+      SystemAccess().write<LuaScriptComponent>(),
+      SystemAccess().read<RenderComponent>(),
+      SystemAccess().read<TransformComponent>(),
+      SystemAccess().write<RenderComponent>(),
+      SystemAccess().read<LuaScriptComponent>(),
+      SystemAccess().read<TransformComponent>(),
+  };
+  const std::size_t FRAMES = 200;
+  // At least a few workers even on small machines, so the overlap check
+  // always sees concurrent frames
+  unsigned maxWorkers = std::max(4u, std::thread::hardware_concurrency());
+
+  for (unsigned workers = 0; workers <= maxWorkers;
+       workers = workers ? workers * 2 : 1) {
+    AccessTracker tracker;
+    ThreadPool pool(workers ? workers : 1);
+    SystemScheduler scheduler(workers ? &pool : nullptr);
+    for (const SystemAccess &access : accesses) {
+      scheduler.addSystem("synthetic", access, [&tracker, access] {
+        tracker.enter(access);
+        spin(std::chrono::microseconds(50));
+        tracker.leave(access);
+      });
+    }
+    char name[64];
+    std::snprintf(name, sizeof(name), "scheduler/8 systems, %u workers",
+                  workers);
+    runner.run(
+        name, FRAMES,
+        [&] {
+          for (std::size_t f = 0; f < FRAMES; ++f)
+            scheduler.runFrame();
+        },
+        1);
+    runner.checkEqual("conflicting systems overlapped",
+                      double(tracker.violations.load()), 0.0);
+  }
+}
@@ -0,0 +1,271 @@
+#include "Suites.hpp"
+#include "core/World.hpp"
+#include "system/ScriptingSystem.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const std::string ROTATE_PATH = "scripts/rotate.lua";
+
+const std::size_t ENTITY_COUNT = 10000;
+const int FRAMES = 10;
+const float DT = 0.016f;
+
+// Moves along x and counts its own frames in a script global
+const char *COUNTER_SCRIPT = R"(frames = 0
+function update()
+    frames = frames + 1
+    set_position(frames, 0, 0)
+end
+)";
+
+// The same move and turn, written several ways
+struct ScriptStyle {
+  const char *name;
+  const char *source;
+};
+const ScriptStyle STYLES[] = {
+    // As scripts had to before get_position returned numbers: two tables
+    // of garbage per call
+    {"tables", R"(function update()
+    local p = {get_position()}
+    set_position(p[1] + 0.001, p[2], p[3])
+    rotate({0, 1, 0}, dt * 45.0)
+end
+)"},
+    {"numbers", R"(function update()
+    local x, y, z = get_position()
+    set_position(x + 0.001, y, z)
+    rotate(0, 1, 0, dt * 45.0)
+end
+)"},
+    {"transform proxy", R"(function update()
+    transform.x = transform.x + 0.001
+    transform.ry = transform.ry + dt * 45.0
+end
+)"},
+    // One call per frame, per-entity access inside Lua
+    {"update_batch", R"(-- batch
+function update_batch(entities, dt)
+    for i = 1, #entities do
+        local x, y, z = entities:position(i)
+        entities:set_position(i, x + 0.001, y, z)
+    end
+    entities:rotate(0, 1, 0, dt * 45.0)
+end
+)"},
+    // One call per frame, bulk accessors only
+    {"update_batch bulk", R"(-- batch
+function update_batch(entities, dt)
+    entities:translate(0.001, 0, 0)
+    entities:rotate(0, 1, 0, dt * 45.0)
+end
+)"},
+};
+
+// Every other entity runs the first script, the rest the second
+std::vector<Entity> makeScene(World &world, const std::string &evenPath,
+                              const std::string &oddPath) {
+  std::vector<Entity> entities;
+  for (std::size_t i = 0; i < ENTITY_COUNT; ++i) {
+    Entity e = world.createEntity();
+    world.addComponent(e, TransformComponent{});
+    LuaScriptComponent sc;
+    sc.setScriptPath(i % 2 ? oddPath : evenPath);
+    world.addComponent(e, sc);
+    entities.push_back(e);
+  }
+  return entities;
+}
+
+std::size_t luaHeapBytes(lua_State *L) {
+  return std::size_t(lua_gc(L, LUA_GCCOUNT, 0)) * 1024 +
+         std::size_t(lua_gc(L, LUA_GCCOUNTB, 0));
+}
+
+// Update calls per second of one script style, the garbage each call
+// leaves and the collector's share of a frame
+void runStyle(bench::Runner &runner, const ScriptStyle &style,
+              const std::string &path) {
+  const std::string name =
+      std::string("script/update 10000 entities, ") + style.name;
+  if (!runner.wants(name))
+    return;
+  std::ofstream(path) << style.source;
+  World world;
+  std::vector<Entity> entities = makeScene(world, path, path);
+  ScriptingSystem scripting(&world);
+  scripting.init();
+  scripting.update(DT);
+  lua_State *L = scripting.getLuaState();
+
+  int framesRun = 1;
+  auto runFrames = [&] {
+    for (int frame = 0; frame < FRAMES; ++frame)
+      scripting.update(DT);
+    framesRun += FRAMES;
+  };
+
+  // Collector stopped: the heap growth is the garbage
+  double stoppedSeconds = 0.0;
+  std::size_t garbage = 0;
+  for (int repeat = 0; repeat < 3; ++repeat) {
+    lua_gc(L, LUA_GCCOLLECT, 0);
+    lua_gc(L, LUA_GCSTOP, 0);
+    const std::size_t before = luaHeapBytes(L);
+    auto start = std::chrono::steady_clock::now();
+    runFrames();
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    garbage = luaHeapBytes(L) - before;
+    if (repeat == 0 || elapsed.count() < stoppedSeconds)
+      stoppedSeconds = elapsed.count();
+    lua_gc(L, LUA_GCRESTART, 0);
+  }
+  lua_gc(L, LUA_GCCOLLECT, 0);
+
+  const double seconds =
+      runner.run(name, ENTITY_COUNT * FRAMES, runFrames, 3).seconds;
+  runner.counter("garbage bytes per update",
+                 double(garbage) / double(ENTITY_COUNT * FRAMES));
+  runner.counter("gc ms per frame",
+                 std::max(0.0, seconds - stoppedSeconds) * 1000.0 / FRAMES);
+
+  // Every style moves and turns every entity once per frame
+  std::size_t wrong = 0;
+  for (Entity e : entities) {
+    const TransformComponent *tc = world.getTransform(e);
+    wrong += std::fabs(tc->position[0] - framesRun * 0.001f) > 1e-4f ||
+             std::fabs(tc->rotation[1] - framesRun * DT * 45.0f) > 1e-2f;
+  }
+  runner.checkEqual("entities with wrong results", double(wrong), 0.0);
+}
+
+} // namespace
+
+void runScriptBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("script/"))
+    return;
+
+  const std::filesystem::path counterPath =
+      std::filesystem::temp_directory_path() / "ecs_bench_counter.lua";
+  std::ofstream(counterPath) << COUNTER_SCRIPT;
+
+  // Loading every entity's script, as the first frame does
+  runner.run("script/first update 10000 entities", ENTITY_COUNT, [&] {
+    World world;
+    makeScene(world, ROTATE_PATH, counterPath.string());
+    ScriptingSystem scripting(&world);
+    scripting.init();
+    scripting.update(DT);
+  }, 3);
+
+  World world;
+  std::vector<Entity> entities =
+      makeScene(world, ROTATE_PATH, counterPath.string());
+  ScriptingSystem scripting(&world);
+  scripting.init();
+  scripting.update(DT);
+  runner.run("script/update 10000 entities, 2 scripts", ENTITY_COUNT * FRAMES,
+             [&] {
+               for (int frame = 0; frame < FRAMES; ++frame)
+                 scripting.update(DT);
+             }, 1);
+
+  // Each entity ran its own script, and kept its own frame count
+  const float frames = float(FRAMES + 1);
+  std::size_t wrongScript = 0;
+  for (std::size_t i = 0; i < entities.size(); ++i) {
+    const TransformComponent *tc = world.getTransform(entities[i]);
+    if (i % 2)
+      wrongScript += tc->position[0] != frames || tc->rotation[1] != 0.0f;
+    else
+      wrongScript += std::fabs(tc->rotation[1] - frames * DT * 45.0f) > 1e-3f ||
+                     tc->position[0] != 0.0f;
+  }
+  runner.checkEqual("entities with wrong results", double(wrongScript), 0.0);
+
+  // Components copied into another World keep this system's script ids,
+  // the other system compiles them in another order and must not use them
+  {
+    World other;
+    Entity counter = other.createEntity();
+    other.addComponent(counter, TransformComponent{});
+    other.addComponent(counter, *world.getScript(entities[1]));
+    Entity rotating = other.createEntity();
+    other.addComponent(rotating, TransformComponent{});
+    other.addComponent(rotating, *world.getScript(entities[0]));
+    ScriptingSystem otherScripting(&other);
+    otherScripting.update(DT);
+    const TransformComponent *tc = other.getTransform(rotating);
+    runner.checkEqual("copied components running another script",
+                      double(tc->position[0] != 0.0f ||
+                             tc->rotation[1] == 0.0f),
+                      0.0);
+  }
+
+  // Destroyed entities' environments are released on the next frame, what
+  // remains is the state itself and the compiled scripts (~8%)
+  lua_State *L = scripting.getLuaState();
+  lua_gc(L, LUA_GCCOLLECT, 0);
+  const double heapWithEntities = double(luaHeapBytes(L));
+  for (Entity e : entities)
+    world.destroyEntity(e);
+  scripting.update(DT);
+  lua_gc(L, LUA_GCCOLLECT, 0);
+  runner.checkAtMost("Lua heap after destroying all / before",
+                     double(luaHeapBytes(L)) / heapWithEntities, 0.5);
+
+  // Scripts can call the transform proxy's metamethods with anything
+  const char *misuse = R"(local mt = debug.getregistry()["ecs.Transform"]
+return pcall(mt.__index, io.stdout, "x") or pcall(mt.__index, 1, "x") or
+    pcall(mt.__newindex, {}, "x", 1)
+)";
+  const bool accepted = luaL_dostring(L, misuse) != LUA_OK ||
+                        lua_toboolean(L, -1);
+  lua_settop(L, 0);
+  runner.checkEqual("transform proxy calls with another self accepted",
+                    double(accepted), 0.0);
+
+  // A script's top level runs once per entity, a batched one's once
+  const std::filesystem::path loadsPath =
+      std::filesystem::temp_directory_path() / "ecs_bench_loads.lua";
+  for (bool batched : {false, true}) {
+    std::ofstream(loadsPath) << (batched ? "-- batch\n" : "")
+                             << "_G.loads = (_G.loads or 0) + 1\n"
+                                "function update() end\n"
+                                "function update_batch() end\n";
+    World loadsWorld;
+    for (int i = 0; i < 3; ++i) {
+      Entity e = loadsWorld.createEntity();
+      loadsWorld.addComponent(e, TransformComponent{});
+      LuaScriptComponent sc;
+      sc.setScriptPath(loadsPath.string());
+      loadsWorld.addComponent(e, sc);
+    }
+    ScriptingSystem loadsScripting(&loadsWorld);
+    loadsScripting.update(DT);
+    lua_State *loadsL = loadsScripting.getLuaState();
+    lua_getglobal(loadsL, "loads");
+    runner.checkEqual(batched ? "top level runs, batched script"
+                              : "top level runs, 3 entities",
+                      double(lua_tointeger(loadsL, -1)), batched ? 1.0 : 3.0);
+    lua_pop(loadsL, 1);
+  }
+
+  const std::filesystem::path stylePath =
+      std::filesystem::temp_directory_path() / "ecs_bench_style.lua";
+  for (const ScriptStyle &style : STYLES)
+    runStyle(runner, style, stylePath.string());
+
+  std::error_code ec;
+  std::filesystem::remove(counterPath, ec);
+  std::filesystem::remove(loadsPath, ec);
+  std::filesystem::remove(stylePath, ec);
+}
@@ -0,0 +1,146 @@
+#include "Suites.hpp"
+#include "core/World.hpp"
+#include <unordered_map>
+
+namespace {
+
+// The previous World layout: one hash map per component type
+struct HashMapWorld {
+  Entity nextEntityId = 1;
+  std::vector<Entity> entities;
+  std::unordered_map<Entity, TransformComponent> transforms;
+  std::unordered_map<Entity, RenderComponent> renders;
+
+  Entity createEntity() {
+    Entity id = nextEntityId++;
+    entities.push_back(id);
+    return id;
+  }
+};
+
+const std::size_t ENTITY_COUNT = 500000;
+
+// Every 4th entity has no RenderComponent
+bool hasRenderAt(std::size_t i) { return i % 4 != 3; }
+
+} // namespace
+
+void runStorageBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("storage/"))
+    return;
+  HashMapWorld hashWorld;
+  World world;
+  for (std::size_t i = 0; i < ENTITY_COUNT; ++i) {
+    TransformComponent tc;
+    tc.position = {float(i), 0.0f, 0.0f};
+    Entity h = hashWorld.createEntity();
+    Entity a = world.createEntity();
+    hashWorld.transforms[h] = tc;
+    world.addComponent(a, tc);
+    if (hasRenderAt(i)) {
+      hashWorld.renders[h] = RenderComponent{};
+      world.addComponent(a, RenderComponent{});
+    }
+  }
+
+  runner.run("storage/iterate T+R hash map", ENTITY_COUNT, [&] {
+    float sum = 0.0f;
+    for (Entity e : hashWorld.entities) {
+      auto tc = hashWorld.transforms.find(e);
+      auto rc = hashWorld.renders.find(e);
+      if (tc != hashWorld.transforms.end() && rc != hashWorld.renders.end())
+        sum += tc->second.position[0];
+    }
+    bench::doNotOptimize(sum);
+  });
+
+  runner.run("storage/iterate T+R archetype columns", ENTITY_COUNT, [&] {
+    float sum = 0.0f;
+    const ComponentMask required =
+        componentMask<TransformComponent, RenderComponent>();
+    for (const Archetype &arch : world.getArchetypes()) {
+      if ((arch.mask & required) != required)
+        continue;
+      for (const TransformComponent &tc : arch.column<TransformComponent>())
+        sum += tc.position[0];
+    }
+    bench::doNotOptimize(sum);
+  });
+
+  runner.run("storage/getTransform hash map", ENTITY_COUNT, [&] {
+    float sum = 0.0f;
+    for (Entity e : hashWorld.entities)
+      sum += hashWorld.transforms.find(e)->second.position[0];
+    bench::doNotOptimize(sum);
+  });
+
+  runner.run("storage/getTransform archetype", ENTITY_COUNT, [&] {
+    float sum = 0.0f;
+    for (Entity e : world.getEntities())
+      sum += world.getTransform(e)->position[0];
+    bench::doNotOptimize(sum);
+  });
+
+  runner.run(
+      "storage/create+add T+R archetype", ENTITY_COUNT,
+      [&] {
+        World w;
+        for (std::size_t i = 0; i < ENTITY_COUNT; ++i) {
+          Entity e = w.createEntity();
+          w.addComponent(e, TransformComponent{});
+          w.addComponent(e, RenderComponent{});
+        }
+        bench::doNotOptimize(w.getEntities().size());
+      },
+      1);
+
+  // Slots get recycled instead of growing: beyond the minimum free list
+  // only one slot per ENTITY_GENERATION_MASK + 1 entities is retired
+  const std::size_t SOAK_CYCLES = 2000000;
+  const std::size_t SOAK_LIVE = 64;
+  World soakWorld;
+  std::vector<Entity> stale; // a sample of destroyed handles
+  runner.run(
+      "storage/spawn+despawn soak", SOAK_CYCLES,
+      [&] {
+        std::vector<Entity> live;
+        for (std::size_t i = 0; i < SOAK_CYCLES; ++i) {
+          Entity e = soakWorld.createEntity();
+          soakWorld.addComponent(e, TransformComponent{});
+          if (i % 2 == 0)
+            soakWorld.addComponent(e, RenderComponent{});
+          if (i % 1000 == 0)
+            stale.push_back(e);
+          live.push_back(e);
+          if (live.size() == SOAK_LIVE) {
+            for (Entity dead : live)
+              soakWorld.destroyEntity(dead);
+            live.clear();
+          }
+        }
+        for (Entity dead : live)
+          soakWorld.destroyEntity(dead);
+      },
+      1);
+  runner.checkAtMost("entity slots allocated", double(soakWorld.slotCount()),
+                     double(SOAK_CYCLES / (ENTITY_GENERATION_MASK + 1) +
+                            World::MIN_FREE_SLOTS + 2 * SOAK_LIVE));
+  // With every free slot in use again, no old handle may match
+  for (std::size_t i = soakWorld.slotCount(); i > 0; --i)
+    soakWorld.createEntity();
+  std::size_t staleAccepted = 0;
+  for (Entity e : stale)
+    staleAccepted += soakWorld.isAlive(e);
+  runner.checkEqual("stale handles accepted", double(staleAccepted), 0.0);
+
+  // clear() leaves every handle stale, as destroying each entity would
+  const std::vector<Entity> cleared = soakWorld.getEntities();
+  soakWorld.clear();
+  for (std::size_t i = soakWorld.slotCount(); i > 0; --i)
+    soakWorld.createEntity();
+  std::size_t clearedAccepted = 0;
+  for (Entity e : cleared)
+    clearedAccepted += soakWorld.isAlive(e);
+  runner.checkEqual("handles accepted after clear", double(clearedAccepted),
+                    0.0);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "Bench.hpp"
+
+// One function per benchmark file
+void runStorageBench(bench::Runner &runner);
+void runViewBench(bench::Runner &runner);
+void runSchedulerBench(bench::Runner &runner);
+void runParallelBench(bench::Runner &runner);
+void runTransformBatchBench(bench::Runner &runner);
+void runHierarchyBench(bench::Runner &runner);
+void runCullingBench(bench::Runner &runner);
+void runRenderQueueBench(bench::Runner &runner);
+// OBJ import throughput, in-tree importer against tinyobjloader
+void runObjImportBench(bench::Runner &runner);
+// Triangle and vertex reordering, ACMR/ATVR before and after
+void runMeshOptimizerBench(bench::Runner &runner);
+// LOD generation quality and selection hysteresis
+void runMeshSimplifierBench(bench::Runner &runner);
+// Compact vertex encode speed and round-trip error
+void runVertexQuantizationBench(bench::Runner &runner);
+// Model unloading over a memory budget, LRU order and reloads
+void runResidencyBench(bench::Runner &runner);
+// Lua script loading and per-entity update calls
+void runScriptBench(bench::Runner &runner);
+// Synthetic scenes of Config::sceneSizes entities through the engine API
+void runEngineBench(bench::Runner &runner);
+// Needs an EGL-capable OpenGL driver, skipped otherwise
+void runUniformBench(bench::Runner &runner);
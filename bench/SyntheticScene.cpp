@@ -0,0 +1,42 @@
+#include "SyntheticScene.hpp"
+#include <cmath>
+#include <random>
+
+namespace bench {
+
+std::vector<Entity> generateScene(World &world, std::size_t count,
+                                  const SceneMix &mix,
+                                  std::shared_ptr<Model> model,
+                                  std::uint32_t seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  const float extent = std::cbrt(float(count)) * 2.0f;
+
+  std::vector<Entity> entities;
+  entities.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    Entity e = world.createEntity();
+    TransformComponent tc;
+    tc.position = {(unit(rng) - 0.5f) * extent, (unit(rng) - 0.5f) * extent,
+                   -unit(rng) * extent};
+    tc.rotation = {0.0f, unit(rng) * 360.0f, 0.0f};
+    tc.scale = {0.05f, 0.05f, 0.05f};
+    world.addComponent(e, tc);
+
+    if (unit(rng) < mix.renderShare) {
+      RenderComponent rc;
+      rc.modelPath = mix.modelPath;
+      rc.model = model;
+      world.addComponent(e, rc);
+    }
+    if (unit(rng) < mix.scriptShare) {
+      LuaScriptComponent sc;
+      sc.setScriptPath(mix.scriptPath);
+      world.addComponent(e, sc);
+    }
+    entities.push_back(e);
+  }
+  return entities;
+}
+
+} // namespace bench
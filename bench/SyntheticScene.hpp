@@ -0,0 +1,29 @@
+#pragma once
+
+#include "core/World.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+// Component mix of a generated scene. Every entity has a transform, the
+// shares pick which ones also get a render or script component.
+struct SceneMix {
+  double renderShare = 0.5;
+  double scriptShare = 0.01;
+  std::string modelPath = "assets/models/rat.obj";
+  std::string scriptPath = "scripts/rotate.lua";
+};
+
+// Fills world with count entities placed in a cube, deterministic for a
+// given seed. model may be null (render components then only hold the path).
+// Returns the created entities in creation order.
+std::vector<Entity> generateScene(World &world, std::size_t count,
+                                  const SceneMix &mix,
+                                  std::shared_ptr<Model> model,
+                                  std::uint32_t seed = 1);
+
+} // namespace bench
@@ -0,0 +1,78 @@
+#include "Suites.hpp"
+#include "math/TransformBatch.hpp"
+#include <cmath>
+#include <cstdio>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+
+namespace {
+
+const std::size_t MATRIX_COUNT = 1000000;
+// Allowed difference of any matrix element from glm, which the kernels'
+// float sin/cos polynomials cause; about 5e-5 is measured for the angles
+// and scales below
+const float MAX_ABS_ERROR = 1e-4f;
+
+// The per-entity path RenderSystem used before
+glm::mat4 composeWithGlm(const TransformComponent &tc) {
+  glm::mat4 m = glm::translate(
+      glm::mat4(1.0f),
+      glm::vec3(tc.position[0], tc.position[1], tc.position[2]));
+  m = glm::rotate(m, glm::radians(tc.rotation[0]), glm::vec3(1, 0, 0));
+  m = glm::rotate(m, glm::radians(tc.rotation[1]), glm::vec3(0, 1, 0));
+  m = glm::rotate(m, glm::radians(tc.rotation[2]), glm::vec3(0, 0, 1));
+  return glm::scale(m, glm::vec3(tc.scale[0], tc.scale[1], tc.scale[2]));
+}
+
+float maxAbsError(const std::vector<glm::mat4> &a,
+                  const std::vector<glm::mat4> &b) {
+  float err = 0.0f;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    for (int c = 0; c < 4; ++c)
+      for (int r = 0; r < 4; ++r)
+        err = std::fmax(err, std::fabs(a[i][c][r] - b[i][c][r]));
+  return err;
+}
+
+} // namespace
+
+void runTransformBatchBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("transform/"))
+    return;
+  std::vector<TransformComponent> transforms(MATRIX_COUNT);
+  for (std::size_t i = 0; i < MATRIX_COUNT; ++i) {
+    TransformComponent &tc = transforms[i];
+    tc.position = {float(i % 97), float(i % 89) * 0.5f, -float(i % 83)};
+    // Includes large accumulated angles like a long-running rotate.lua
+    tc.rotation = {float(i % 720) - 360.0f, float(i % 1013) * 7.3f,
+                   float(i % 31) * 11.0f - 170.0f};
+    tc.scale = {0.05f + float(i % 7), 1.0f, 0.5f + float(i % 3)};
+  }
+
+  std::vector<glm::mat4> reference(MATRIX_COUNT);
+  std::vector<glm::mat4> result(MATRIX_COUNT);
+  // Also computed outside the cases, which the filter may skip
+  for (std::size_t i = 0; i < MATRIX_COUNT; ++i)
+    reference[i] = composeWithGlm(transforms[i]);
+
+  runner.run("transform/glm translate*rotate*scale", MATRIX_COUNT, [&] {
+    for (std::size_t i = 0; i < MATRIX_COUNT; ++i)
+      reference[i] = composeWithGlm(transforms[i]);
+  });
+
+  const SimdLevel best = detectSimdLevel();
+  for (SimdLevel level :
+       {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2}) {
+    if (level > best)
+      break;
+    char name[64];
+    std::snprintf(name, sizeof(name), "transform/batch %s",
+                  simdLevelName(level));
+    runner.run(name, MATRIX_COUNT, [&] {
+      composeModelMatrices(level, transforms.data(), MATRIX_COUNT,
+                           result.data());
+    });
+    runner.checkAtMost("max abs error vs glm", maxAbsError(reference, result),
+                       MAX_ABS_ERROR);
+  }
+}
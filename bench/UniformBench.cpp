@@ -0,0 +1,143 @@
+#include "Suites.hpp"
+#include <cstdio>
+
+#ifdef ECS_HAS_EGL
+#include "platform/HeadlessGL.hpp"
+#include "system/GLRenderBackend.hpp"
+#include "system/Shader.hpp"
+#include <glad/glad.h>
+#include <glm/gtc/type_ptr.hpp>
+#include <string>
+
+namespace {
+
+const std::size_t DRAW_COUNT = 100000;
+
+// Declares the same uniforms RenderSystem used per entity and per frame
+const char *VERTEX_SRC = R"(#version 330 core
+layout(location = 0) in vec3 aPos;
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+layout(std140) uniform FrameData {
+    mat4 frameView;
+    mat4 frameProjection;
+    vec3 lightPos;
+    vec3 lightColor;
+    vec3 viewPos;
+};
+void main() {
+    gl_Position = projection * view * model * vec4(aPos, 1.0) +
+                  frameProjection * frameView * vec4(lightPos, 1.0);
+})";
+const char *FRAGMENT_SRC = R"(#version 330 core
+out vec4 FragColor;
+uniform vec3 objectColor;
+uniform bool useTexture;
+layout(std140) uniform FrameData {
+    mat4 frameView;
+    mat4 frameProjection;
+    vec3 lightPos;
+    vec3 lightColor;
+    vec3 viewPos;
+};
+void main() {
+    FragColor = vec4(useTexture ? lightColor : objectColor + viewPos, 1.0);
+})";
+
+} // namespace
+
+void runUniformBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("uniforms/"))
+    return;
+  HeadlessGL gl;
+  if (!gl.create(64, 64)) {
+    std::printf("uniforms: skipped, no headless GL context\n");
+    return;
+  }
+  Shader shader(VERTEX_SRC, FRAGMENT_SRC);
+  shader.use();
+  const unsigned int program = shader.getID();
+  glm::mat4 model(1.0f);
+  glm::vec3 color(1.0f);
+
+  // What every entity paid before: a std::string and a driver lookup for
+  // each of its three uniforms
+  runner.run("uniforms/per draw, glGetUniformLocation", DRAW_COUNT, [&] {
+    for (std::size_t i = 0; i < DRAW_COUNT; ++i) {
+      model[3][0] = float(i);
+      glUniformMatrix4fv(
+          glGetUniformLocation(program, std::string("model").c_str()), 1,
+          GL_FALSE, glm::value_ptr(model));
+      glUniform1i(
+          glGetUniformLocation(program, std::string("useTexture").c_str()),
+          0);
+      glUniform3fv(
+          glGetUniformLocation(program, std::string("objectColor").c_str()),
+          1, glm::value_ptr(color));
+    }
+    glFinish();
+  });
+
+  runner.run("uniforms/per draw, reflected name lookup", DRAW_COUNT, [&] {
+    for (std::size_t i = 0; i < DRAW_COUNT; ++i) {
+      model[3][0] = float(i);
+      shader.setMat4("model", model);
+      shader.setBool("useTexture", false);
+      shader.setVec3("objectColor", color);
+    }
+    glFinish();
+  });
+
+  const int modelLoc = shader.getUniformLocation("model");
+  const int useTextureLoc = shader.getUniformLocation("useTexture");
+  const int colorLoc = shader.getUniformLocation("objectColor");
+  runner.run("uniforms/per draw, cached location", DRAW_COUNT, [&] {
+    for (std::size_t i = 0; i < DRAW_COUNT; ++i) {
+      model[3][0] = float(i);
+      shader.setMat4(modelLoc, model);
+      shader.setBool(useTextureLoc, false);
+      shader.setVec3(colorLoc, color);
+    }
+    glFinish();
+  });
+
+  // Per-frame camera and light: five uniforms per shader vs one buffer
+  const std::size_t FRAME_COUNT = 10000;
+  glm::mat4 view(1.0f), projection(1.0f);
+  glm::vec3 lightPos(0.0f, 5.0f, 5.0f), viewPos(0.0f, 0.0f, 3.0f);
+  runner.run("uniforms/per frame, 5 glUniform", FRAME_COUNT, [&] {
+    for (std::size_t i = 0; i < FRAME_COUNT; ++i) {
+      view[3][2] = -float(i);
+      shader.setMat4("view", view);
+      shader.setMat4("projection", projection);
+      shader.setVec3("lightPos", lightPos);
+      shader.setVec3("lightColor", color);
+      shader.setVec3("viewPos", viewPos);
+    }
+    glFinish();
+  });
+
+  GLRenderBackend backend;
+  backend.addShader(&shader);
+  FrameData frame{view, projection, glm::vec4(lightPos, 0.0f),
+                  glm::vec4(color, 0.0f), glm::vec4(viewPos, 0.0f)};
+  runner.run("uniforms/per frame, FrameData buffer", FRAME_COUNT, [&] {
+    for (std::size_t i = 0; i < FRAME_COUNT; ++i) {
+      frame.view[3][2] = -float(i);
+      backend.setFrameData(frame);
+    }
+    glFinish();
+  });
+  runner.counter("gl error", double(glGetError()));
+}
+
+#else
+
+void runUniformBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("uniforms/"))
+    return;
+  std::printf("uniforms: skipped, built without EGL (ECS_HAS_EGL)\n");
+}
+
+#endif
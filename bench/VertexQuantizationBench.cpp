@@ -0,0 +1,110 @@
+#include "Suites.hpp"
+#include "math/VertexQuantization.hpp"
+#include "serialization/ObjImporter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+const std::string MODEL_PATH = "assets/models/rat.obj";
+
+const std::size_t NORMAL_COUNT = 1000000;
+
+// Error bounds of the round trip. Positions: one unorm16 step of the
+// model's extent (rounding gives half a step, plus float error).
+// Normals: octahedral int16, about 0.035 deg worst over the sphere.
+// Texcoords: half a half-float step for UVs in [0, 2).
+const float MAX_POSITION_ERROR = 1.0f / 65535.0f;
+const float MAX_NORMAL_ERROR_DEG = 0.05f;
+const float MAX_TEXCOORD_ERROR = 1.0f / 2048.0f;
+
+float angleDegrees(const glm::vec3 &a, const glm::vec3 &b) {
+  float c = glm::dot(glm::normalize(a), glm::normalize(b));
+  return glm::degrees(std::acos(std::clamp(c, -1.0f, 1.0f)));
+}
+
+} // namespace
+
+void runVertexQuantizationBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("vertex/"))
+    return;
+
+  Model model;
+  if (importObj(MODEL_PATH, model)) {
+    std::vector<CompactVertex> packed;
+    runner.run("vertex/encodeCompactVertices rat.obj", model.vertexCount(),
+               [&] { packed = encodeCompactVertices(model); });
+    if (packed.empty())
+      packed = encodeCompactVertices(model);
+
+    // Round trip as the vertex shader decodes it
+    const PositionQuantization q = positionQuantization(model);
+    const float extent = std::max({q.scale.x, q.scale.y, q.scale.z});
+    float positionError = 0.0f, normalError = 0.0f, texcoordError = 0.0f;
+    float decoded[Model::VERTEX_FLOATS];
+    for (std::size_t i = 0; i < packed.size(); ++i) {
+      decodeCompactVertex(packed[i], q, decoded);
+      const float *v = &model.vertices[i * Model::VERTEX_FLOATS];
+      for (int k = 0; k < 3; ++k)
+        positionError = std::max(positionError, std::fabs(decoded[k] - v[k]));
+      const float *n = v + Model::NORMAL_OFFSET;
+      normalError = std::max(
+          normalError, angleDegrees(glm::vec3(n[0], n[1], n[2]),
+                                    glm::vec3(decoded[Model::NORMAL_OFFSET],
+                                              decoded[Model::NORMAL_OFFSET + 1],
+                                              decoded[Model::NORMAL_OFFSET + 2])));
+      for (std::size_t k = Model::TEXCOORD_OFFSET; k < Model::VERTEX_FLOATS;
+           ++k)
+        texcoordError = std::max(texcoordError, std::fabs(decoded[k] - v[k]));
+    }
+    runner.checkAtMost("position max error / extent", positionError / extent,
+                       MAX_POSITION_ERROR);
+    runner.checkAtMost("normal max error deg", normalError,
+                       MAX_NORMAL_ERROR_DEG);
+    runner.checkAtMost("texcoord max error", texcoordError,
+                       MAX_TEXCOORD_ERROR);
+    runner.counter("vertex bytes float",
+                   double(model.vertices.size() * sizeof(float)));
+    runner.counter("vertex bytes compact",
+                   double(packed.size() * sizeof(CompactVertex)));
+    runner.counter("index bytes 32-bit",
+                   double(model.indices.size() * sizeof(unsigned int)));
+    runner.counter("index bytes uploaded",
+                   double(model.indices.size() *
+                          (fitsShortIndices(model.vertexCount())
+                               ? sizeof(std::uint16_t)
+                               : sizeof(unsigned int))));
+  }
+
+  // Octahedral encoding over the whole sphere, not only rat.obj's normals
+  std::mt19937 rng(42);
+  std::normal_distribution<float> gauss;
+  std::vector<glm::vec3> normals(NORMAL_COUNT);
+  for (glm::vec3 &n : normals)
+    n = glm::normalize(glm::vec3(gauss(rng), gauss(rng), gauss(rng)));
+  std::vector<std::int16_t> encoded(NORMAL_COUNT * 2);
+  runner.run("vertex/encodeOctahedral", NORMAL_COUNT, [&] {
+    for (std::size_t i = 0; i < NORMAL_COUNT; ++i)
+      encodeOctahedral(normals[i], &encoded[i * 2]);
+  });
+  float maxError = 0.0f;
+  for (std::size_t i = 0; i < NORMAL_COUNT; ++i) {
+    encodeOctahedral(normals[i], &encoded[i * 2]);
+    maxError = std::max(
+        maxError, angleDegrees(normals[i], decodeOctahedral(&encoded[i * 2])));
+  }
+  runner.checkAtMost("max error deg", maxError, MAX_NORMAL_ERROR_DEG);
+
+  // Every finite half survives halfToFloat -> floatToHalf
+  std::size_t halfMismatches = 0;
+  for (std::uint32_t h = 0; h < 0x10000u; ++h) {
+    const std::uint16_t half = static_cast<std::uint16_t>(h);
+    const bool subnormal = (half & 0x7c00u) == 0 && (half & 0x3ffu) != 0;
+    if ((half & 0x7c00u) == 0x7c00u || subnormal)
+      continue; // inf/NaN, and subnormals flush to zero by design
+    halfMismatches += floatToHalf(halfToFloat(half)) != half;
+  }
+  runner.checkEqual("half round trip mismatches", double(halfMismatches), 0.0);
+}
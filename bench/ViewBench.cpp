@@ -0,0 +1,59 @@
+#include "Suites.hpp"
+#include "core/World.hpp"
+
+namespace {
+
+const std::size_t ENTITY_COUNT = 500000;
+
+} // namespace
+
+void runViewBench(bench::Runner &runner) {
+  if (!runner.wantsGroup("view/"))
+    return;
+  // Everything has a transform and a render component, 1% has a script
+  World world;
+  for (std::size_t i = 0; i < ENTITY_COUNT; ++i) {
+    Entity e = world.createEntity();
+    world.addComponent(e, TransformComponent{});
+    world.addComponent(e, RenderComponent{});
+    if (i % 100 == 0)
+      world.addComponent(e, LuaScriptComponent{});
+  }
+
+  runner.run("view/scripts via getEntities scan", ENTITY_COUNT, [&] {
+    std::size_t n = 0;
+    for (Entity e : world.getEntities())
+      if (auto sc = world.getScript(e))
+        n += sc->getScriptPath().size() + 1;
+    bench::doNotOptimize(n);
+  });
+
+  runner.run("view/scripts via view<LuaScript>", ENTITY_COUNT, [&] {
+    std::size_t n = 0;
+    world.view<LuaScriptComponent>().each(
+        [&](Entity, LuaScriptComponent &sc) {
+          n += sc.getScriptPath().size() + 1;
+        });
+    bench::doNotOptimize(n);
+  });
+
+  runner.run("view/T+R via getEntities scan", ENTITY_COUNT, [&] {
+    float sum = 0.0f;
+    for (Entity e : world.getEntities()) {
+      auto tc = world.getTransform(e);
+      auto rc = world.getRender(e);
+      if (tc && rc)
+        sum += tc->position[0];
+    }
+    bench::doNotOptimize(sum);
+  });
+
+  runner.run("view/T+R via view<T, R>", ENTITY_COUNT, [&] {
+    float sum = 0.0f;
+    world.view<TransformComponent, RenderComponent>().each(
+        [&](Entity, TransformComponent &tc, RenderComponent &) {
+          sum += tc.position[0];
+        });
+    bench::doNotOptimize(sum);
+  });
+}
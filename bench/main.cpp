@@ -0,0 +1,137 @@
+// Benchmarks of the engine. Run from the repository root so relative asset
+// paths resolve.
+//
+//   ecs_bench [--filter STR] [--json results.json] [--entities 10000,100000]
+//             [--render-share 0.5] [--script-share 0.01]
+//             [--max-serialized N]
+//
+// --filter runs only the cases whose name contains STR, --json also writes
+// every result (ns/op, ops/s and the extra counters) to a file. Correctness
+// checks (mismatches, errors over their tolerance) are counters too; if any
+// fails the exit status is 1.
+#include "Bench.hpp"
+#include "Suites.hpp"
+#include "math/TransformBatch.hpp"
+#include "nlohmann/json.hpp"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+bool parseSizes(const std::string &value, std::vector<std::size_t> &sizes) {
+  sizes.clear();
+  std::stringstream ss(value);
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    std::size_t n = std::strtoul(item.c_str(), nullptr, 10);
+    if (n == 0)
+      return false;
+    sizes.push_back(n);
+  }
+  return !sizes.empty();
+}
+
+bool parseOptions(int argc, char **argv, bench::Config &config) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << arg << std::endl;
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--filter") {
+      config.filter = value;
+    } else if (arg == "--json") {
+      config.jsonPath = value;
+    } else if (arg == "--entities") {
+      if (!parseSizes(value, config.sceneSizes)) {
+        std::cerr << "--entities expects counts, e.g. 10000,100000"
+                  << std::endl;
+        return false;
+      }
+    } else if (arg == "--render-share") {
+      config.renderShare = std::strtod(value.c_str(), nullptr);
+    } else if (arg == "--script-share") {
+      config.scriptShare = std::strtod(value.c_str(), nullptr);
+    } else if (arg == "--max-serialized") {
+      config.maxSerializedEntities = std::strtoul(value.c_str(), nullptr, 10);
+    } else {
+      std::cerr << "Unknown option " << arg << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool writeJson(const bench::Runner &runner) {
+  const bench::Config &config = runner.getConfig();
+  nlohmann::json jRoot;
+  jRoot["meta"] = {
+      {"simd", simdLevelName(detectSimdLevel())},
+      {"hardware_threads", std::thread::hardware_concurrency()},
+      {"filter", config.filter},
+      {"render_share", config.renderShare},
+      {"script_share", config.scriptShare},
+      {"scene_sizes", config.sceneSizes}};
+  nlohmann::json jResults = nlohmann::json::array();
+  for (const bench::Result &r : runner.getResults()) {
+    nlohmann::json jResult;
+    jResult["name"] = r.name;
+    jResult["ops"] = r.ops;
+    jResult["seconds"] = r.seconds;
+    jResult["ns_per_op"] = r.nsPerOp();
+    jResult["ops_per_sec"] = r.opsPerSec();
+    if (!r.counters.empty())
+      jResult["counters"] = r.counters;
+    if (!r.failedChecks.empty())
+      jResult["failed_checks"] = r.failedChecks;
+    jResults.push_back(jResult);
+  }
+  jRoot["results"] = jResults;
+
+  std::ofstream ofs(config.jsonPath);
+  if (!ofs.is_open()) {
+    std::cerr << "Cannot open " << config.jsonPath << std::endl;
+    return false;
+  }
+  ofs << jRoot.dump(2) << std::endl;
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  bench::Config config;
+  if (!parseOptions(argc, argv, config))
+    return 1;
+
+  bench::Runner runner(config);
+  runStorageBench(runner);
+  runViewBench(runner);
+  runSchedulerBench(runner);
+  runParallelBench(runner);
+  runTransformBatchBench(runner);
+  runHierarchyBench(runner);
+  runCullingBench(runner);
+  runRenderQueueBench(runner);
+  runObjImportBench(runner);
+  runMeshOptimizerBench(runner);
+  runMeshSimplifierBench(runner);
+  runVertexQuantizationBench(runner);
+  runResidencyBench(runner);
+  runScriptBench(runner);
+  runUniformBench(runner);
+  runEngineBench(runner);
+
+  if (!config.jsonPath.empty() && !writeJson(runner))
+    return 1;
+  if (runner.getFailures() > 0) {
+    std::cerr << runner.getFailures() << " check(s) failed" << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -1,21 +1,151 @@
 #pragma once
 
 #include "core/RenderComponent.hpp"
+#include "math/MeshOptimizer.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class ThreadPool;
 
 // Using std::shared_ptr<Model>, so if several components refer the same model,
 // the resource wouldn't unload too soon.
+// Thread-safe: models can be requested from any thread. Asynchronous requests
+// are parsed on the thread pool, distinct files in parallel, and concurrent
+// requests for the same path share one parse.
+// Residency: the cache keeps every model until trim() finds the memory over
+// budget; it then unloads the models nobody else references, least recently
+// used first. Requesting an unloaded path loads it again (cheaply with a
+// mesh cache dir). A model's GL buffers outlive it in a queue the render
+// thread empties, see takeReleasedBuffers().
 class ResourceManager {
 public:
-  ResourceManager() = default;
+  // GL names of a deleted model
+  struct GpuBuffers {
+    unsigned int VAO = 0;
+    unsigned int VBO = 0;
+    unsigned int EBO = 0;
+  };
+
+  // One loaded model. references doesn't count the cache's own; the
+  // holders of one unresolved future count as one.
+  struct ModelMemory {
+    std::string path;
+    std::size_t cpuBytes = 0;
+    std::size_t gpuBytes = 0;
+    long references = 0;
+    std::uint64_t lastUsed = 0; // trim() count when last requested or in use
+    // Loaded from the mesh cache; the mesh optimizer did not run then and
+    // optimize is all zero
+    bool cooked = false;
+    MeshOptimizeStats optimize;
+  };
+
+  struct MemoryStats {
+    std::size_t models = 0; // loaded, pending loads not included
+    std::size_t cpuBytes = 0;
+    std::size_t gpuBytes = 0;
+    std::size_t budget = 0;
+    std::size_t evictions = 0; // models unloaded so far
+    std::size_t reloads = 0;   // loads of a path unloaded before
+  };
+
+  ResourceManager();
 
-  // Load .obj (path) or return ptr if already loaded
+  // Pool for loadModelAsync(). Without one requests are parsed on the
+  // calling thread. The pool has to outlive pending requests.
+  void setThreadPool(ThreadPool *pool);
+
+  // Directory for cooked meshes (see serialization/CookedMesh.hpp). Sources
+  // with a valid cooked file there skip parsing, others are cooked after
+  // parsing. Empty (the default) disables the cache. Set before loading.
+  void setMeshCacheDir(const std::string &dir) { meshCacheDir = dir; }
+
+  // Load .obj (path) or return ptr if already loaded. Waits for a pending
+  // asynchronous load of the same path. nullptr if the file can't be loaded.
   std::shared_ptr<Model> loadModel(const std::string &path);
 
+  // Starts loading path unless it is loaded or already loading. The future
+  // yields nullptr if the file can't be loaded; failed paths are retried by
+  // the next request.
+  ModelFuture loadModelAsync(const std::string &path);
+
+  // Number of models being parsed right now
+  std::size_t getPendingCount() const { return shared->pending.load(); }
+
+  // CPU plus GPU bytes of loaded models trim() keeps them under. 0 (the
+  // default) never unloads.
+  void setMemoryBudget(std::size_t bytes) { memoryBudget = bytes; }
+
+  // Unloads unreferenced models, least recently used first, until the
+  // memory fits the budget; marks referenced ones as used. Call once a
+  // frame from the render thread, which also writes the models' GPU sizes.
+  // ModelFutures not resolved yet (e.g. RenderComponent::pendingModel
+  // without a RenderSystem) count as a reference too. Returns the number
+  // of models unloaded.
+  std::size_t trim() {
+    return evictUnused(memoryBudget ? memoryBudget : SIZE_MAX);
+  }
+  // Unloads every unreferenced model, whatever the budget
+  std::size_t unloadUnused() { return evictUnused(0); }
+
+  // Buffers of models destroyed since the last call, for the GL thread to
+  // delete
+  std::vector<GpuBuffers> takeReleasedBuffers();
+
+  std::vector<ModelMemory> getModelMemory() const;
+  MemoryStats getMemoryStats() const;
+
 private:
-  std::unordered_map<std::string, std::shared_ptr<Model>> models;
+  struct Entry {
+    ModelFuture future;           // while loading
+    std::shared_ptr<Model> model; // once loaded
+    std::uint64_t lastUsed = 0;
+    bool cooked = false;
+    MeshOptimizeStats optimize;
+  };
+
+  // Outlives the manager while parse tasks still reference it
+  struct Shared {
+    std::mutex mutex;
+    std::unordered_map<std::string, Entry> models;
+    std::atomic<std::uint32_t> nextModelId{1};
+    std::atomic<std::size_t> pending{0};
+    std::uint64_t trims = 0;
+    std::unordered_set<std::string> unloaded;
+    std::size_t evictions = 0;
+    std::size_t reloads = 0;
+    std::vector<GpuBuffers> releasedBuffers;
+  };
+
+  std::shared_ptr<Shared> shared;
+  ThreadPool *threadPool = nullptr;
+  std::string meshCacheDir;
+  std::size_t memoryBudget = 0;
 
-  bool parseOBJ(const std::string &path, Model &outModel);
-};
\ No newline at end of file
+  // Adds a loading entry for path, counting reloads. Needs shared.mutex.
+  static void addEntry(Shared &shared, const std::string &path,
+                       const ModelFuture &future);
+  // Unloads unreferenced models, oldest lastUsed first, until the loaded
+  // ones take at most budget bytes
+  std::size_t evictUnused(std::size_t budget);
+  // Loads path and publishes the result to promise and the cache
+  static void parse(const std::shared_ptr<Shared> &shared,
+                    const std::string &path, const std::string &cacheDir,
+                    ThreadPool *pool,
+                    std::promise<std::shared_ptr<Model>> &promise);
+  // Parses (on pool), reorders for the vertex cache and fetch and adds LODs
+  static bool importMesh(const std::string &path, ThreadPool *pool,
+                         Model &outModel, MeshOptimizeStats &stats);
+  // From the cooked file in cacheDir if valid, else imports and cooks
+  static bool loadMesh(const std::string &path, const std::string &cacheDir,
+                       ThreadPool *pool, Model &outModel, bool &cooked,
+                       MeshOptimizeStats &stats);
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Entity.hpp"
+#include "LuaScriptComponent.hpp"
+#include "RenderComponent.hpp"
+#include "TransformComponent.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Every component type known to the World. The position in this list is the
+// component id, bit i of a ComponentMask means "has component with id i".
+using ComponentTypes =
+    std::tuple<TransformComponent, RenderComponent, LuaScriptComponent>;
+
+using ComponentMask = std::uint32_t;
+
+namespace detail {
+template <typename T, typename Tuple> struct TypeIndex;
+template <typename T, typename... Ts>
+struct TypeIndex<T, std::tuple<T, Ts...>> {
+  static constexpr std::size_t value = 0;
+};
+template <typename T, typename U, typename... Ts>
+struct TypeIndex<T, std::tuple<U, Ts...>> {
+  static constexpr std::size_t value =
+      1 + TypeIndex<T, std::tuple<Ts...>>::value;
+};
+
+template <typename Tuple> struct ColumnsOf;
+template <typename... Ts> struct ColumnsOf<std::tuple<Ts...>> {
+  using type = std::tuple<std::vector<Ts>...>;
+};
+} // namespace detail
+
+constexpr std::size_t COMPONENT_TYPE_COUNT = std::tuple_size_v<ComponentTypes>;
+
+template <typename T> constexpr std::size_t componentId() {
+  return detail::TypeIndex<std::remove_const_t<T>, ComponentTypes>::value;
+}
+
+template <typename T> constexpr ComponentMask componentBit() {
+  return ComponentMask(1) << componentId<T>();
+}
+
+template <typename... Ts> constexpr ComponentMask componentMask() {
+  return (ComponentMask(0) | ... | componentBit<Ts>());
+}
+
+namespace detail {
+template <typename F, std::size_t... I>
+void forEachComponentType(F &f, std::index_sequence<I...>) {
+  (f(std::type_identity<std::tuple_element_t<I, ComponentTypes>>{}), ...);
+}
+} // namespace detail
+
+// Calls f(std::type_identity<T>{}) for every registered component type
+template <typename F> void forEachComponentType(F &&f) {
+  detail::forEachComponentType(
+      f, std::make_index_sequence<COMPONENT_TYPE_COUNT>{});
+}
+
+// All entities with exactly the same set of components. Components are stored
+// column-wise (one std::vector per type), row i of every column belongs to
+// entities[i], so iterating one component type is a linear walk over memory.
+// Columns of types not in mask stay empty.
+struct Archetype {
+  using Columns = typename detail::ColumnsOf<ComponentTypes>::type;
+
+  ComponentMask mask = 0;
+  std::vector<Entity> entities;
+  Columns columns;
+
+  template <typename T> bool has() const {
+    return (mask & componentBit<T>()) != 0;
+  }
+
+  template <typename T> std::vector<T> &column() {
+    return std::get<std::vector<T>>(columns);
+  }
+  template <typename T> const std::vector<T> &column() const {
+    return std::get<std::vector<T>>(columns);
+  }
+
+  std::size_t size() const { return entities.size(); }
+
+  // Appends row of this archetype to dst (components dst has no column for are
+  // dropped) and removes it from here. Returns the entity that took its place
+  // or INVALID_ENTITY if row was the last one.
+  Entity moveRow(std::size_t row, Archetype &dst) {
+    dst.entities.push_back(entities[row]);
+    forEachComponentType([&](auto tag) {
+      using T = typename decltype(tag)::type;
+      if (has<T>() && dst.has<T>())
+        dst.column<T>().push_back(std::move(column<T>()[row]));
+    });
+    return removeRow(row);
+  }
+
+  // Swap-and-pop removal, same return value as moveRow
+  Entity removeRow(std::size_t row) {
+    std::size_t last = entities.size() - 1;
+    forEachComponentType([&](auto tag) {
+      using T = typename decltype(tag)::type;
+      if (!has<T>())
+        return;
+      auto &col = column<T>();
+      if (row != last)
+        col[row] = std::move(col[last]);
+      col.pop_back();
+    });
+    Entity moved = INVALID_ENTITY;
+    if (row != last) {
+      entities[row] = entities[last];
+      moved = entities[row];
+    }
+    entities.pop_back();
+    return moved;
+  }
+};
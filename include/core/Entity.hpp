@@ -2,6 +2,23 @@
 
 #include <cstdint>
 
-// 1-based, 0 = invalid
+// Handle = slot index (low ENTITY_INDEX_BITS, 1-based, 0 = invalid) and the
+// slot's generation (high bits). The generation is bumped every time the slot
+// is freed, so handles to destroyed entities stop matching their slot.
+// A slot whose generation would wrap around (after ENTITY_GENERATION_MASK + 1
+// uses) is retired by World, so a stale handle never matches again.
 using Entity = std::uint32_t;
-static const Entity INVALID_ENTITY = 0;
\ No newline at end of file
+static const Entity INVALID_ENTITY = 0;
+
+constexpr std::uint32_t ENTITY_INDEX_BITS = 22;
+constexpr std::uint32_t ENTITY_INDEX_MASK = (1u << ENTITY_INDEX_BITS) - 1;
+constexpr std::uint32_t ENTITY_GENERATION_MASK =
+    (1u << (32 - ENTITY_INDEX_BITS)) - 1;
+
+constexpr std::uint32_t entityIndex(Entity e) { return e & ENTITY_INDEX_MASK; }
+constexpr std::uint32_t entityGeneration(Entity e) {
+  return e >> ENTITY_INDEX_BITS;
+}
+constexpr Entity makeEntity(std::uint32_t index, std::uint32_t generation) {
+  return (generation << ENTITY_INDEX_BITS) | (index & ENTITY_INDEX_MASK);
+}
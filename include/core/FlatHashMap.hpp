@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Open-addressing hash map with linear probing, for hot lookups of small
+// trivially copyable keys and values. Entries live in one array, a probe
+// walks neighbouring slots instead of chasing list nodes. No erase: the map
+// only grows, clear() empties it. Hash should mix well, probing relies on
+// the low bits.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class FlatHashMap {
+public:
+  FlatHashMap() = default;
+  explicit FlatHashMap(std::size_t expected) { reserve(expected); }
+
+  std::size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  // Room for n entries without rehashing
+  void reserve(std::size_t n) {
+    std::size_t wanted = MIN_CAPACITY;
+    while (wanted * MAX_LOAD_NUM < n * MAX_LOAD_DEN)
+      wanted *= 2;
+    if (wanted > slots.size())
+      rehash(wanted);
+  }
+
+  void clear() {
+    for (Slot &s : slots)
+      s.used = false;
+    count = 0;
+  }
+
+  Value *find(const Key &key) {
+    if (slots.empty())
+      return nullptr;
+    for (std::size_t i = hasher(key) & mask;; i = (i + 1) & mask) {
+      Slot &s = slots[i];
+      if (!s.used)
+        return nullptr;
+      if (s.key == key)
+        return &s.value;
+    }
+  }
+
+  // Inserts key -> value unless key is present. Returns the stored value and
+  // whether it was inserted.
+  std::pair<Value *, bool> tryEmplace(const Key &key, const Value &value) {
+    if ((count + 1) * MAX_LOAD_DEN > slots.size() * MAX_LOAD_NUM)
+      rehash(slots.empty() ? MIN_CAPACITY : slots.size() * 2);
+    for (std::size_t i = hasher(key) & mask;; i = (i + 1) & mask) {
+      Slot &s = slots[i];
+      if (!s.used) {
+        s.key = key;
+        s.value = value;
+        s.used = true;
+        ++count;
+        return {&s.value, true};
+      }
+      if (s.key == key)
+        return {&s.value, false};
+    }
+  }
+
+private:
+  // Grows at 3/4 load, linear probes stay short below that
+  static constexpr std::size_t MAX_LOAD_NUM = 3;
+  static constexpr std::size_t MAX_LOAD_DEN = 4;
+  static constexpr std::size_t MIN_CAPACITY = 16;
+
+  struct Slot {
+    Key key;
+    Value value;
+    bool used = false;
+  };
+
+  std::vector<Slot> slots;
+  std::size_t mask = 0;
+  std::size_t count = 0;
+  Hash hasher;
+
+  void rehash(std::size_t capacity) {
+    std::vector<Slot> old(capacity);
+    old.swap(slots);
+    mask = capacity - 1;
+    count = 0;
+    for (const Slot &s : old)
+      if (s.used)
+        tryEmplace(s.key, s.value);
+  }
+};
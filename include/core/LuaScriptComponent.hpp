@@ -1,9 +1,28 @@
 #pragma once
 
 #include "Component.hpp"
+#include <cstdint>
 #include <string>
+#include <utility>
+
+class ScriptingSystem;
+
+// Just stores path. The ScriptingSystem running it caches the id of the
+// compiled script here, so a frame compares ids instead of paths; the path
+// is only changed through setScriptPath(), which drops the id.
+class LuaScriptComponent : public Component {
+public:
+  const std::string &getScriptPath() const { return scriptPath; }
+  void setScriptPath(std::string path) {
+    scriptPath = std::move(path);
+    owner = 0;
+  }
+
+private:
+  friend class ScriptingSystem;
 
-// Just stores path
-struct LuaScriptComponent : Component {
   std::string scriptPath;
+  // Serial of the ScriptingSystem scriptId belongs to, 0 for none
+  std::uint32_t owner = 0;
+  std::uint32_t scriptId = 0;
 };
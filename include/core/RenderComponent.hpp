@@ -1,7 +1,12 @@
 #pragma once
 
 #include "Component.hpp"
+#include <algorithm>
 #include <array>
+#include <cmath>
+#include <chrono>
+#include <cstdint>
+#include <future>
 #include <glm/glm.hpp>
 #include <iostream>
 #include <memory>
@@ -9,11 +14,21 @@
 #include <vector>
 
 struct Model {
-  std::vector<float> positions;
-  std::vector<float> normals;
-  std::vector<float> texcoords;
+  // Interleaved per vertex: position (3), normal (3), texcoord (2) floats,
+  // the layout the GPU buffer uses
+  static constexpr std::size_t VERTEX_FLOATS = 8;
+  static constexpr std::size_t NORMAL_OFFSET = 3;
+  static constexpr std::size_t TEXCOORD_OFFSET = 6;
+
+  std::vector<float> vertices;
   std::vector<unsigned int> indices;
 
+  std::size_t vertexCount() const { return vertices.size() / VERTEX_FLOATS; }
+  glm::vec3 position(std::size_t i) const {
+    const float *v = &vertices[i * VERTEX_FLOATS];
+    return glm::vec3(v[0], v[1], v[2]);
+  }
+
   struct MaterialInfo {
     std::string name;
     std::string diffuse_texname;
@@ -27,13 +42,134 @@ struct Model {
   };
   std::vector<MaterialInfo> materials;
 
+  // Object-space bounds of positions, filled by computeBounds()
+  glm::vec3 boundsMin = glm::vec3(0.0f);
+  glm::vec3 boundsMax = glm::vec3(0.0f);
+  glm::vec3 boundsCenter = glm::vec3(0.0f); // AABB center
+  float boundsRadius = 0.0f; // sphere around boundsCenter
+
+  void computeBounds() {
+    std::size_t vertCount = vertexCount();
+    if (vertCount == 0) {
+      boundsMin = boundsMax = boundsCenter = glm::vec3(0.0f);
+      boundsRadius = 0.0f;
+      return;
+    }
+    boundsMin = boundsMax = position(0);
+    for (std::size_t i = 1; i < vertCount; ++i) {
+      glm::vec3 p = position(i);
+      boundsMin = glm::min(boundsMin, p);
+      boundsMax = glm::max(boundsMax, p);
+    }
+    boundsCenter = (boundsMin + boundsMax) * 0.5f;
+    float radius2 = 0.0f;
+    for (std::size_t i = 0; i < vertCount; ++i) {
+      glm::vec3 d = position(i) - boundsCenter;
+      radius2 = std::max(radius2, glm::dot(d, d));
+    }
+    boundsRadius = std::sqrt(radius2);
+  }
+
+  // Levels of detail, ranges of indices over the same vertices. lods[0] is
+  // the full mesh; error is the deviation from it relative to boundsRadius.
+  // Without lods the whole index array is the only level.
+  struct Lod {
+    std::uint32_t indexOffset = 0;
+    std::uint32_t indexCount = 0;
+    float error = 0.0f;
+
+    bool operator==(const Lod &) const = default;
+  };
+  std::vector<Lod> lods;
+  // Levels a render sort key can tell apart
+  static constexpr std::size_t MAX_LODS = 8;
+  // Defaults of selectLod(): allowed error on screen, and how far below it
+  // a coarser level has to be before switching to it
+  static constexpr float LOD_PIXEL_ERROR = 1.0f;
+  static constexpr float LOD_HYSTERESIS = 0.25f;
+
+  std::size_t lodCount() const { return lods.empty() ? 1 : lods.size(); }
+  Lod lod(std::size_t level) const {
+    if (lods.empty())
+      return {0, static_cast<std::uint32_t>(indices.size()), 0.0f};
+    return lods[level];
+  }
+
+  // Coarsest level whose error stays within maxPixelError when the bounding
+  // sphere covers pixelRadius pixels. Starting from current, so a coarser
+  // level has to beat the limit by the hysteresis margin: entities near a
+  // switching distance don't flicker between two levels.
+  std::uint32_t selectLod(float pixelRadius, std::uint32_t current,
+                          float maxPixelError = LOD_PIXEL_ERROR,
+                          float hysteresis = LOD_HYSTERESIS) const {
+    std::size_t level = std::min<std::size_t>(current, lodCount() - 1);
+    while (level > 0 && lod(level).error * pixelRadius > maxPixelError)
+      --level;
+    while (level + 1 < lodCount() && lod(level + 1).error * pixelRadius <=
+                                         maxPixelError * (1.0f - hysteresis))
+      ++level;
+    return static_cast<std::uint32_t>(level);
+  }
+
+  // Small id for render sort keys, assigned by ResourceManager
+  std::uint32_t sortId = 0;
+
   unsigned int VAO = 0;
   unsigned int VBO = 0;
   unsigned int EBO = 0;
   bool uploadedToGPU = false;
+  // Formats of the GPU buffers, chosen at upload
+  bool compactVertices = false; // CompactVertex, see math/VertexQuantization
+  bool shortIndices = false;    // 16-bit indices
+  // Size of the vertex and index buffers, set at upload
+  std::size_t gpuBytes = 0;
+  // vertices and indices were freed after upload, see releaseCpuData()
+  bool cpuDataReleased = false;
+
+  // Heap memory held on the CPU side
+  std::size_t cpuBytes() const {
+    std::size_t bytes = vertices.capacity() * sizeof(float) +
+                        indices.capacity() * sizeof(unsigned int) +
+                        lods.capacity() * sizeof(Lod) +
+                        materials.capacity() * sizeof(MaterialInfo);
+    for (const MaterialInfo &m : materials)
+      bytes += m.name.capacity() + m.diffuse_texname.capacity() +
+               m.ambient_texname.capacity() + m.specular_texname.capacity();
+    return bytes;
+  }
+
+  // Frees vertices and indices once they live in the GPU buffers. Bounds
+  // and lods stay, so culling and LOD selection still work; the whole
+  // index range becomes the only level if there were no lods.
+  void releaseCpuData() {
+    if (lods.empty())
+      lods.push_back({0, static_cast<std::uint32_t>(indices.size()), 0.0f});
+    std::vector<float>().swap(vertices);
+    std::vector<unsigned int>().swap(indices);
+    cpuDataReleased = true;
+  }
 };
 
+// Result of ResourceManager::loadModelAsync
+using ModelFuture = std::shared_future<std::shared_ptr<Model>>;
+
 struct RenderComponent : Component {
   std::shared_ptr<Model> model;
   std::string modelPath; // for serialization
+  // Set while model is still loading, see resolveModel()
+  ModelFuture pendingModel;
+  // Level drawn last frame, RenderSystem picks the next one from it
+  std::uint32_t lod = 0;
+
+  // Moves a finished pendingModel into model, never blocks. True if model
+  // can be drawn.
+  bool resolveModel() {
+    if (pendingModel.valid() &&
+        pendingModel.wait_for(std::chrono::seconds(0)) ==
+            std::future_status::ready) {
+      model = pendingModel.get();
+      pendingModel = ModelFuture();
+    }
+    return model != nullptr;
+  }
 };
\ No newline at end of file
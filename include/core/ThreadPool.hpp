@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool.
+// Every worker owns a deque: it pushes and pops its own tasks at the back and
+// steals from the front of the others' when empty. Tasks submitted from
+// outside the pool are spread round-robin.
+class ThreadPool {
+public:
+  using Task = std::function<void()>;
+
+  // 0 = hardware_concurrency() - 1, the submitting thread is expected to
+  // help (see TaskGroup::wait)
+  explicit ThreadPool(std::size_t workerCount = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void submit(Task task);
+
+  // Runs one queued task on the calling thread, returns false if none
+  bool runPendingTask();
+
+  std::size_t getWorkerCount() const { return workers.size(); }
+
+private:
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  std::vector<std::thread> workers;
+  std::vector<std::unique_ptr<Queue>> queues;
+
+  std::mutex sleepMutex;
+  std::condition_variable wakeUp;
+  std::atomic<std::size_t> queuedTasks{0};
+  std::atomic<std::size_t> nextQueue{0};
+  bool stopping = false;
+
+  void workerLoop(std::size_t index);
+  bool popTask(std::size_t preferred, Task &out);
+};
+
+// Set of tasks that can be waited for. The waiting thread executes queued
+// tasks meanwhile, so waiting from inside a pool task doesn't deadlock.
+class TaskGroup {
+public:
+  explicit TaskGroup(ThreadPool *pool) : pool(pool) {}
+  ~TaskGroup() { wait(); }
+
+  // Without a pool (or workers) the task runs inline
+  void run(ThreadPool::Task task);
+  void wait();
+
+private:
+  ThreadPool *pool;
+  std::atomic<std::size_t> pending{0};
+};
@@ -1,12 +1,20 @@
 #pragma once
 
 #include "Component.hpp"
+#include "Entity.hpp"
 #include <array>
 
 // std::array<float,3> for simplisity.
+// position/rotation/scale are relative to parent. Whoever changes them calls
+// World::markDirty(), so TransformSystem recomputes only what moved.
 struct TransformComponent : Component {
   std::array<float, 3> position{0.0f, 0.0f, 0.0f};
   std::array<float, 3> rotation{0.0f, 0.0f,
                                 0.0f}; // rotation around X, Y, Z in deg
   std::array<float, 3> scale{1.0f, 1.0f, 1.0f};
-};
\ No newline at end of file
+
+  // INVALID_ENTITY for roots, change through World::setParent()
+  Entity parent = INVALID_ENTITY;
+  // Set while the World's transform change log holds the entity
+  bool dirty = true;
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Archetype.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+// Contiguous run of rows of one archetype
+template <typename... Ts> struct Chunk {
+  const Entity *entities;
+  std::tuple<Ts *...> columns;
+  std::size_t size;
+  // Index of the first row among all entities of the view, in iteration order
+  std::size_t offset;
+
+  template <typename T> T *get() const { return std::get<T *>(columns); }
+};
+
+// Default chunk footprint for parallel iteration, sized to stay in L2
+constexpr std::size_t PARALLEL_CHUNK_BYTES = 64 * 1024;
+
+// Iterates entities having all of Ts. Only archetypes containing the rarest
+// of Ts are visited (see World::view), and rows inside an archetype always
+// match, so entities without the components are never touched.
+// Adding components of a new type during iteration invalidates the view.
+template <typename... Ts> class View {
+  static_assert(sizeof...(Ts) > 0, "View needs at least one component type");
+
+public:
+  View(std::vector<Archetype> &archetypes,
+       const std::vector<std::uint32_t> &candidates)
+      : archetypes(&archetypes), candidates(&candidates) {}
+
+  // f(Entity, Ts &...)
+  template <typename F> void each(F &&f) const {
+    for (std::uint32_t index : *candidates) {
+      Archetype &arch = (*archetypes)[index];
+      if ((arch.mask & mask) != mask)
+        continue;
+      std::tuple<Ts *...> cols{
+          arch.column<std::remove_const_t<Ts>>().data()...};
+      const std::size_t count = arch.size();
+      for (std::size_t row = 0; row < count; ++row)
+        f(arch.entities[row], std::get<Ts *>(cols)[row]...);
+    }
+  }
+
+  // f(const Chunk<Ts...> &), archetypes are split into runs of at most
+  // maxRows rows
+  template <typename F>
+  void eachChunk(F &&f, std::size_t maxRows = SIZE_MAX) const {
+    std::size_t offset = 0;
+    for (std::uint32_t index : *candidates) {
+      Archetype &arch = (*archetypes)[index];
+      if ((arch.mask & mask) != mask)
+        continue;
+      const std::size_t count = arch.size();
+      for (std::size_t begin = 0; begin < count; begin += maxRows) {
+        std::size_t n = std::min(maxRows, count - begin);
+        Chunk<Ts...> chunk{
+            arch.entities.data() + begin,
+            {arch.column<std::remove_const_t<Ts>>().data() + begin...},
+            n,
+            offset + begin};
+        f(chunk);
+      }
+      offset += count;
+    }
+  }
+
+  // Like eachChunk, but chunks are distributed over the pool. Returns after
+  // all of them are processed; f must be safe to call concurrently.
+  template <typename F>
+  void parallelEachChunk(ThreadPool *pool, F &&f,
+                         std::size_t chunkBytes = PARALLEL_CHUNK_BYTES) const {
+    TaskGroup group(pool);
+    eachChunk(
+        [&](const Chunk<Ts...> &chunk) {
+          group.run([&f, chunk] { f(chunk); });
+        },
+        rowsPerChunk(chunkBytes));
+    group.wait();
+  }
+
+  // f(Entity, Ts &...) called concurrently from the pool's threads
+  template <typename F>
+  void parallelEach(ThreadPool *pool, F &&f,
+                    std::size_t chunkBytes = PARALLEL_CHUNK_BYTES) const {
+    parallelEachChunk(
+        pool,
+        [&f](const Chunk<Ts...> &chunk) {
+          for (std::size_t row = 0; row < chunk.size; ++row)
+            f(chunk.entities[row], chunk.template get<Ts>()[row]...);
+        },
+        chunkBytes);
+  }
+
+  // Number of matching entities
+  std::size_t size() const {
+    std::size_t n = 0;
+    for (std::uint32_t index : *candidates) {
+      const Archetype &arch = (*archetypes)[index];
+      if ((arch.mask & mask) == mask)
+        n += arch.size();
+    }
+    return n;
+  }
+
+private:
+  static constexpr ComponentMask mask = componentMask<Ts...>();
+
+  static std::size_t rowsPerChunk(std::size_t chunkBytes) {
+    constexpr std::size_t rowBytes = sizeof(Entity) + (sizeof(Ts) + ...);
+    return std::max<std::size_t>(chunkBytes / rowBytes, 64);
+  }
+
+  std::vector<Archetype> *archetypes;
+  const std::vector<std::uint32_t> *candidates;
+};
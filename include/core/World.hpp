@@ -1,106 +1,410 @@
 #pragma once
 
+#include "Archetype.hpp"
 #include "Entity.hpp"
 #include "LuaScriptComponent.hpp"
 #include "RenderComponent.hpp"
 #include "TransformComponent.hpp"
+#include "View.hpp"
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 
 // Manages Entities and Components
-// Separate std::unordered_map<Entity, ComponentType> for every component type
-// TODO: deletion
+// Entities with the same set of components share an Archetype, whose
+// components are packed into one contiguous column per type. Adding a
+// component of a new type moves the entity into another archetype.
+// Pointers returned by get*() stay valid until the next createEntities(),
+// addComponent() of a type the entity didn't have yet, destroyEntity() or
+// clear() (anywhere in the World).
+// Slots of destroyed entities are recycled, stale handles are rejected by
+// comparing their generation with the slot's one. Free slots are reused
+// oldest first and only once MIN_FREE_SLOTS others are free, so a slot's
+// generation advances slowly; a slot whose generation wraps is retired.
+// Once a TransformSystem enables it, entities whose TransformComponent was
+// added, replaced, reparented, marked dirty or destroyed are logged for it;
+// likewise destroyed entities with a LuaScriptComponent for ScriptingSystem.
 class World {
 public:
-  World() = default;
+  static constexpr std::size_t MIN_FREE_SLOTS = 1024;
+
+  World() { clear(); }
 
   Entity createEntity() {
-    Entity id = nextEntityId++;
+    std::uint32_t index = allocateSlot();
+    if (index == 0) {
+      std::cerr << "World: entity limit reached" << std::endl;
+      return INVALID_ENTITY;
+    }
+    EntityRecord &rec = records[index];
+    Entity id = makeEntity(index, rec.generation);
+    Archetype &empty = archetypes[0];
+    rec.archetype = 0;
+    rec.row = static_cast<std::uint32_t>(empty.size());
+    rec.dense = static_cast<std::uint32_t>(entities.size());
+    rec.alive = true;
+    empty.entities.push_back(id);
     entities.push_back(id);
     return id;
   }
 
+  // Creates count entities having exactly the components of mask, all
+  // default-constructed, as new rows at the end of one archetype. Handles are
+  // appended to out. Returns the archetype, whose last count rows the caller
+  // fills column by column, or nullptr if the entity limit would be exceeded.
+  Archetype *createEntities(ComponentMask mask, std::size_t count,
+                            std::vector<Entity> &out) {
+    std::size_t available = freeSlots.size() + ENTITY_INDEX_MASK -
+                            std::min<std::size_t>(slotCount(),
+                                                  ENTITY_INDEX_MASK);
+    if (count > available) {
+      std::cerr << "World: entity limit reached" << std::endl;
+      return nullptr;
+    }
+    std::uint32_t archIndex = findOrCreateArchetype(mask);
+    Archetype &arch = archetypes[archIndex];
+    const std::size_t firstRow = arch.size();
+    forEachComponentType([&](auto tag) {
+      using T = typename decltype(tag)::type;
+      if (arch.has<T>()) {
+        arch.column<T>().resize(firstRow + count);
+        componentCounts[componentId<T>()] += count;
+      }
+    });
+    arch.entities.reserve(firstRow + count);
+    entities.reserve(entities.size() + count);
+    out.reserve(out.size() + count);
+    for (std::size_t i = 0; i < count; ++i) {
+      std::uint32_t index = allocateSlot();
+      EntityRecord &rec = records[index];
+      Entity id = makeEntity(index, rec.generation);
+      rec.archetype = archIndex;
+      rec.row = static_cast<std::uint32_t>(firstRow + i);
+      rec.dense = static_cast<std::uint32_t>(entities.size());
+      rec.alive = true;
+      arch.entities.push_back(id);
+      entities.push_back(id);
+      out.push_back(id);
+      if (arch.has<TransformComponent>())
+        transformChanges.log(id); // new components start dirty
+    }
+    ++structureVersion;
+    return &arch;
+  }
+
+  // Removes the entity with all its components. Returns false for stale or
+  // invalid handles.
+  bool destroyEntity(Entity e) {
+    if (!isValid(e))
+      return false;
+    EntityRecord &rec = records[entityIndex(e)];
+    Archetype &arch = archetypes[rec.archetype];
+    if (arch.has<TransformComponent>() &&
+        !arch.column<TransformComponent>()[rec.row].dirty)
+      transformChanges.log(e);
+    if (arch.has<LuaScriptComponent>())
+      scriptRemovals.log(e);
+    for (std::size_t id = 0; id < COMPONENT_TYPE_COUNT; ++id)
+      if (arch.mask & (ComponentMask(1) << id))
+        --componentCounts[id];
+    Entity moved = arch.removeRow(rec.row);
+    if (moved != INVALID_ENTITY)
+      records[entityIndex(moved)].row = rec.row;
+
+    Entity last = entities.back();
+    entities[rec.dense] = last;
+    records[entityIndex(last)].dense = rec.dense;
+    entities.pop_back();
+
+    ++structureVersion;
+    releaseSlot(entityIndex(e));
+    return true;
+  }
+
+  bool isAlive(Entity e) const { return isValid(e); }
+
+  // Alive entities, in no particular order
   const std::vector<Entity> &getEntities() const { return entities; }
 
-  void addComponent(Entity e, const TransformComponent &comp) {
-    transforms[e] = comp;
+  // Sets component, replacing the existing one of the same type
+  template <typename T> void addComponent(Entity e, const T &comp) {
+    if (!isValid(e))
+      return;
+    EntityRecord &rec = records[entityIndex(e)];
+    if (archetypes[rec.archetype].has<T>()) {
+      T &existing = archetypes[rec.archetype].column<T>()[rec.row];
+      if constexpr (std::is_same_v<T, TransformComponent>) {
+        const bool logged = existing.dirty;
+        existing = comp;
+        existing.dirty = true;
+        if (!logged)
+          transformChanges.log(e);
+      } else {
+        existing = comp;
+      }
+      return;
+    }
+    // May grow archetypes, so no references are taken before this
+    std::uint32_t dstIndex = findOrCreateArchetype(
+        archetypes[rec.archetype].mask | componentBit<T>());
+    Archetype &src = archetypes[rec.archetype];
+    Archetype &dst = archetypes[dstIndex];
+    dst.column<T>().push_back(comp);
+    ++componentCounts[componentId<T>()];
+    Entity moved = src.moveRow(rec.row, dst);
+    if (moved != INVALID_ENTITY)
+      records[entityIndex(moved)].row = rec.row;
+    rec.archetype = dstIndex;
+    rec.row = static_cast<std::uint32_t>(dst.size() - 1);
+    ++structureVersion;
+    if constexpr (std::is_same_v<T, TransformComponent>) {
+      dst.column<T>().back().dirty = true;
+      transformChanges.log(e);
+    }
+  }
+
+  // Attaches child's transform to parent's (INVALID_ENTITY detaches). Both
+  // need a TransformComponent; fails if it would create a cycle.
+  bool setParent(Entity child, Entity parent) {
+    TransformComponent *tc = getTransform(child);
+    if (!tc)
+      return false;
+    if (parent != INVALID_ENTITY) {
+      if (!hasTransform(parent))
+        return false;
+      // Refuse cycles; destroyed ancestors end the chain
+      for (Entity p = parent; p != INVALID_ENTITY;) {
+        if (p == child)
+          return false;
+        const TransformComponent *ptc = getTransform(p);
+        p = ptc ? ptc->parent : INVALID_ENTITY;
+      }
+    }
+    tc->parent = parent;
+    markDirty(child, *tc);
+    return true;
   }
-  void addComponent(Entity e, const RenderComponent &comp) {
-    renders[e] = comp;
+
+  // For code changing position, rotation or scale of e's transform tc in
+  // place: sets dirty, logging e the first time since the last update
+  void markDirty(Entity e, TransformComponent &tc) {
+    if (tc.dirty)
+      return;
+    tc.dirty = true;
+    transformChanges.log(e);
   }
-  void addComponent(Entity e, const LuaScriptComponent &comp) {
-    scripts[e] = comp;
+
+  // Starts the transform change log, for its one consumer
+  void trackTransformChanges() { transformChanges.tracking = true; }
+
+  // Moves the entities logged since the last call into out, possibly
+  // repeated and including destroyed ones. Returns true if the World was
+  // cleared in between, which drops everything logged before.
+  bool takeTransformChanges(std::vector<Entity> &out) {
+    return transformChanges.take(out);
   }
 
-  bool hasTransform(Entity e) const {
-    return transforms.find(e) != transforms.end();
+  // The same for destroyed entities that had a LuaScriptComponent
+  void trackScriptRemovals() { scriptRemovals.tracking = true; }
+  bool takeScriptRemovals(std::vector<Entity> &out) {
+    return scriptRemovals.take(out);
   }
-  bool hasRender(Entity e) const { return renders.find(e) != renders.end(); }
-  bool hasScript(Entity e) const { return scripts.find(e) != scripts.end(); }
 
-  TransformComponent *getTransform(Entity e) {
-    auto it = transforms.find(e);
-    if (it != transforms.end())
-      return &it->second;
-    return nullptr;
+  // Bumped on every change of archetype layout (entities created, destroyed
+  // or moved to another archetype), lets systems know when cached pointers
+  // need a rebuild
+  std::uint64_t getStructureVersion() const { return structureVersion; }
+
+  template <typename T> bool has(Entity e) const {
+    return isValid(e) &&
+           archetypes[records[entityIndex(e)].archetype].has<T>();
+  }
+
+  template <typename T> T *get(Entity e) {
+    if (!has<T>(e))
+      return nullptr;
+    const EntityRecord &rec = records[entityIndex(e)];
+    return &archetypes[rec.archetype].column<T>()[rec.row];
+  }
+  template <typename T> const T *get(Entity e) const {
+    if (!has<T>(e))
+      return nullptr;
+    const EntityRecord &rec = records[entityIndex(e)];
+    return &archetypes[rec.archetype].column<T>()[rec.row];
   }
-  RenderComponent *getRender(Entity e) {
-    auto it = renders.find(e);
-    if (it != renders.end())
-      return &it->second;
-    return nullptr;
+
+  bool hasTransform(Entity e) const { return has<TransformComponent>(e); }
+  bool hasRender(Entity e) const { return has<RenderComponent>(e); }
+  bool hasScript(Entity e) const { return has<LuaScriptComponent>(e); }
+
+  TransformComponent *getTransform(Entity e) {
+    return get<TransformComponent>(e);
   }
+  RenderComponent *getRender(Entity e) { return get<RenderComponent>(e); }
   LuaScriptComponent *getScript(Entity e) {
-    auto it = scripts.find(e);
-    if (it != scripts.end())
-      return &it->second;
-    return nullptr;
+    return get<LuaScriptComponent>(e);
   }
   const TransformComponent *getTransform(Entity e) const {
-    auto it = transforms.find(e);
-    if (it != transforms.end())
-      return &it->second;
-    return nullptr;
+    return get<TransformComponent>(e);
   }
   const RenderComponent *getRender(Entity e) const {
-    auto it = renders.find(e);
-    if (it != renders.end())
-      return &it->second;
-    return nullptr;
+    return get<RenderComponent>(e);
   }
   const LuaScriptComponent *getScript(Entity e) const {
-    auto it = scripts.find(e);
-    if (it != scripts.end())
-      return &it->second;
-    return nullptr;
+    return get<LuaScriptComponent>(e);
   }
 
-  // For serialization
-  const std::unordered_map<Entity, TransformComponent> &
-  getAllTransforms() const {
-    return transforms;
+  // Entities having all of Ts, e.g.
+  //   world.view<TransformComponent, RenderComponent>().each(
+  //       [](Entity e, TransformComponent &tc, RenderComponent &rc) {...});
+  // Walks only archetypes containing the least common of Ts.
+  template <typename... Ts> View<Ts...> view() {
+    std::size_t pivot = 0;
+    std::size_t best = SIZE_MAX;
+    for (std::size_t id : {componentId<Ts>()...}) {
+      if (componentCounts[id] < best) {
+        best = componentCounts[id];
+        pivot = id;
+      }
+    }
+    return View<Ts...>(archetypes, archetypesWith[pivot]);
   }
-  const std::unordered_map<Entity, RenderComponent> &getAllRenders() const {
-    return renders;
+
+  // Calls f(Entity, Ts &...) for every matching entity, chunks of
+  // PARALLEL_CHUNK_BYTES are spread over the pool (runs inline without one).
+  // No structural changes are allowed from f.
+  template <typename... Ts, typename F>
+  void parallelForEach(ThreadPool *pool, F &&f) {
+    view<Ts...>().parallelEach(pool, std::forward<F>(f));
   }
-  const std::unordered_map<Entity, LuaScriptComponent> &getAllScripts() const {
-    return scripts;
+
+  // Number of entities having component T
+  template <typename T> std::size_t count() const {
+    return componentCounts[componentId<T>()];
   }
 
+  // Number of entity slots ever allocated (alive + free)
+  std::size_t slotCount() const { return records.size() - 1; }
+
+  // Raw storage, for systems that walk columns directly
+  const std::vector<Archetype> &getArchetypes() const { return archetypes; }
+  std::vector<Archetype> &getArchetypes() { return archetypes; }
+
+  // Destroys every entity; their handles stay stale as after destroyEntity()
   void clear() {
+    if (records.empty())
+      records.assign(1, {}); // INVALID_ENTITY's placeholder
+    for (Entity e : entities)
+      releaseSlot(entityIndex(e));
     entities.clear();
-    transforms.clear();
-    renders.clear();
-    scripts.clear();
-    nextEntityId = 1;
+    archetypes.clear();
+    archetypeByMask.clear();
+    for (auto &list : archetypesWith)
+      list.clear();
+    componentCounts.fill(0);
+    // Archetype 0 holds entities without components
+    archetypes.emplace_back();
+    archetypeByMask[0] = 0;
+    ++structureVersion;
+    transformChanges.clear();
+    scriptRemovals.clear();
   }
 
 private:
-  Entity nextEntityId = 1;
+  struct EntityRecord {
+    std::uint32_t archetype = 0;
+    std::uint32_t row = 0;
+    std::uint32_t dense = 0; // position in entities
+    std::uint32_t generation = 0;
+    bool alive = false;
+  };
+
   std::vector<Entity> entities;
+  std::uint64_t structureVersion = 0;
+
+  std::vector<EntityRecord> records; // indexed by entityIndex()
+  std::deque<std::uint32_t> freeSlots; // oldest first
+  std::vector<Archetype> archetypes;
+  std::unordered_map<ComponentMask, std::uint32_t> archetypeByMask;
+  // Per component id: archetypes containing it and number of components
+  std::array<std::vector<std::uint32_t>, COMPONENT_TYPE_COUNT> archetypesWith;
+  std::array<std::size_t, COMPONENT_TYPE_COUNT> componentCounts{};
 
-  std::unordered_map<Entity, TransformComponent> transforms;
-  std::unordered_map<Entity, RenderComponent> renders;
-  std::unordered_map<Entity, LuaScriptComponent> scripts;
-};
\ No newline at end of file
+  // Entities logged for one consumer, once it starts tracking
+  struct ChangeLog {
+    bool tracking = false;
+    bool cleared = false;
+    std::vector<Entity> entities;
+
+    void log(Entity e) {
+      if (tracking)
+        entities.push_back(e);
+    }
+    bool take(std::vector<Entity> &out) {
+      out.clear();
+      out.swap(entities);
+      const bool wasCleared = cleared;
+      cleared = false;
+      return wasCleared;
+    }
+    void clear() {
+      entities.clear();
+      cleared = true;
+    }
+  };
+  // A dirty TransformComponent is already in transformChanges
+  ChangeLog transformChanges;
+  ChangeLog scriptRemovals;
+
+  // Frees the slot of a destroyed entity, bumping its generation
+  void releaseSlot(std::uint32_t index) {
+    EntityRecord &rec = records[index];
+    rec.alive = false;
+    rec.generation = (rec.generation + 1) & ENTITY_GENERATION_MASK;
+    // A wrapped generation would match old handles again: retire the slot
+    if (rec.generation != 0)
+      freeSlots.push_back(index);
+  }
+
+  // A free slot if MIN_FREE_SLOTS others wait behind it (or no new one is
+  // left), else a new one. 0 if the entity limit is reached.
+  std::uint32_t allocateSlot() {
+    const bool canGrow = records.size() <= ENTITY_INDEX_MASK;
+    if (!freeSlots.empty() &&
+        (freeSlots.size() > MIN_FREE_SLOTS || !canGrow)) {
+      std::uint32_t index = freeSlots.front();
+      freeSlots.pop_front();
+      return index;
+    }
+    if (!canGrow)
+      return 0;
+    records.push_back({});
+    return static_cast<std::uint32_t>(records.size() - 1);
+  }
+
+  bool isValid(Entity e) const {
+    std::uint32_t index = entityIndex(e);
+    if (index == 0 || index >= records.size())
+      return false;
+    const EntityRecord &rec = records[index];
+    return rec.alive && rec.generation == entityGeneration(e);
+  }
+
+  std::uint32_t findOrCreateArchetype(ComponentMask mask) {
+    auto it = archetypeByMask.find(mask);
+    if (it != archetypeByMask.end())
+      return it->second;
+    std::uint32_t index = static_cast<std::uint32_t>(archetypes.size());
+    archetypes.emplace_back().mask = mask;
+    archetypeByMask[mask] = index;
+    for (std::size_t id = 0; id < COMPONENT_TYPE_COUNT; ++id)
+      if (mask & (ComponentMask(1) << id))
+        archetypesWith[id].push_back(index);
+    return index;
+  }
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "TransformBatch.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// View frustum culling of bounding spheres. No GL dependency, so it can be
+// driven headlessly (see bench/CullingBench.cpp).
+
+// Planes as (normal, d) with normals pointing inwards and unit length:
+// a point p is inside a plane when dot(normal, p) + d >= 0.
+struct Frustum {
+  glm::vec4 planes[6]; // left, right, bottom, top, near, far
+};
+
+// Gribb-Hartmann plane extraction from projection * view
+Frustum extractFrustum(const glm::mat4 &viewProjection);
+
+// World-space spheres, one array per coordinate so four spheres can be
+// tested per SSE instruction
+struct SphereSoA {
+  std::vector<float> x, y, z, radius;
+
+  void clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+    radius.clear();
+  }
+  void push(const glm::vec3 &center, float r) {
+    x.push_back(center.x);
+    y.push_back(center.y);
+    z.push_back(center.z);
+    radius.push_back(r);
+  }
+  std::size_t size() const { return x.size(); }
+};
+
+// Object-space sphere moved to world space; radius grows by the largest
+// axis scale of the matrix
+void transformSphere(const glm::mat4 &model, const glm::vec3 &center,
+                     float radius, glm::vec3 &outCenter, float &outRadius);
+
+// visible[i] = 1 if sphere i intersects the frustum, else 0.
+// Returns the number of visible spheres.
+std::size_t cullSpheres(const Frustum &frustum, const SphereSoA &spheres,
+                        std::uint8_t *visible);
+
+// Forces a code path (AVX2 uses the SSE2 one)
+std::size_t cullSpheres(SimdLevel level, const Frustum &frustum,
+                        const SphereSoA &spheres, std::uint8_t *visible);
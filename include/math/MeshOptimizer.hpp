@@ -0,0 +1,59 @@
+#pragma once
+
+#include "core/RenderComponent.hpp"
+#include <cstddef>
+#include <vector>
+
+// Import-time reordering of triangle lists for the GPU, no GL dependency.
+// The vertex cache pass is Tipsify (Sander, Nehab, Barczak 2007): it fans
+// around a vertex that is still in a simulated FIFO cache and falls back to
+// recently used vertices at dead ends. The dead ends split the result into
+// clusters that the overdraw pass sorts to draw outward-facing, outer
+// clusters first. The fetch pass renumbers vertices in order of first use.
+// All passes keep each triangle's winding.
+
+// FIFO size the passes and analyzeVertexCache() assume, between what current
+// GPUs effectively get per batch
+constexpr unsigned VERTEX_CACHE_SIZE = 16;
+
+struct VertexCacheStats {
+  // Cache misses per triangle: 3 worst, 0.5 the limit for large meshes
+  float acmr = 0.0f;
+  // Cache misses per vertex: 1 ideal, each vertex is transformed once
+  float atvr = 0.0f;
+};
+
+// Counts post-transform cache misses of indices on a FIFO of cacheSize
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices,
+                                    std::size_t vertexCount,
+                                    unsigned cacheSize = VERTEX_CACHE_SIZE);
+
+// Returns indices with triangles reordered by Tipsify. clusterStarts, if
+// given, receives the first index of each cluster, starting with 0.
+std::vector<unsigned int>
+optimizeVertexCache(const std::vector<unsigned int> &indices,
+                    std::size_t vertexCount,
+                    unsigned cacheSize = VERTEX_CACHE_SIZE,
+                    std::vector<std::size_t> *clusterStarts = nullptr);
+
+// Reorders the clusters of model.indices (as from optimizeVertexCache) by
+// dot(cluster normal, cluster center - mesh center), largest first. Keeps
+// the old order if that raises the ACMR by more than threshold times.
+void optimizeOverdraw(Model &model,
+                      const std::vector<std::size_t> &clusterStarts,
+                      float threshold = 1.05f);
+
+// Renumbers vertices in order of first use in indices and drops unused
+// ones, so the vertex fetch walks the buffer forward
+void optimizeVertexFetch(Model &model);
+
+struct MeshOptimizeStats {
+  VertexCacheStats before;
+  VertexCacheStats after;
+  std::size_t clusters = 0; // 0 if the triangle order was kept
+};
+
+// All three passes on model. The triangle order is kept if Tipsify does not
+// lower its ACMR, as for meshes already exported cache-friendly. Bounds
+// are left alone.
+MeshOptimizeStats optimizeMesh(Model &model);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "core/RenderComponent.hpp"
+#include <cstddef>
+#include <vector>
+
+// Mesh simplification by quadric error metric edge collapse (Garland,
+// Heckbert 1997), no GL dependency. Vertices only collapse onto one of
+// their neighbours, so every level reuses the model's vertex buffer and a
+// level is just another index range. Vertices on open borders and on
+// attribute seams (one position, several normals or texcoords) stay put,
+// which keeps outlines and UV charts intact.
+
+// Returns indices (a triangle list over model's vertices, usually
+// model.indices) with edges collapsed in order of increasing error until
+// at most targetIndexCount indices remain or the next collapse would
+// deviate more than maxError * model.boundsRadius from the input surface.
+// error, if given, receives the deviation reached, also relative to
+// boundsRadius.
+std::vector<unsigned int> simplifyMesh(const Model &model,
+                                       const std::vector<unsigned int> &indices,
+                                       std::size_t targetIndexCount,
+                                       float maxError, float *error = nullptr);
+
+// Largest deviation generateLods() accepts for a level, relative to
+// boundsRadius
+constexpr float MAX_LOD_ERROR = 0.05f;
+
+// Replaces model.lods with a chain that halves the triangle count per
+// level, simplified from the full mesh each time and reordered for the
+// vertex cache. Levels are appended to model.indices after the full mesh,
+// which must fill it. Stops at Model::MAX_LODS, at MAX_LOD_ERROR or when a
+// level saves less than a tenth of the triangles.
+void generateLods(Model &model);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "../core/TransformComponent.hpp"
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// Batched TransformComponent -> model matrix conversion.
+// Produces translate(position) * rotateX * rotateY * rotateZ * scale(scale)
+// (rotation in degrees), i.e. what the per-entity glm::translate/rotate/scale
+// chain builds, but writes the matrix directly from closed-form rotation
+// terms and evaluates sin/cos for 4 (SSE2) or 8 (AVX2) entities at once.
+
+enum class SimdLevel { Scalar, SSE2, AVX2 };
+
+// Best level supported by both the build and the running CPU
+SimdLevel detectSimdLevel();
+const char *simdLevelName(SimdLevel level);
+
+// Uses detectSimdLevel(), resolved once
+void composeModelMatrices(const TransformComponent *transforms,
+                          std::size_t count, glm::mat4 *out);
+
+// Forces a code path, falls back to the best available one not above level
+void composeModelMatrices(SimdLevel level,
+                          const TransformComponent *transforms,
+                          std::size_t count, glm::mat4 *out);
+
+// Per-ISA kernels, each in its own translation unit. The AVX2 one marks
+// its functions with a target attribute instead of building the TU with
+// -mavx2. They return the number of matrices written (a multiple of the
+// lane count), the caller finishes the tail.
+namespace transform_batch {
+bool hasSSE2Kernel();
+bool hasAVX2Kernel();
+std::size_t composeSSE2(const TransformComponent *transforms,
+                        std::size_t count, glm::mat4 *out);
+std::size_t composeAVX2(const TransformComponent *transforms,
+                        std::size_t count, glm::mat4 *out);
+} // namespace transform_batch
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "core/RenderComponent.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Compact GPU vertex format, 16 instead of 32 bytes per vertex. Positions
+// are unorm16 within the model bounds, normals octahedral-encoded into two
+// int16, texcoords half floats. The vertex shader undoes the position
+// mapping with the positionScale/positionOffset uniforms and decodes the
+// normal. Models stay float on the CPU, the encoding happens at upload.
+struct CompactVertex {
+  std::uint16_t position[4]; // xyz, w pads the normal to 4-byte alignment
+  std::int16_t normal[2];    // octahedral, -32767..32767
+  std::uint16_t texcoord[2]; // IEEE half
+};
+static_assert(sizeof(CompactVertex) == 16, "no padding expected");
+
+// position = quantized / 65535 * scale + offset
+struct PositionQuantization {
+  glm::vec3 offset = glm::vec3(0.0f);
+  glm::vec3 scale = glm::vec3(1.0f);
+};
+
+// Spans the model bounds (computeBounds() must have run). Flat axes get
+// scale 1, all their vertices encode as 0.
+PositionQuantization positionQuantization(const Model &model);
+
+// Round to nearest, values beyond the half range become infinity and
+// magnitudes below 2^-14 flush to zero. NaN stays NaN.
+std::uint16_t floatToHalf(float value);
+float halfToFloat(std::uint16_t half);
+
+// n need not be normalized, but must not be zero
+void encodeOctahedral(const glm::vec3 &n, std::int16_t out[2]);
+// Unit vector, as the fragment shader sees it after normalize()
+glm::vec3 decodeOctahedral(const std::int16_t in[2]);
+
+std::vector<CompactVertex> encodeCompactVertices(const Model &model);
+// Back to Model::vertices layout, as the vertex shader decodes it
+void decodeCompactVertex(const CompactVertex &vertex,
+                         const PositionQuantization &quantization,
+                         float out[Model::VERTEX_FLOATS]);
+
+// Without primitive restart every 16-bit value is a usable index
+constexpr std::size_t MAX_SHORT_INDEX_VERTICES = 65536;
+
+inline bool fitsShortIndices(std::size_t vertexCount) {
+  return vertexCount <= MAX_SHORT_INDEX_VERTICES;
+}
+
+// indices must all be below MAX_SHORT_INDEX_VERTICES
+std::vector<std::uint16_t> narrowIndices(const std::vector<unsigned int> &indices);
@@ -0,0 +1,20 @@
+#pragma once
+
+// Offscreen OpenGL 3.3 core context through EGL (Mesa surfaceless platform
+// when available, so no display or GPU is needed). Only available when
+// ECS_HAS_EGL is defined, see CMakeLists.txt.
+class HeadlessGL {
+public:
+  HeadlessGL() = default;
+  ~HeadlessGL();
+  HeadlessGL(const HeadlessGL &) = delete;
+  HeadlessGL &operator=(const HeadlessGL &) = delete;
+
+  // Creates the context, makes it current and loads GL functions
+  bool create(int width, int height);
+
+private:
+  void *display = nullptr;
+  void *surface = nullptr;
+  void *context = nullptr;
+};
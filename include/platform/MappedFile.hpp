@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Read-only view of a whole file. Uses mmap on POSIX systems, elsewhere the
+// file is read into memory once.
+class MappedFile {
+public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  // Maps path, replacing what was mapped before; prints to cerr on failure
+  bool open(const std::string &path);
+  void close();
+
+  const unsigned char *data() const { return bytes; }
+  std::size_t size() const { return length; }
+
+private:
+  const unsigned char *bytes = nullptr;
+  std::size_t length = 0;
+  bool mapped = false;
+  std::vector<unsigned char> fallback;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "ResourceManager.hpp"
+#include "core/World.hpp"
+#include <cstdint>
+#include <string>
+
+// Binary scene format, loaded by mapping the file and copying whole arrays
+// into archetype columns. JSON (Serialization.hpp) stays the interchange
+// format, convertScene() translates between the two.
+//
+// Layout (little-endian, every section 8-byte aligned):
+//   header     "ECSB", version, entity/group/string counts, string table
+//              offset, file size
+//   groups     {component mask, entity count, data offset} per archetype
+//   group data for each group, arrays of count elements:
+//              TransformComponent: float position[3], rotation[3], scale[3],
+//                                  uint32 parent (entity ordinal or ~0)
+//              RenderComponent:    uint32 model path (string index)
+//              LuaScriptComponent: uint32 script path (string index)
+//   strings    uint32 offsets[count + 1] into the characters that follow
+// Entities are numbered by their position in the file, group by group.
+// Bump BINARY_SCENE_VERSION on any layout change.
+constexpr std::uint32_t BINARY_SCENE_VERSION = 1;
+
+enum class SceneFormat { Json, Binary };
+
+// returns true if successfully saved
+bool saveSceneBinary(const World &world, const std::string &filename);
+
+// Appends the scene to world, returns true if successfully loaded
+bool loadSceneBinary(World &world, ResourceManager &resourceManager,
+                     const std::string &filename);
+// Same without loading models: RenderComponents only get their modelPath
+bool loadSceneBinary(World &world, const std::string &filename);
+
+// True if filename starts with the binary scene magic
+bool isBinaryScene(const std::string &filename);
+
+// Loads from (either format) and saves it to `to` as format
+bool convertScene(const std::string &from, const std::string &to,
+                  SceneFormat format);
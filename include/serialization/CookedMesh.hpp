@@ -0,0 +1,51 @@
+#pragma once
+
+#include "core/RenderComponent.hpp"
+#include <cstdint>
+#include <string>
+
+// Cooked meshes: a parsed Model saved in the layout the GPU upload uses, so
+// a later start maps the file and copies two arrays instead of parsing the
+// source again. Files live in a cache directory, one per source path, and
+// are only used while the source still has the same size, modification time
+// and content hash. Material libraries referenced by the source are not part
+// of the key; delete the cache after editing one.
+//
+// Layout (little-endian, every section 8-byte aligned):
+//   header     "ECSM", version, vertex/index/material/LOD counts, source
+//              size, mtime and hash, bounds, file size
+//   vertices   float[vertexCount * Model::VERTEX_FLOATS], interleaved
+//   indices    uint32[indexCount], all LODs
+//   LODs       uint32 index offset, uint32 index count, float error, pad
+//   materials  colors and shininess, then uint32 length + characters of
+//              name, diffuse, ambient and specular texture names
+// Bump COOKED_MESH_VERSION on any layout change or change of what
+// ResourceManager produces from a source (e.g. vertex order).
+constexpr std::uint32_t COOKED_MESH_VERSION = 3;
+
+// Identity of a source file, cooked data is valid for this one only
+struct MeshSourceKey {
+  std::uint64_t size = 0;
+  std::int64_t mtime = 0;
+  std::uint64_t hash = 0; // FNV-1a of the content
+
+  bool operator==(const MeshSourceKey &) const = default;
+};
+
+// Stats and hashes sourcePath, false if it can't be read
+bool readMeshSourceKey(const std::string &sourcePath, MeshSourceKey &out);
+
+// File in cacheDir holding the cooked sourcePath
+std::string cookedMeshPath(const std::string &cacheDir,
+                           const std::string &sourcePath);
+
+// Writes through a temporary file, so readers never see a partial one.
+// Creates the directory if needed. Returns true if successfully saved.
+bool saveCookedMesh(const Model &model, const MeshSourceKey &key,
+                    const std::string &filename);
+
+// Fills vertices, indices, LODs, materials and bounds of out. False if the
+// file is missing, was cooked from another source or another version, or
+// is corrupt; only corruption is reported.
+bool loadCookedMesh(const std::string &filename, const MeshSourceKey &key,
+                    Model &out);
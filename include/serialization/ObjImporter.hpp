@@ -0,0 +1,44 @@
+#pragma once
+
+#include "core/RenderComponent.hpp"
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// Wavefront OBJ import. importObj() maps the file, splits it into
+// line-aligned chunks parsed in parallel on the pool and merges them in file
+// order. It reads what ResourceManager uses: v, vt, vn, f (fan-triangulated,
+// negative indices relative to the preceding elements) and mtllib (Kd, Ka,
+// Ks, Ns, map_Kd, map_Ka, map_Ks of newmtl blocks). Other statements are
+// skipped. The Model matches the one built from tinyobjloader v1.0.6.
+
+// One corner of a triangle, 0-based, -1 for an absent texcoord or normal
+struct ObjIndex {
+  int vertex;
+  int texcoord;
+  int normal;
+
+  bool operator==(const ObjIndex &) const = default;
+};
+
+// File contents before vertex de-duplication
+struct ObjData {
+  std::vector<float> positions; // xyz
+  std::vector<float> texcoords; // uv
+  std::vector<float> normals;   // xyz
+  std::vector<ObjIndex> indices; // 3 per triangle
+  std::vector<Model::MaterialInfo> materials;
+};
+
+// Loads path into out, parsing on pool (inline without one). Prints the
+// reason to cerr and returns false on failure.
+bool importObj(const std::string &path, Model &out, ThreadPool *pool = nullptr);
+
+// The same through tinyobjloader, kept as a reference for ecs_bench
+bool importObjTinyobj(const std::string &path, Model &out);
+
+// Turns every distinct (vertex, texcoord, normal) corner into one Model
+// vertex in order of first use, computes smooth normals if the file has
+// none, and bounds. False if an index is out of range.
+bool buildModel(const ObjData &obj, Model &out);
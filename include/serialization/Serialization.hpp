@@ -7,6 +7,11 @@
 // returns true if successfully saved
 bool saveScene(const World &world, const std::string &filename);
 
-// returns true if successfully loaded
+// returns true if successfully loaded. Binary scenes (BinaryScene.hpp) are
+// recognized by their header and loaded from there. Models are requested
+// with loadModelAsync, RenderComponents may still have a pendingModel.
 bool loadScene(World &world, ResourceManager &resourceManager,
-               const std::string &filename);
\ No newline at end of file
+               const std::string &filename);
+// Same without loading models: RenderComponents only get their modelPath,
+// for tools that just read or convert scenes
+bool loadScene(World &world, const std::string &filename);
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "RenderQueue.hpp"
+#include "Shader.hpp"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// Per-frame shader inputs, std140 layout of the FrameData block in the
+// shaders (vec3 members padded to vec4)
+struct FrameData {
+  glm::mat4 view;
+  glm::mat4 projection;
+  glm::vec4 lightPos;
+  glm::vec4 lightColor;
+  glm::vec4 viewPos;
+};
+
+// OpenGL implementation of RenderBackend. Needs a current GL context.
+class GLRenderBackend : public RenderBackend {
+public:
+  struct Material {
+    bool useTexture = false;
+    glm::vec3 color = glm::vec3(1.0f);
+  };
+
+  // Uniform buffer binding point of FrameData
+  static constexpr unsigned int FRAME_DATA_BINDING = 0;
+
+  GLRenderBackend();
+  ~GLRenderBackend() override;
+
+  // Ids to use in DrawPacket::shader / DrawPacket::material
+  std::uint32_t addShader(Shader *shader);
+  std::uint32_t addMaterial(const Material &material);
+
+  // Uploads the per-frame block once, all shaders read it from there
+  void setFrameData(const FrameData &frame);
+
+  // Upload models not yet on the GPU as CompactVertex (16 instead of 32
+  // bytes per vertex); models already uploaded keep their format. Indices
+  // are 16-bit whenever the vertex count allows, in either format.
+  void setCompactVertices(bool enabled) { compactVertices = enabled; }
+
+  // Free the CPU copy of models uploaded from now on, see
+  // Model::releaseCpuData()
+  void setReleaseCpuData(bool enabled) { releaseCpuData = enabled; }
+
+  // Deletes the buffers of a model that is gone, see
+  // ResourceManager::takeReleasedBuffers()
+  void deleteModelBuffers(unsigned int vao, unsigned int vbo,
+                          unsigned int ebo);
+
+  void beginSubmit(const std::vector<DrawPacket> &packets) override;
+  void setShader(std::uint32_t shader) override;
+  void setMaterial(std::uint32_t material) override;
+  void setModel(Model *model, std::uint32_t lod) override;
+  void drawInstances(std::size_t first, std::size_t count) override;
+  void endSubmit() override;
+
+private:
+  // Per-instance vertex attributes, locations 3..9 of basic.vert
+  struct InstanceData {
+    glm::mat4 model;
+    glm::mat3 normalMatrix;
+  };
+
+  // Material and vertex format uniform locations resolved once per shader
+  struct ShaderEntry {
+    Shader *shader;
+    int useTexture;
+    int objectColor;
+    int positionScale;
+    int positionOffset;
+    int octahedralNormals;
+  };
+
+  std::vector<ShaderEntry> shaders;
+  std::vector<Material> materials;
+  std::vector<InstanceData> instances;
+  unsigned int instanceVBO = 0;
+  unsigned int frameUBO = 0;
+  const ShaderEntry *currentShader = nullptr;
+  Model *currentModel = nullptr;
+  Model::Lod currentLod;
+  bool compactVertices = false;
+  bool releaseCpuData = false;
+
+  void bindInstanceAttributes(std::size_t first);
+  // Dequantization uniforms of currentModel for currentShader
+  void setVertexFormatUniforms();
+  void uploadModelToGPU(Model *model);
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "../core/RenderComponent.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+// One draw of one instance. Packets are ordered by key only; what is
+// actually bound comes from the other fields.
+struct DrawPacket {
+  std::uint64_t key;
+  Model *model;
+  const glm::mat4 *transform;
+  std::uint32_t shader;
+  std::uint32_t material;
+  std::uint32_t lod; // level of model, see Model::lods
+};
+
+// Receives the sorted packets. Calls only happen when the corresponding
+// state differs from the previous packet, and runs of packets sharing
+// shader, material, model and LOD arrive as a single drawInstances call.
+class RenderBackend {
+public:
+  virtual ~RenderBackend() = default;
+
+  // Packets in submission order, instance i of a draw is packets[first + i]
+  virtual void beginSubmit(const std::vector<DrawPacket> &packets) = 0;
+  virtual void setShader(std::uint32_t shader) = 0;
+  virtual void setMaterial(std::uint32_t material) = 0;
+  // Also called when only the LOD changes
+  virtual void setModel(Model *model, std::uint32_t lod) = 0;
+  virtual void drawInstances(std::size_t first, std::size_t count) = 0;
+  virtual void endSubmit() = 0;
+};
+
+// Backend-independent list of draw packets for one frame:
+// push() everything, sort(), then submit() to a backend.
+class RenderQueue {
+public:
+  // What one submit() issued on the backend
+  struct Stats {
+    std::size_t packets = 0;
+    std::size_t draws = 0;
+    std::size_t shaderChanges = 0;
+    std::size_t materialChanges = 0;
+    std::size_t modelChanges = 0;
+  };
+
+  // Bit layout, high to low: shader 8 | material 16 | model 16 | lod 3 |
+  // depth 21. depth01 is clamped to [0, 1]; smaller draws first (front to
+  // back).
+  static std::uint64_t makeKey(std::uint32_t shader, std::uint32_t material,
+                               std::uint32_t model, std::uint32_t lod,
+                               float depth01);
+
+  void clear() { packets.clear(); }
+  void reserve(std::size_t n) { packets.reserve(n); }
+  void push(const DrawPacket &packet) { packets.push_back(packet); }
+
+  // Stable LSD radix sort on the key, 8 bits per pass; passes where every
+  // key has the same byte are skipped
+  void sort();
+
+  Stats submit(RenderBackend &backend) const;
+
+  const std::vector<DrawPacket> &getPackets() const { return packets; }
+  std::size_t size() const { return packets.size(); }
+
+private:
+  std::vector<DrawPacket> packets;
+  std::vector<DrawPacket> scratch;
+};
@@ -1,19 +1,36 @@
 #pragma once
 #include "../ResourceManager.hpp"
 #include "../core/World.hpp"
+#include "../math/Culling.hpp"
+#include "GLRenderBackend.hpp"
+#include "RenderQueue.hpp"
 #include "Shader.hpp"
+#include "TransformSystem.hpp"
 #include <fstream>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-
-// Iterates through Entities with TransformComponent or RenderComponent.
+#include <limits>
+#include <sstream>
+
+// Iterates through Entities with TransformComponent and RenderComponent.
+// World matrices come from TransformSystem, which must run first. Entities
+// whose bounding sphere is outside the view frustum are not drawn, the rest
+// become packets of a RenderQueue, which sorts them and hands them to the
+// GL backend as one instanced draw per shader/material/model/LOD run. The
+// LOD follows the bounding sphere's size on screen (Model::selectLod).
+// Writes RenderComponent: finished asynchronous model loads are moved from
+// pendingModel to model, and the chosen LOD is kept for the next frame.
+// After drawing, ResourceManager::trim() unloads unused models over the
+// memory budget and the buffers of destroyed models are deleted.
 class RenderSystem {
 public:
-  RenderSystem(World *world, ResourceManager *rm)
-      : world(world), resourceManager(rm) {
+  RenderSystem(World *world, ResourceManager *rm, TransformSystem *transforms)
+      : world(world), resourceManager(rm), transforms(transforms) {
     std::string vertSrc = readFile("shaders/basic.vert");
     std::string fragSrc = readFile("shaders/basic.frag");
     shader = std::make_unique<Shader>(vertSrc, fragSrc);
+    shaderId = backend.addShader(shader.get());
+    defaultMaterial = backend.addMaterial(GLRenderBackend::Material{});
   }
 
   void setViewportSize(int w, int h) {
@@ -21,6 +38,16 @@ public:
     screenHeight = h;
   }
 
+  // Compact GPU vertices for models uploaded from now on, see
+  // GLRenderBackend::setCompactVertices
+  void setCompactVertices(bool enabled) {
+    backend.setCompactVertices(enabled);
+  }
+
+  // Drop the CPU copy of models uploaded from now on, see
+  // GLRenderBackend::setReleaseCpuData
+  void setReleaseCpuData(bool enabled) { backend.setReleaseCpuData(enabled); }
+
   void render() {
     if (screenWidth == 0 || screenHeight == 0)
       return;
@@ -28,118 +55,112 @@ public:
     glm::vec3 camPos = glm::vec3(0.0f, 0.0f, 3.0f);
     glm::mat4 view = glm::translate(glm::mat4(1.0f), -camPos);
     glm::mat4 projection = glm::perspective(
-        glm::radians(45.0f), (float)screenWidth / (float)screenHeight, 0.1f,
-        100.0f);
-
-    shader->use();
-    shader->setMat4("view", view);
-    shader->setMat4("projection", projection);
-    shader->setVec3("lightPos", glm::vec3(0.0f, 5.0f, 5.0f));
-    shader->setVec3("lightColor", glm::vec3(1.0f));
-    shader->setVec3("viewPos", camPos);
-
-    for (Entity e : world->getEntities()) {
-      auto tc = world->getTransform(e);
-      auto rc = world->getRender(e);
-      if (tc && rc && rc->model) {
-        Model *model = rc->model.get();
-        if (!model->uploadedToGPU) {
-          uploadModelToGPU(model);
-        }
-        glm::mat4 modelMat = glm::mat4(1.0f);
-        modelMat =
-            glm::translate(modelMat, glm::vec3(tc->position[0], tc->position[1],
-                                               tc->position[2]));
-        modelMat = glm::rotate(modelMat, glm::radians(tc->rotation[0]),
-                               glm::vec3(1, 0, 0));
-        modelMat = glm::rotate(modelMat, glm::radians(tc->rotation[1]),
-                               glm::vec3(0, 1, 0));
-        modelMat = glm::rotate(modelMat, glm::radians(tc->rotation[2]),
-                               glm::vec3(0, 0, 1));
-        modelMat = glm::scale(
-            modelMat, glm::vec3(tc->scale[0], tc->scale[1], tc->scale[2]));
-
-        shader->setMat4("model", modelMat);
-
-        shader->setBool("useTexture", false);
-        shader->setVec3("objectColor", glm::vec3(1.0f, 1.0f, 1.0f));
-
-        glBindVertexArray(model->VAO);
-        GLsizei indexCount = static_cast<GLsizei>(model->indices.size());
-        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-      }
+        glm::radians(45.0f), (float)screenWidth / (float)screenHeight,
+        NEAR_PLANE, FAR_PLANE);
+
+    FrameData frame;
+    frame.view = view;
+    frame.projection = projection;
+    frame.lightPos = glm::vec4(0.0f, 5.0f, 5.0f, 0.0f);
+    frame.lightColor = glm::vec4(1.0f);
+    frame.viewPos = glm::vec4(camPos, 0.0f);
+    backend.setFrameData(frame);
+
+    // Candidates with world-space bounds, then one batched frustum test
+    drawModels.clear();
+    drawComponents.clear();
+    drawMatrices.clear();
+    spheres.clear();
+    loadingCount = 0;
+    world->view<TransformComponent, RenderComponent>().each(
+        [&](Entity e, TransformComponent &, RenderComponent &rc) {
+          const glm::mat4 *modelMat = transforms->getWorldMatrix(e);
+          // Models still loading are skipped, never waited for
+          if (!modelMat || !rc.resolveModel()) {
+            loadingCount += rc.pendingModel.valid();
+            return;
+          }
+          glm::vec3 center;
+          float radius;
+          transformSphere(*modelMat, rc.model->boundsCenter,
+                          rc.model->boundsRadius, center, radius);
+          drawModels.push_back(rc.model.get());
+          drawComponents.push_back(&rc);
+          drawMatrices.push_back(modelMat);
+          spheres.push(center, radius);
+        });
+    visible.resize(spheres.size());
+    visibleCount = cullSpheres(extractFrustum(projection * view), spheres,
+                               visible.data());
+
+    // Sphere radius in pixels per unit of radius / depth
+    const float pixelScale = projection[1][1] * 0.5f * float(screenHeight);
+    queue.clear();
+    triangleCount = 0;
+    for (std::size_t i = 0; i < drawModels.size(); ++i) {
+      if (!visible[i])
+        continue;
+      float depth = -(view[0][2] * spheres.x[i] + view[1][2] * spheres.y[i] +
+                      view[2][2] * spheres.z[i] + view[3][2]);
+      Model *model = drawModels[i];
+      RenderComponent &rc = *drawComponents[i];
+      // Spheres reaching the near plane get the full mesh
+      float pixelRadius = depth > NEAR_PLANE
+                              ? spheres.radius[i] * pixelScale / depth
+                              : std::numeric_limits<float>::max();
+      rc.lod = model->selectLod(pixelRadius, rc.lod);
+      triangleCount += model->lod(rc.lod).indexCount / 3;
+      queue.push({RenderQueue::makeKey(shaderId, defaultMaterial,
+                                       model->sortId, rc.lod,
+                                       depth / FAR_PLANE),
+                  model, drawMatrices[i], shaderId, defaultMaterial, rc.lod});
+    }
+    queue.sort();
+    lastStats = queue.submit(backend);
+
+    // Models referenced by an entity are in use this frame
+    if (resourceManager) {
+      resourceManager->trim();
+      for (const ResourceManager::GpuBuffers &b :
+           resourceManager->takeReleasedBuffers())
+        backend.deleteModelBuffers(b.VAO, b.VBO, b.EBO);
     }
   }
 
+  // Entities drawn by the last render()
+  std::size_t getLastVisibleCount() const { return visibleCount; }
+  // Entities skipped by the last render() because their model was loading
+  std::size_t getLastLoadingCount() const { return loadingCount; }
+  // Triangles per frame at the chosen LODs
+  std::size_t getLastTriangleCount() const { return triangleCount; }
+
+  // Draw calls and state changes of the last render()
+  const RenderQueue::Stats &getLastStats() const { return lastStats; }
+
 private:
   World *world;
   ResourceManager *resourceManager;
+  TransformSystem *transforms;
+  static constexpr float NEAR_PLANE = 0.1f;
+  static constexpr float FAR_PLANE = 100.0f;
   int screenWidth = 800, screenHeight = 600;
   std::unique_ptr<Shader> shader;
 
-  void uploadModelToGPU(Model *model) {
-    bool hasNormals = !model->normals.empty();
-    bool hasTexcoords = !model->texcoords.empty();
-    size_t vertCount = model->positions.size() / 3;
-    std::vector<float> vertexData;
-    vertexData.reserve(vertCount *
-                       (3 + (hasNormals ? 3 : 0) + (hasTexcoords ? 2 : 0)));
-
-    for (size_t i = 0; i < vertCount; ++i) {
-      vertexData.push_back(model->positions[3 * i + 0]);
-      vertexData.push_back(model->positions[3 * i + 1]);
-      vertexData.push_back(model->positions[3 * i + 2]);
-      if (hasNormals) {
-        vertexData.push_back(model->normals[3 * i + 0]);
-        vertexData.push_back(model->normals[3 * i + 1]);
-        vertexData.push_back(model->normals[3 * i + 2]);
-      }
-      if (hasTexcoords) {
-        vertexData.push_back(model->texcoords[2 * i + 0]);
-        vertexData.push_back(model->texcoords[2 * i + 1]);
-      }
-    }
-
-    glGenVertexArrays(1, &model->VAO);
-    glGenBuffers(1, &model->VBO);
-    glGenBuffers(1, &model->EBO);
-
-    glBindVertexArray(model->VAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, model->VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertexData.size() * sizeof(float),
-                 vertexData.data(), GL_STATIC_DRAW);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model->EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-                 model->indices.size() * sizeof(unsigned int),
-                 model->indices.data(), GL_STATIC_DRAW);
-
-    // location = 0 : position (vec3)
-    // location = 1 : normal   (vec3)
-    // location = 2 : texcoord (vec2)
-    GLsizei stride =
-        (GLsizei)((3 + (hasNormals ? 3 : 0) + (hasTexcoords ? 2 : 0)) *
-                  sizeof(float));
-    size_t offset = 0;
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)(offset));
-    offset += 3 * sizeof(float);
-    if (hasNormals) {
-      glEnableVertexAttribArray(1);
-      glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void *)(offset));
-      offset += 3 * sizeof(float);
-    }
-    if (hasTexcoords) {
-      glEnableVertexAttribArray(2);
-      glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void *)(offset));
-      offset += 2 * sizeof(float);
-    }
-
-    glBindVertexArray(0);
-    model->uploadedToGPU = true;
-  }
+  // Per-frame scratch, parallel arrays
+  std::vector<Model *> drawModels;
+  std::vector<RenderComponent *> drawComponents;
+  std::vector<const glm::mat4 *> drawMatrices;
+  SphereSoA spheres;
+  std::vector<std::uint8_t> visible;
+  std::size_t visibleCount = 0;
+  std::size_t loadingCount = 0;
+  std::size_t triangleCount = 0;
+
+  RenderQueue queue;
+  RenderQueue::Stats lastStats;
+  GLRenderBackend backend;
+  std::uint32_t shaderId = 0;
+  std::uint32_t defaultMaterial = 0;
 
   std::string readFile(const std::string &path) {
     std::ifstream ifs(path);
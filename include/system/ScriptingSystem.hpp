@@ -1,33 +1,134 @@
 #pragma once
 #include "../core/World.hpp"
+#include <cstdint>
 #include <lua.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 // Lua Integration
 // Creates one lua_State*, regirster function to manage TransformComponent.
 // Every frame calls update() in Lua-script for every entity with
 // LuaScriptComponent.
+// Each script file is compiled once. Every entity runs its own instance of
+// the chunk in its own environment table (globals the script sets stay per
+// entity, reads fall through to the shared globals), and its update
+// function is kept as a registry reference, so a frame only pushes and
+// calls it. The frame's dt is the global "dt", the entity a script runs for
+// is "entity_id" in its environment, and "transform" there is a userdata
+// proxy of its TransformComponent. None of the functions and proxy
+// accesses allocate, so scripts that avoid tables of their own make no
+// garbage per frame.
+// Batched mode, opt-in per script: a script whose first line is "-- batch"
+// runs once, in one environment of its own, and must define
+// update_batch(entities, dt), which is called once per frame with all
+// entities using the script instead of update() per entity. entities is a
+// userdata: #entities, entities:entity(i), :position(i),
+// :set_position(i, x, y, z), :rotation(i), :set_rotation(i, x, y, z), and
+// :translate(x, y, z), :rotate(x, y, z, angle) for all of them in one call.
+// The environments of destroyed entities are released on the next update,
+// from the World's log of them.
 class ScriptingSystem {
 public:
   ScriptingSystem(World *world);
   ~ScriptingSystem();
+  // Lua functions refer to this instance
+  ScriptingSystem(const ScriptingSystem &) = delete;
+  ScriptingSystem &operator=(const ScriptingSystem &) = delete;
 
   void init();
 
   void update(float dt);
 
+  // For measuring the Lua heap and garbage collector
+  lua_State *getLuaState() const { return L; }
+
 private:
+  static constexpr std::uint32_t NO_SCRIPT = UINT32_MAX;
+  static constexpr const char *TRANSFORM_METATABLE = "ecs.Transform";
+  static constexpr const char *BATCH_METATABLE = "ecs.EntityBatch";
+
+  // A compiled script file. chunk is Lua bytecode, empty if the file
+  // failed to compile (reported once, not retried).
+  struct Script {
+    std::string path;
+    std::string chunk;
+    bool batched = false; // marked "-- batch"
+    // Batched scripts only, registry references
+    int env = LUA_NOREF;
+    int updateBatch = LUA_NOREF;
+    int batch = LUA_NOREF; // the entities userdata
+    // This frame's entities, parallel arrays
+    std::vector<Entity> entities;
+    std::vector<TransformComponent *> transforms;
+  };
+
+  // Lua side of one entity, registry references
+  struct Binding {
+    Entity entity = INVALID_ENTITY;
+    std::uint32_t script = NO_SCRIPT;
+    int env = LUA_NOREF;
+    int update = LUA_NOREF; // LUA_NOREF if the script has no update()
+  };
+
   World *world;
+  // Tells this system's script ids in LuaScriptComponents from others'
+  std::uint32_t serial;
   lua_State *L = nullptr;
+  // Entity the running update() belongs to, read by the Lua functions
+  Entity currentEntity = INVALID_ENTITY;
+  // Metatable of the environments, falls back to the globals
+  int envMetatable = LUA_NOREF;
+
+  std::vector<Script> scripts;
+  std::vector<std::uint32_t> batchedScripts;
+  std::unordered_map<std::string, std::uint32_t> scriptIds;
+  std::vector<Binding> bindings; // entityIndex() -> binding
+  std::vector<Entity> removals;  // scratch for the World's log
 
   void registerFunctions();
 
   static int l_get_position(lua_State *L);
   static int l_set_position(lua_State *L);
   static int l_rotate(lua_State *L);
+  static int l_transform_index(lua_State *L);
+  static int l_transform_newindex(lua_State *L);
+  static float *transformField(TransformComponent &tc, const char *key);
+
+  static int l_batch_len(lua_State *L);
+  static int l_batch_entity(lua_State *L);
+  static int l_batch_position(lua_State *L);
+  static int l_batch_set_position(lua_State *L);
+  static int l_batch_rotation(lua_State *L);
+  static int l_batch_set_rotation(lua_State *L);
+  static int l_batch_translate(lua_State *L);
+  static int l_batch_rotate(lua_State *L);
+  static Script &checkBatch(lua_State *L);
+  static TransformComponent *
+  checkBatchTransform(lua_State *L, const Script &batch, int arg);
 
+  // Instance the running Lua function was registered by
+  static ScriptingSystem *getSystem(lua_State *L);
   static World *getWorldFromLua(lua_State *L);
 
   static Entity getCurrentEntity(lua_State *L);
 
-  void callLuaUpdate(Entity e, float dt);
+  // Id of path in scripts, compiling it on first use
+  std::uint32_t compileScript(const std::string &path);
+  // Runs batched script id in its own environment and keeps its
+  // update_batch
+  void loadBatch(std::uint32_t id);
+  // Pushes a new environment table
+  void pushEnvironment();
+  // Runs the chunk with the environment on top of the stack as _ENV. The
+  // error message is pushed on failure.
+  int runChunk(const Script &script);
+  // Runs script id in a fresh environment for e and keeps its update()
+  void bind(Binding &binding, Entity e, std::uint32_t id);
+  void unbind(Binding &binding);
+  // Unbinds the entities destroyed since the last update
+  void releaseBindings();
+
+  void callLuaUpdate(Entity e, const Binding &binding);
+  void callLuaUpdateBatch(std::uint32_t id, float dt);
 };
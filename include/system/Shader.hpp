@@ -3,6 +3,9 @@
 #include <string>
 #include <unordered_map>
 
+// Active uniforms are reflected once after linking. Name-based setters look
+// the location up in that table; hot paths should resolve a location once
+// with getUniformLocation() and use the location-based overloads.
 class Shader {
 public:
   Shader(const std::string &vertexSrc, const std::string &fragmentSrc);
@@ -11,14 +14,31 @@ public:
   void use() const;
   unsigned int getID() const { return ID; }
 
+  // -1 if the program has no active uniform with that name
+  int getUniformLocation(const std::string &name) const;
+
+  // Attaches the named uniform block to a buffer binding point, returns
+  // false if the program has no such block
+  bool bindUniformBlock(const std::string &blockName,
+                        unsigned int binding) const;
+
   void setBool(const std::string &name, bool value) const;
   void setInt(const std::string &name, int value) const;
   void setFloat(const std::string &name, float value) const;
   void setMat4(const std::string &name, const glm::mat4 &mat) const;
   void setVec3(const std::string &name, const glm::vec3 &vec) const;
 
+  // Location-based, program must be in use; -1 is ignored like in GL
+  void setBool(int location, bool value) const;
+  void setInt(int location, int value) const;
+  void setFloat(int location, float value) const;
+  void setMat4(int location, const glm::mat4 &mat) const;
+  void setVec3(int location, const glm::vec3 &vec) const;
+
 private:
   unsigned int ID;
+  std::unordered_map<std::string, int> uniformLocations;
 
   void checkCompileErrors(unsigned int shader, const std::string &type) const;
+  void reflectUniforms();
 };
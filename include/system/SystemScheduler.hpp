@@ -0,0 +1,74 @@
+#pragma once
+#include "../core/Archetype.hpp"
+#include "../core/ThreadPool.hpp"
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Component types a system reads and writes.
+// Two systems conflict if one writes something the other reads or writes.
+struct SystemAccess {
+  ComponentMask reads = 0;
+  ComponentMask writes = 0;
+  // Has to run on the thread calling runFrame() (e.g. owns the GL context)
+  bool mainThread = false;
+
+  template <typename... Ts> SystemAccess &read() {
+    reads |= componentMask<Ts...>();
+    return *this;
+  }
+  template <typename... Ts> SystemAccess &write() {
+    writes |= componentMask<Ts...>();
+    return *this;
+  }
+  SystemAccess &onMainThread() {
+    mainThread = true;
+    return *this;
+  }
+
+  bool conflictsWith(const SystemAccess &other) const {
+    return (writes & (other.reads | other.writes)) != 0 ||
+           (other.writes & reads) != 0;
+  }
+};
+
+// Runs registered systems once per frame. Every frame a dependency graph is
+// built: a system depends on each earlier-registered system it conflicts
+// with, so registration order decides the order of conflicting systems while
+// independent ones run concurrently on the pool.
+class SystemScheduler {
+public:
+  // Without a pool everything runs sequentially on the calling thread
+  explicit SystemScheduler(ThreadPool *pool) : pool(pool) {}
+
+  void addSystem(const std::string &name, const SystemAccess &access,
+                 std::function<void()> run);
+
+  // Returns when all systems have finished
+  void runFrame();
+
+  // Wall time spent in each system's run(), accumulated over frames
+  struct SystemStats {
+    std::string name;
+    std::size_t runs = 0;
+    double totalSeconds = 0.0;
+    double maxSeconds = 0.0;
+  };
+  const std::vector<SystemStats> &getStats() const { return stats; }
+  void resetStats();
+
+private:
+  struct SystemEntry {
+    std::string name;
+    SystemAccess access;
+    std::function<void()> run;
+  };
+
+  ThreadPool *pool;
+  std::vector<SystemEntry> systems;
+  // Parallel to systems, each entry only written by the thread running it
+  std::vector<SystemStats> stats;
+
+  void runTimed(std::size_t i);
+};
@@ -0,0 +1,88 @@
+#pragma once
+#include "../core/ThreadPool.hpp"
+#include "../core/World.hpp"
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+// Keeps local and world matrices of every TransformComponent.
+// Nodes are indexed by entity slot and linked to their parent and children.
+// The first update builds them from all transforms, later ones only apply
+// the World's transform change log: logged nodes are inserted, removed or
+// relinked in place and get a new local matrix. World matrices are redone
+// below the changed nodes: a few subtrees are walked one by one, larger
+// batches take one linear pass over all nodes sorted by depth, re-sorted
+// only after the hierarchy changed. A frame without changes does no work.
+// Children of a parent that has no TransformComponent yet are linked once
+// it gets one.
+class TransformSystem {
+public:
+  explicit TransformSystem(World *world) : world(world) {}
+
+  // Optional, used for large batches of dirty nodes
+  void setThreadPool(ThreadPool *pool) { threadPool = pool; }
+
+  void update();
+
+  // nullptr if e has no TransformComponent (as of the last update)
+  const glm::mat4 *getWorldMatrix(Entity e) const;
+
+  // Nodes whose world matrix was recomputed by the last update
+  std::size_t getLastUpdatedCount() const { return lastUpdatedCount; }
+
+private:
+  static constexpr std::uint32_t NO_NODE = UINT32_MAX;
+
+  // Links are entity slots, NO_NODE if none
+  struct Node {
+    Entity entity = INVALID_ENTITY; // INVALID_ENTITY if the slot has none
+    std::uint32_t parent = NO_NODE;
+    std::uint32_t firstChild = NO_NODE;
+    std::uint32_t nextSibling = NO_NODE;
+    std::uint32_t prevSibling = NO_NODE;
+    // Parent without a TransformComponent the node is listed as waiting for
+    Entity waitsFor = INVALID_ENTITY;
+    // Update that last queued the node, and took it as a root
+    std::uint32_t queued = 0;
+    std::uint32_t rooted = 0;
+  };
+
+  World *world;
+  ThreadPool *threadPool = nullptr;
+  bool built = false;
+  std::uint32_t stamp = 0;
+  std::size_t lastUpdatedCount = 0;
+
+  // Indexed by entityIndex()
+  std::vector<Node> nodes;
+  std::vector<glm::mat4> localMatrices;
+  std::vector<glm::mat4> worldMatrices;
+  std::size_t nodeCount = 0;
+
+  // Slots of all nodes, parents first; stale once the hierarchy changes
+  std::vector<std::uint32_t> order;
+  bool orderValid = false;
+
+  // Children by the parent whose TransformComponent they wait for
+  std::unordered_map<Entity, std::vector<Entity>> waiting;
+  std::size_t waitingPurgeSize = 0;
+
+  // Scratch: logged entities, the batched local matrix pass, children of
+  // removed nodes, and nodes whose subtree gets new world matrices
+  std::vector<Entity> changes;
+  std::vector<std::uint32_t> dirtyNodes;
+  std::vector<TransformComponent> dirtyTransforms;
+  std::vector<glm::mat4> dirtyMatrices;
+  std::vector<std::uint32_t> orphans;
+  std::vector<std::uint32_t> roots;
+  std::vector<std::uint32_t> stack;
+
+  void reset();
+  void sortByDepth();
+  std::size_t propagateFromRoots();
+  std::size_t propagateInOrder();
+  void removeNode(std::uint32_t slot);
+  void link(std::uint32_t slot, Entity parent);
+  void unlink(std::uint32_t slot);
+};
@@ -1,4 +1,4 @@
 function update()
     local angle = dt * 45.0
-    rotate({0, 1, 0}, angle)
+    rotate(0, 1, 0, angle)
 end
@@ -10,9 +10,14 @@ uniform vec3 objectColor;
 uniform sampler2D diffuseTexture;
 uniform bool useTexture;
 
-uniform vec3 lightPos;
-uniform vec3 lightColor;
-uniform vec3 viewPos;
+// Per-frame values, one buffer shared by all shaders (see FrameData)
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 lightPos;
+    vec3 lightColor;
+    vec3 viewPos;
+};
 
 void main() {
     vec3 norm = normalize(Normal);
@@ -1,21 +1,49 @@
 #version 330 core
 
 layout(location = 0) in vec3 aPos;
-layout(location = 1) in vec3 aNormal;
+layout(location = 1) in vec3 aNormal; // xy octahedral if octahedralNormals
 layout(location = 2) in vec2 aTexCoord;
+// Per instance
+layout(location = 3) in mat4 aModel;        // 3..6
+layout(location = 7) in mat3 aNormalMatrix; // 7..9
 
 out vec3 FragPos;
 out vec3 Normal;
 out vec2 TexCoord;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// Per-frame values, one buffer shared by all shaders (see FrameData)
+layout(std140) uniform FrameData {
+    mat4 view;
+    mat4 projection;
+    vec3 lightPos;
+    vec3 lightColor;
+    vec3 viewPos;
+};
+
+// Per model: compact vertices carry positions as unorm16 within the bounds
+// and normals as octahedral int16 (see math/VertexQuantization.hpp), float
+// vertices come with scale 1, offset 0 and false
+uniform vec3 positionScale;
+uniform vec3 positionOffset;
+uniform bool octahedralNormals;
+
+// Unnormalized, the fragment shader normalizes
+vec3 decodeNormal() {
+    if (!octahedralNormals)
+        return aNormal;
+    vec2 e = max(aNormal.xy / 32767.0, vec2(-1.0));
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return n;
+}
 
 void main() {
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    vec3 position = aPos * positionScale + positionOffset;
+    FragPos = vec3(aModel * vec4(position, 1.0));
     if (gl_VertexID >= 0) {
-        Normal = mat3(transpose(inverse(model))) * aNormal;
+        Normal = aNormalMatrix * decodeNormal();
         TexCoord = aTexCoord;
     }
     gl_Position = projection * view * vec4(FragPos, 1.0);
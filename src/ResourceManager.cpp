@@ -1,186 +1,240 @@
 #include "ResourceManager.hpp"
-#include <filesystem>
-#include <glm/glm.hpp>
+#include "core/ThreadPool.hpp"
+#include "math/MeshSimplifier.hpp"
+#include "serialization/CookedMesh.hpp"
+#include "serialization/ObjImporter.hpp"
+#include <algorithm>
+#include <chrono>
 #include <iostream>
-#include <tiny_obj_loader.h>
+#include <thread>
 
-std::shared_ptr<Model> ResourceManager::loadModel(const std::string &path) {
-  auto it = models.find(path);
-  if (it != models.end()) {
-    return it->second;
-  }
-  auto modelPtr = std::make_shared<Model>();
-  if (!parseOBJ(path, *modelPtr)) {
-    std::cerr << "Failed to load model from " << path << std::endl;
-    return nullptr;
-  }
-  models[path] = modelPtr;
-  std::cout << "Model loaded: " << path
-            << " (positions: " << modelPtr->positions.size() / 3
-            << ", indices: " << modelPtr->indices.size() << ")" << std::endl;
-  return modelPtr;
-}
-
-bool ResourceManager::parseOBJ(const std::string &path, Model &outModel) {
-  tinyobj::attrib_t attrib;
-  std::vector<tinyobj::shape_t> shapes;
-  std::vector<tinyobj::material_t> materials;
+ResourceManager::ResourceManager() : shared(std::make_shared<Shared>()) {}
 
-  std::string warn;
-  std::string err;
+void ResourceManager::setThreadPool(ThreadPool *pool) { threadPool = pool; }
 
-  std::string basedir;
+std::shared_ptr<Model> ResourceManager::loadModel(const std::string &path) {
+  ModelFuture future;
+  std::promise<std::shared_ptr<Model>> promise;
+  bool owner = false;
   {
-    std::filesystem::path p(path);
-    if (p.has_parent_path()) {
-      basedir = p.parent_path().string() + "/";
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    auto it = shared->models.find(path);
+    if (it != shared->models.end()) {
+      it->second.lastUsed = shared->trims;
+      if (it->second.model)
+        return it->second.model;
+      future = it->second.future;
     } else {
-      basedir = "";
+      future = promise.get_future().share();
+      addEntry(*shared, path, future);
+      owner = true;
     }
   }
-
-  bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, path.c_str(),
-                              basedir.empty() ? nullptr : basedir.c_str(),
-                              /*triangulate=*/true);
-  if (!warn.empty()) {
-    std::cerr << "tinyobjloader warning: " << warn << std::endl;
+  if (!owner) {
+    // Someone else is parsing it, help the pool meanwhile
+    while (future.wait_for(std::chrono::seconds(0)) !=
+           std::future_status::ready) {
+      if (!threadPool || !threadPool->runPendingTask())
+        std::this_thread::yield();
+    }
+    return future.get();
   }
-  if (!err.empty()) {
-    std::cerr << "tinyobjloader error: " << err << std::endl;
+  parse(shared, path, meshCacheDir, threadPool, promise);
+  return future.get();
+}
+
+ModelFuture ResourceManager::loadModelAsync(const std::string &path) {
+  auto promise = std::make_shared<std::promise<std::shared_ptr<Model>>>();
+  ModelFuture future;
+  {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    auto it = shared->models.find(path);
+    if (it != shared->models.end()) {
+      it->second.lastUsed = shared->trims;
+      if (!it->second.model)
+        return it->second.future;
+      // A future of its own, so the caller holding it counts as a reference
+      std::promise<std::shared_ptr<Model>> loaded;
+      loaded.set_value(it->second.model);
+      return loaded.get_future().share();
+    }
+    future = promise->get_future().share();
+    addEntry(*shared, path, future);
   }
-  if (!ret) {
-    std::cerr << "Failed to load/parse .obj: " << path << std::endl;
-    return false;
+  if (!threadPool || threadPool->getWorkerCount() == 0) {
+    parse(shared, path, meshCacheDir, nullptr, *promise);
+    return future;
   }
+  threadPool->submit([state = shared, path, cacheDir = meshCacheDir,
+                      pool = threadPool, promise] {
+    parse(state, path, cacheDir, pool, *promise);
+  });
+  return future;
+}
 
-  outModel.positions.clear();
-  outModel.normals.clear();
-  outModel.texcoords.clear();
-  outModel.indices.clear();
-  outModel.materials.clear();
-
-  outModel.materials.reserve(materials.size());
-  for (const auto &mat : materials) {
-    Model::MaterialInfo mi;
-    mi.name = mat.name;
-    mi.diffuse_color =
-        glm::vec3(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2]);
-    mi.ambient_color =
-        glm::vec3(mat.ambient[0], mat.ambient[1], mat.ambient[2]);
-    mi.specular_color =
-        glm::vec3(mat.specular[0], mat.specular[1], mat.specular[2]);
-    mi.shininess = mat.shininess;
-    mi.diffuse_texname = mat.diffuse_texname;
-    mi.ambient_texname = mat.ambient_texname;
-    mi.specular_texname = mat.specular_texname;
-    outModel.materials.push_back(std::move(mi));
-  }
+void ResourceManager::addEntry(Shared &shared, const std::string &path,
+                               const ModelFuture &future) {
+  shared.models.emplace(path, Entry{future, nullptr, shared.trims, false, {}});
+  shared.pending.fetch_add(1);
+  if (shared.unloaded.erase(path))
+    ++shared.reloads;
+}
 
-  struct VertexKey {
-    int vi, ti, ni;
-    bool operator==(VertexKey const &o) const {
-      return vi == o.vi && ti == o.ti && ni == o.ni;
-    }
-  };
-  struct VertexKeyHasher {
-    std::size_t operator()(VertexKey const &k) const noexcept {
-      return (static_cast<size_t>(k.vi) * 73856093) ^
-             (static_cast<size_t>(k.ti) * 19349663) ^
-             (static_cast<size_t>(k.ni) * 83492791);
-    }
+std::size_t ResourceManager::evictUnused(std::size_t budget) {
+  // Destroyed after the lock is released: the last reference going runs
+  // the deleter, which takes the lock too
+  std::vector<std::shared_ptr<Model>> dropped;
+  std::lock_guard<std::mutex> lock(shared->mutex);
+  ++shared->trims;
+  struct Candidate {
+    std::unordered_map<std::string, Entry>::iterator entry;
+    std::size_t bytes;
   };
-  std::unordered_map<VertexKey, unsigned int, VertexKeyHasher> uniqueVertexMap;
-  uniqueVertexMap.reserve(1000);
+  std::vector<Candidate> unused;
+  std::size_t total = 0;
+  for (auto it = shared->models.begin(); it != shared->models.end(); ++it) {
+    Entry &entry = it->second;
+    const std::shared_ptr<Model> &model = entry.model;
+    if (!model)
+      continue; // still loading
+    const std::size_t bytes = model->cpuBytes() + model->gpuBytes;
+    total += bytes;
+    if (model.use_count() > 1)
+      entry.lastUsed = shared->trims;
+    else
+      unused.push_back({it, bytes});
+  }
+  if (total <= budget)
+    return 0;
 
-  size_t estimatedIndices = 0;
-  for (const auto &shape : shapes) {
-    estimatedIndices += shape.mesh.indices.size();
+  std::sort(unused.begin(), unused.end(),
+            [](const Candidate &a, const Candidate &b) {
+              if (a.entry->second.lastUsed != b.entry->second.lastUsed)
+                return a.entry->second.lastUsed < b.entry->second.lastUsed;
+              return a.entry->first < b.entry->first;
+            });
+  std::size_t evicted = 0;
+  for (const Candidate &c : unused) {
+    if (total <= budget)
+      break;
+    dropped.push_back(std::move(c.entry->second.model));
+    shared->unloaded.insert(c.entry->first);
+    shared->models.erase(c.entry);
+    total -= c.bytes;
+    ++evicted;
   }
-  outModel.indices.reserve(estimatedIndices);
+  shared->evictions += evicted;
+  return evicted;
+}
 
-  outModel.positions.reserve(attrib.vertices.size());
-  if (!attrib.normals.empty())
-    outModel.normals.reserve(attrib.normals.size());
-  if (!attrib.texcoords.empty())
-    outModel.texcoords.reserve(attrib.texcoords.size());
+std::vector<ResourceManager::GpuBuffers>
+ResourceManager::takeReleasedBuffers() {
+  std::vector<GpuBuffers> buffers;
+  std::lock_guard<std::mutex> lock(shared->mutex);
+  buffers.swap(shared->releasedBuffers);
+  return buffers;
+}
 
-  bool hasNormals = !attrib.normals.empty();
-  bool hasTexcoords = !attrib.texcoords.empty();
+std::vector<ResourceManager::ModelMemory>
+ResourceManager::getModelMemory() const {
+  std::vector<ModelMemory> result;
+  std::lock_guard<std::mutex> lock(shared->mutex);
+  for (const auto &[path, entry] : shared->models) {
+    const std::shared_ptr<Model> &model = entry.model;
+    if (!model)
+      continue;
+    result.push_back({path, model->cpuBytes(), model->gpuBytes,
+                      model.use_count() - 1, entry.lastUsed, entry.cooked,
+                      entry.optimize});
+  }
+  return result;
+}
 
-  for (const auto &shape : shapes) {
-    const auto &mesh = shape.mesh;
-    for (size_t idx = 0; idx < mesh.indices.size(); ++idx) {
-      tinyobj::index_t idx0 = mesh.indices[idx];
-      VertexKey key{idx0.vertex_index, idx0.texcoord_index, idx0.normal_index};
-      auto it = uniqueVertexMap.find(key);
-      if (it != uniqueVertexMap.end()) {
-        outModel.indices.push_back(it->second);
-      } else {
-        unsigned int newIndex =
-            static_cast<unsigned int>(outModel.positions.size() / 3);
-        uniqueVertexMap[key] = newIndex;
-        int v = idx0.vertex_index * 3;
-        outModel.positions.push_back(attrib.vertices[v + 0]);
-        outModel.positions.push_back(attrib.vertices[v + 1]);
-        outModel.positions.push_back(attrib.vertices[v + 2]);
-        if (hasTexcoords && idx0.texcoord_index >= 0) {
-          int t = idx0.texcoord_index * 2;
-          outModel.texcoords.push_back(attrib.texcoords[t + 0]);
-          outModel.texcoords.push_back(attrib.texcoords[t + 1]);
-        } else {
-          outModel.texcoords.push_back(0.0f);
-          outModel.texcoords.push_back(0.0f);
-        }
-        if (hasNormals && idx0.normal_index >= 0) {
-          int n = idx0.normal_index * 3;
-          outModel.normals.push_back(attrib.normals[n + 0]);
-          outModel.normals.push_back(attrib.normals[n + 1]);
-          outModel.normals.push_back(attrib.normals[n + 2]);
-        } else {
-          outModel.normals.push_back(0.0f);
-          outModel.normals.push_back(0.0f);
-          outModel.normals.push_back(0.0f);
-        }
-        outModel.indices.push_back(newIndex);
-      }
-    }
+ResourceManager::MemoryStats ResourceManager::getMemoryStats() const {
+  MemoryStats stats;
+  for (const ModelMemory &m : getModelMemory()) {
+    ++stats.models;
+    stats.cpuBytes += m.cpuBytes;
+    stats.gpuBytes += m.gpuBytes;
   }
+  stats.budget = memoryBudget;
+  std::lock_guard<std::mutex> lock(shared->mutex);
+  stats.evictions = shared->evictions;
+  stats.reloads = shared->reloads;
+  return stats;
+}
 
-  if (!hasNormals) {
-    size_t vertCount = outModel.positions.size() / 3;
-    outModel.normals.assign(vertCount * 3, 0.0f);
-    size_t faceCount = outModel.indices.size() / 3;
-    for (size_t f = 0; f < faceCount; ++f) {
-      unsigned int i0 = outModel.indices[3 * f + 0];
-      unsigned int i1 = outModel.indices[3 * f + 1];
-      unsigned int i2 = outModel.indices[3 * f + 2];
-      glm::vec3 v0(outModel.positions[3 * i0 + 0],
-                   outModel.positions[3 * i0 + 1],
-                   outModel.positions[3 * i0 + 2]);
-      glm::vec3 v1(outModel.positions[3 * i1 + 0],
-                   outModel.positions[3 * i1 + 1],
-                   outModel.positions[3 * i1 + 2]);
-      glm::vec3 v2(outModel.positions[3 * i2 + 0],
-                   outModel.positions[3 * i2 + 1],
-                   outModel.positions[3 * i2 + 2]);
-      glm::vec3 edge1 = v1 - v0;
-      glm::vec3 edge2 = v2 - v0;
-      glm::vec3 faceNormal = glm::normalize(glm::cross(edge1, edge2));
-      for (int vi : {(int)i0, (int)i1, (int)i2}) {
-        outModel.normals[3 * vi + 0] += faceNormal.x;
-        outModel.normals[3 * vi + 1] += faceNormal.y;
-        outModel.normals[3 * vi + 2] += faceNormal.z;
-      }
-    }
-    for (size_t vi = 0; vi < vertCount; ++vi) {
-      glm::vec3 n(outModel.normals[3 * vi + 0], outModel.normals[3 * vi + 1],
-                  outModel.normals[3 * vi + 2]);
-      n = glm::normalize(n);
-      outModel.normals[3 * vi + 0] = n.x;
-      outModel.normals[3 * vi + 1] = n.y;
-      outModel.normals[3 * vi + 2] = n.z;
+void ResourceManager::parse(const std::shared_ptr<Shared> &shared,
+                            const std::string &path,
+                            const std::string &cacheDir, ThreadPool *pool,
+                            std::promise<std::shared_ptr<Model>> &promise) {
+  // The GL buffers can only go on the GL thread, the deleter queues them
+  std::shared_ptr<Model> modelPtr(
+      new Model(), [weak = std::weak_ptr<Shared>(shared)](Model *model) {
+        std::shared_ptr<Shared> state = weak.lock();
+        if (state && model->uploadedToGPU) {
+          std::lock_guard<std::mutex> lock(state->mutex);
+          state->releasedBuffers.push_back(
+              {model->VAO, model->VBO, model->EBO});
+        }
+        delete model;
+      });
+  bool cooked = false;
+  MeshOptimizeStats stats;
+  if (!loadMesh(path, cacheDir, pool, *modelPtr, cooked, stats)) {
+    std::cerr << "Failed to load model from " << path << std::endl;
+    modelPtr = nullptr;
+  } else {
+    modelPtr->sortId = shared->nextModelId.fetch_add(1);
+    std::cout << "Model loaded: " << path
+              << " (vertices: " << modelPtr->vertexCount()
+              << ", indices: " << modelPtr->lod(0).indexCount
+              << ", LODs: " << modelPtr->lodCount()
+              << (cooked ? ", cooked" : "") << ")" << std::endl;
+  }
+  {
+    std::lock_guard<std::mutex> lock(shared->mutex);
+    // Failures are not cached, the next request tries again
+    if (!modelPtr) {
+      shared->models.erase(path);
+    } else if (auto it = shared->models.find(path);
+               it != shared->models.end()) {
+      // The cache keeps the model, not the future: unresolved copies of
+      // the future then keep the future's own copy of the pointer, and
+      // count as a reference
+      it->second.model = modelPtr;
+      it->second.future = ModelFuture();
+      it->second.cooked = cooked;
+      it->second.optimize = stats;
     }
+    shared->pending.fetch_sub(1);
   }
+  promise.set_value(modelPtr);
+}
 
+bool ResourceManager::importMesh(const std::string &path, ThreadPool *pool,
+                                 Model &outModel, MeshOptimizeStats &stats) {
+  if (!importObj(path, outModel, pool))
+    return false;
+  stats = optimizeMesh(outModel);
+  generateLods(outModel);
+  return true;
+}
+
+bool ResourceManager::loadMesh(const std::string &path,
+                               const std::string &cacheDir, ThreadPool *pool,
+                               Model &outModel, bool &cooked,
+                               MeshOptimizeStats &stats) {
+  MeshSourceKey key;
+  if (cacheDir.empty() || !readMeshSourceKey(path, key))
+    return importMesh(path, pool, outModel, stats);
+  const std::string cookedPath = cookedMeshPath(cacheDir, path);
+  cooked = loadCookedMesh(cookedPath, key, outModel);
+  if (cooked)
+    return true;
+  if (!importMesh(path, pool, outModel, stats))
+    return false;
+  // A failed save only costs the parse next time
+  saveCookedMesh(outModel, key, cookedPath);
   return true;
 }
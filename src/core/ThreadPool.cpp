@@ -0,0 +1,117 @@
+#include "core/ThreadPool.hpp"
+#include <cstdint>
+
+namespace {
+// Queue index of the current worker thread, or SIZE_MAX outside the pool
+thread_local std::size_t currentWorker = SIZE_MAX;
+thread_local const ThreadPool *currentPool = nullptr;
+} // namespace
+
+ThreadPool::ThreadPool(std::size_t workerCount) {
+  if (workerCount == 0) {
+    unsigned hw = std::thread::hardware_concurrency();
+    workerCount = hw > 1 ? hw - 1 : 1;
+  }
+  queues.reserve(workerCount);
+  for (std::size_t i = 0; i < workerCount; ++i)
+    queues.push_back(std::make_unique<Queue>());
+  workers.reserve(workerCount);
+  for (std::size_t i = 0; i < workerCount; ++i)
+    workers.emplace_back([this, i] { workerLoop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    stopping = true;
+  }
+  wakeUp.notify_all();
+  for (auto &t : workers)
+    t.join();
+}
+
+void ThreadPool::submit(Task task) {
+  std::size_t index = (currentPool == this)
+                          ? currentWorker
+                          : nextQueue.fetch_add(1) % queues.size();
+  {
+    std::lock_guard<std::mutex> lock(queues[index]->mutex);
+    queues[index]->tasks.push_back(std::move(task));
+  }
+  {
+    // Pairs with the predicate check in workerLoop, so no wake-up is lost
+    std::lock_guard<std::mutex> lock(sleepMutex);
+    queuedTasks.fetch_add(1);
+  }
+  wakeUp.notify_one();
+}
+
+bool ThreadPool::popTask(std::size_t preferred, Task &out) {
+  const std::size_t n = queues.size();
+  if (preferred < n) {
+    Queue &own = *queues[preferred];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      out = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      queuedTasks.fetch_sub(1);
+      return true;
+    }
+  }
+  std::size_t start = preferred < n ? preferred + 1 : 0;
+  for (std::size_t k = 0; k < n; ++k) {
+    Queue &victim = *queues[(start + k) % n];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      out = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      queuedTasks.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::runPendingTask() {
+  Task task;
+  std::size_t preferred = (currentPool == this) ? currentWorker : SIZE_MAX;
+  if (!popTask(preferred, task))
+    return false;
+  task();
+  return true;
+}
+
+void ThreadPool::workerLoop(std::size_t index) {
+  currentWorker = index;
+  currentPool = this;
+  for (;;) {
+    Task task;
+    if (popTask(index, task)) {
+      task();
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    wakeUp.wait(lock, [this] { return stopping || queuedTasks.load() > 0; });
+    if (stopping && queuedTasks.load() == 0)
+      return;
+  }
+}
+
+void TaskGroup::run(ThreadPool::Task task) {
+  if (!pool || pool->getWorkerCount() == 0) {
+    task();
+    return;
+  }
+  pending.fetch_add(1);
+  pool->submit([this, task = std::move(task)] {
+    task();
+    pending.fetch_sub(1, std::memory_order_release);
+  });
+}
+
+void TaskGroup::wait() {
+  while (pending.load(std::memory_order_acquire) != 0) {
+    if (!pool || !pool->runPendingTask())
+      std::this_thread::yield();
+  }
+}
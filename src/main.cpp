@@ -8,6 +8,9 @@
 #include "ResourceManager.hpp"
 #include "system/RenderSystem.hpp"
 #include "system/ScriptingSystem.hpp"
+#include "system/SystemScheduler.hpp"
+#include "system/TransformSystem.hpp"
+#include "core/ThreadPool.hpp"
 #include "serialization/Serialization.hpp"
 //clang-format on
 
@@ -49,6 +52,8 @@ int main() {
 
   World world;
   ResourceManager resourceManager;
+  // Later starts map the cooked rat instead of parsing the .obj
+  resourceManager.setMeshCacheDir("cache/meshes");
 
   Entity e1 = world.createEntity();
 
@@ -65,19 +70,41 @@ int main() {
   world.addComponent(e1, rc1);
 
   LuaScriptComponent sc1;
-  sc1.scriptPath = "scripts/rotate.lua";
+  sc1.setScriptPath("scripts/rotate.lua");
   world.addComponent(e1, sc1);
 
-  RenderSystem renderSystem(&world, &resourceManager);
+  TransformSystem transformSystem(&world);
+  RenderSystem renderSystem(&world, &resourceManager, &transformSystem);
+  renderSystem.setCompactVertices(true);
+  // Drawing only needs the GPU copy
+  renderSystem.setReleaseCpuData(true);
   ScriptingSystem scriptingSystem(&world);
   scriptingSystem.init();
 
   const float dt = 0.016f;
+
+  ThreadPool threadPool;
+  resourceManager.setThreadPool(&threadPool);
+  transformSystem.setThreadPool(&threadPool);
+  SystemScheduler scheduler(&threadPool);
+  scheduler.addSystem(
+      "scripting",
+      SystemAccess().read<LuaScriptComponent>().write<TransformComponent>(),
+      [&] { scriptingSystem.update(dt); });
+  scheduler.addSystem("transform", SystemAccess().write<TransformComponent>(),
+                      [&] { transformSystem.update(); });
+  // GL calls, so stays on this thread
+  scheduler.addSystem(
+      "render",
+      SystemAccess()
+          .read<TransformComponent>()
+          .write<RenderComponent>()
+          .onMainThread(),
+      [&] { renderSystem.render(); });
+
   while (!glfwWindowShouldClose(window)) {
     glfwPollEvents();
 
-    scriptingSystem.update(dt);
-
     int w, h;
     glfwGetFramebufferSize(window, &w, &h);
     renderSystem.setViewportSize(w, h);
@@ -85,7 +112,7 @@ int main() {
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    renderSystem.render();
+    scheduler.runFrame();
 
     glfwSwapBuffers(window);
   }
@@ -107,7 +134,9 @@ int main() {
   // World newWorld;
   // ResourceManager newRM;
   // if (loadScene(newWorld, newRM, "scene.json")) {
-  //     RenderSystem rs2(&newWorld, &newRM);
+  //     TransformSystem ts2(&newWorld);
+  //     ts2.update();
+  //     RenderSystem rs2(&newWorld, &newRM, &ts2);
   //     std::cout << "Rendering loaded scene:\n";
   //     rs2.render();
   // }
@@ -0,0 +1,264 @@
+// Headless runner: executes N frames of the engine without a window and
+// prints frame and per-system timings. Run from the repository root.
+//
+//   ecs_headless [--frames N] [--entities N] [--scene file.json]
+//                [--threads N] [--dt seconds] [--render WxH]
+//                [--mesh-cache dir] [--vertex-format float|compact]
+//                [--cpu-meshes keep|release] [--memory-budget MB]
+//
+// --threads 0 runs every system on the calling thread. --render draws each
+// frame into an offscreen EGL surface (needs a build with ECS_HAS_EGL).
+// Cooked meshes are kept in --mesh-cache (default cache/meshes), an empty
+// value parses the models on every start. --vertex-format compact uploads
+// quantized 16-byte vertices instead of 32 bytes of floats (with --render).
+// --cpu-meshes release frees the CPU copy of a mesh once it is uploaded.
+// --memory-budget unloads unreferenced models beyond that many megabytes of
+// meshes (0, the default, keeps them all).
+// clang-format off
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include "core/World.hpp"
+#include "ResourceManager.hpp"
+#include "core/ThreadPool.hpp"
+#include "platform/HeadlessGL.hpp"
+#include "serialization/Serialization.hpp"
+#include "system/RenderSystem.hpp"
+#include "system/ScriptingSystem.hpp"
+#include "system/SystemScheduler.hpp"
+#include "system/TransformSystem.hpp"
+// clang-format on
+
+namespace {
+
+struct Options {
+  std::size_t frames = 1000;
+  std::size_t entities = 1000;
+  std::string scene;
+  long threads = -1; // -1: ThreadPool default
+  float dt = 0.016f;
+  int renderWidth = 0;
+  int renderHeight = 0;
+  std::string meshCache = "cache/meshes";
+  bool compactVertices = false;
+  bool releaseCpuMeshes = false;
+  std::size_t memoryBudgetMb = 0;
+};
+
+bool parseOptions(int argc, char **argv, Options &opt) {
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      std::cerr << "Missing value for " << arg << std::endl;
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--frames") {
+      opt.frames = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--entities") {
+      opt.entities = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--scene") {
+      opt.scene = value;
+    } else if (arg == "--threads") {
+      opt.threads = std::strtol(value.c_str(), nullptr, 10);
+    } else if (arg == "--dt") {
+      opt.dt = std::strtof(value.c_str(), nullptr);
+    } else if (arg == "--mesh-cache") {
+      opt.meshCache = value;
+    } else if (arg == "--vertex-format") {
+      if (value != "float" && value != "compact") {
+        std::cerr << "--vertex-format expects float or compact" << std::endl;
+        return false;
+      }
+      opt.compactVertices = value == "compact";
+    } else if (arg == "--cpu-meshes") {
+      if (value != "keep" && value != "release") {
+        std::cerr << "--cpu-meshes expects keep or release" << std::endl;
+        return false;
+      }
+      opt.releaseCpuMeshes = value == "release";
+    } else if (arg == "--memory-budget") {
+      opt.memoryBudgetMb = std::strtoul(value.c_str(), nullptr, 10);
+    } else if (arg == "--render") {
+      if (std::sscanf(value.c_str(), "%dx%d", &opt.renderWidth,
+                      &opt.renderHeight) != 2 ||
+          opt.renderWidth <= 0 || opt.renderHeight <= 0) {
+        std::cerr << "--render expects WxH, e.g. 800x600" << std::endl;
+        return false;
+      }
+    } else {
+      std::cerr << "Unknown option " << arg << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Grid of rats like the one in the demo, all running rotate.lua
+void spawnDemoScene(World &world, ResourceManager &resourceManager,
+                    std::size_t count) {
+  const std::string modelPath = "assets/models/rat.obj";
+  std::shared_ptr<Model> rat = resourceManager.loadModel(modelPath);
+  const std::size_t side = std::max<std::size_t>(
+      1, static_cast<std::size_t>(std::ceil(std::cbrt(double(count)))));
+  for (std::size_t i = 0; i < count; ++i) {
+    Entity e = world.createEntity();
+    TransformComponent tc;
+    tc.position = {float(i % side) - side * 0.5f,
+                   float(i / side % side) - side * 0.5f,
+                   -float(i / (side * side)) * 2.0f - 5.0f};
+    tc.rotation = {0.0f, float(i % 360), 0.0f};
+    tc.scale = {0.05f, 0.05f, 0.05f};
+    world.addComponent(e, tc);
+
+    RenderComponent rc;
+    rc.modelPath = modelPath;
+    rc.model = rat;
+    world.addComponent(e, rc);
+
+    LuaScriptComponent sc;
+    sc.setScriptPath("scripts/rotate.lua");
+    world.addComponent(e, sc);
+  }
+}
+
+double percentile(std::vector<double> sorted, double p) {
+  if (sorted.empty())
+    return 0.0;
+  std::sort(sorted.begin(), sorted.end());
+  std::size_t index = static_cast<std::size_t>(p * (sorted.size() - 1));
+  return sorted[index];
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options opt;
+  if (!parseOptions(argc, argv, opt))
+    return 1;
+
+  const bool render = opt.renderWidth > 0;
+#ifdef ECS_HAS_EGL
+  HeadlessGL gl;
+  if (render) {
+    if (!gl.create(opt.renderWidth, opt.renderHeight))
+      return 1;
+    glEnable(GL_DEPTH_TEST);
+  }
+#else
+  if (render) {
+    std::cerr << "--render needs a build with EGL (ECS_HAS_EGL)" << std::endl;
+    return 1;
+  }
+#endif
+
+  World world;
+  ResourceManager resourceManager;
+  std::unique_ptr<ThreadPool> threadPool;
+  if (opt.threads != 0)
+    threadPool = std::make_unique<ThreadPool>(
+        opt.threads > 0 ? static_cast<std::size_t>(opt.threads) : 0);
+  // Scene models load in the background, frames skip them until ready
+  resourceManager.setThreadPool(threadPool.get());
+  resourceManager.setMeshCacheDir(opt.meshCache);
+  resourceManager.setMemoryBudget(opt.memoryBudgetMb << 20);
+
+  if (!opt.scene.empty()) {
+    if (!loadScene(world, resourceManager, opt.scene))
+      return 1;
+  } else {
+    spawnDemoScene(world, resourceManager, opt.entities);
+  }
+
+  TransformSystem transformSystem(&world);
+  transformSystem.setThreadPool(threadPool.get());
+  ScriptingSystem scriptingSystem(&world);
+  scriptingSystem.init();
+  std::unique_ptr<RenderSystem> renderSystem;
+  if (render) {
+    renderSystem = std::make_unique<RenderSystem>(&world, &resourceManager,
+                                                  &transformSystem);
+    renderSystem->setViewportSize(opt.renderWidth, opt.renderHeight);
+    renderSystem->setCompactVertices(opt.compactVertices);
+    renderSystem->setReleaseCpuData(opt.releaseCpuMeshes);
+  }
+
+  // Same systems and access as the windowed demo
+  SystemScheduler scheduler(threadPool.get());
+  scheduler.addSystem(
+      "scripting",
+      SystemAccess().read<LuaScriptComponent>().write<TransformComponent>(),
+      [&] { scriptingSystem.update(opt.dt); });
+  scheduler.addSystem("transform", SystemAccess().write<TransformComponent>(),
+                      [&] { transformSystem.update(); });
+  if (render)
+    scheduler.addSystem(
+        "render",
+        SystemAccess()
+            .read<TransformComponent>()
+            .write<RenderComponent>()
+            .onMainThread(),
+        [&] {
+          glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+          glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+          renderSystem->render();
+          // Count the rasterization in this frame, not a later one
+          glFinish();
+        });
+
+  std::vector<double> frameMs;
+  frameMs.reserve(opt.frames);
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t f = 0; f < opt.frames; ++f) {
+    auto frameStart = std::chrono::steady_clock::now();
+    scheduler.runFrame();
+    // RenderSystem trims when rendering
+    if (!renderSystem)
+      resourceManager.trim();
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - frameStart;
+    frameMs.push_back(elapsed.count());
+  }
+  std::chrono::duration<double> total =
+      std::chrono::steady_clock::now() - start;
+
+  std::printf("entities: %zu, frames: %zu, workers: %zu, render: %s\n",
+              world.getEntities().size(), opt.frames,
+              threadPool ? threadPool->getWorkerCount() : 0,
+              render ? "offscreen" : "off");
+  if (opt.frames == 0)
+    return 0;
+  std::printf("total %.3f s, %.1f frames/s\n", total.count(),
+              opt.frames / total.count());
+  std::printf("%-12s %10s %10s %10s %10s\n", "", "avg ms", "p50 ms",
+              "p99 ms", "max ms");
+  std::printf("%-12s %10.3f %10.3f %10.3f %10.3f\n", "frame",
+              total.count() * 1000.0 / opt.frames, percentile(frameMs, 0.5),
+              percentile(frameMs, 0.99),
+              *std::max_element(frameMs.begin(), frameMs.end()));
+  for (const SystemScheduler::SystemStats &s : scheduler.getStats()) {
+    if (s.runs == 0)
+      continue;
+    std::printf("%-12s %10.3f %10s %10s %10.3f\n", s.name.c_str(),
+                s.totalSeconds * 1000.0 / s.runs, "-", "-",
+                s.maxSeconds * 1000.0);
+  }
+  if (renderSystem)
+    std::printf("last frame: %zu visible, %zu draws, %zu triangles\n",
+                renderSystem->getLastVisibleCount(),
+                renderSystem->getLastStats().draws,
+                renderSystem->getLastTriangleCount());
+  ResourceManager::MemoryStats memory = resourceManager.getMemoryStats();
+  std::printf("models: %zu, %.2f MB CPU, %.2f MB GPU, %zu unloaded, "
+              "%zu reloaded\n",
+              memory.models, memory.cpuBytes / 1048576.0,
+              memory.gpuBytes / 1048576.0, memory.evictions, memory.reloads);
+  return 0;
+}
@@ -0,0 +1,24 @@
+// Converts scenes between JSON and the binary format. Run from the
+// repository root so model paths in the scene resolve.
+//
+//   ecs_scene_convert input output
+//
+// The input format is detected from the file, output ending with .json is
+// written as JSON, anything else as binary.
+#include "serialization/BinaryScene.hpp"
+#include <iostream>
+#include <string>
+
+int main(int argc, char **argv) {
+  if (argc != 3) {
+    std::cerr << "Usage: ecs_scene_convert input output" << std::endl;
+    return 1;
+  }
+  const std::string output = argv[2];
+  const bool json =
+      output.size() >= 5 && output.compare(output.size() - 5, 5, ".json") == 0;
+  return convertScene(argv[1], output,
+                      json ? SceneFormat::Json : SceneFormat::Binary)
+             ? 0
+             : 1;
+}
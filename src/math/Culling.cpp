@@ -0,0 +1,123 @@
+#include "math/Culling.hpp"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ECS_CULLING_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+std::size_t cullScalar(const Frustum &frustum, const SphereSoA &spheres,
+                       std::size_t begin, std::uint8_t *visible) {
+  std::size_t count = 0;
+  for (std::size_t i = begin; i < spheres.size(); ++i) {
+    bool inside = true;
+    for (const glm::vec4 &p : frustum.planes) {
+      float dist = p.x * spheres.x[i] + p.y * spheres.y[i] +
+                   p.z * spheres.z[i] + p.w;
+      if (dist < -spheres.radius[i]) {
+        inside = false;
+        break;
+      }
+    }
+    visible[i] = inside ? 1 : 0;
+    count += inside;
+  }
+  return count;
+}
+
+#ifdef ECS_CULLING_SSE2
+// Four spheres against all six planes per iteration, no early out
+std::size_t cullSSE2(const Frustum &frustum, const SphereSoA &spheres,
+                     std::uint8_t *visible, std::size_t &done) {
+  __m128 px[6], py[6], pz[6], pw[6];
+  for (int k = 0; k < 6; ++k) {
+    px[k] = _mm_set1_ps(frustum.planes[k].x);
+    py[k] = _mm_set1_ps(frustum.planes[k].y);
+    pz[k] = _mm_set1_ps(frustum.planes[k].z);
+    pw[k] = _mm_set1_ps(frustum.planes[k].w);
+  }
+  const __m128 zero = _mm_setzero_ps();
+  const std::size_t n = spheres.size() / 4 * 4;
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < n; i += 4) {
+    __m128 x = _mm_loadu_ps(spheres.x.data() + i);
+    __m128 y = _mm_loadu_ps(spheres.y.data() + i);
+    __m128 z = _mm_loadu_ps(spheres.z.data() + i);
+    __m128 negRadius =
+        _mm_sub_ps(zero, _mm_loadu_ps(spheres.radius.data() + i));
+    __m128 outside = _mm_setzero_ps();
+    for (int k = 0; k < 6; ++k) {
+      __m128 dist = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(px[k], x), _mm_mul_ps(py[k], y)),
+          _mm_add_ps(_mm_mul_ps(pz[k], z), pw[k]));
+      outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, negRadius));
+    }
+    int bits = _mm_movemask_ps(outside);
+    for (int l = 0; l < 4; ++l) {
+      std::uint8_t in = (bits >> l & 1) ? 0 : 1;
+      visible[i + l] = in;
+      count += in;
+    }
+  }
+  done = n;
+  return count;
+}
+#endif
+
+} // namespace
+
+Frustum extractFrustum(const glm::mat4 &viewProjection) {
+  const glm::mat4 &m = viewProjection;
+  auto row = [&m](int r) {
+    return glm::vec4(m[0][r], m[1][r], m[2][r], m[3][r]);
+  };
+  glm::vec4 r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+  Frustum f;
+  f.planes[0] = r3 + r0;
+  f.planes[1] = r3 - r0;
+  f.planes[2] = r3 + r1;
+  f.planes[3] = r3 - r1;
+  f.planes[4] = r3 + r2;
+  f.planes[5] = r3 - r2;
+  for (glm::vec4 &p : f.planes) {
+    float len = std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+    if (len > 0.0f)
+      p = p / len;
+  }
+  return f;
+}
+
+void transformSphere(const glm::mat4 &model, const glm::vec3 &center,
+                     float radius, glm::vec3 &outCenter, float &outRadius) {
+  glm::vec4 c = model * glm::vec4(center, 1.0f);
+  outCenter = glm::vec3(c.x, c.y, c.z);
+  float scale2 = 0.0f;
+  for (int col = 0; col < 3; ++col) {
+    glm::vec3 axis(model[col][0], model[col][1], model[col][2]);
+    scale2 = std::max(scale2, glm::dot(axis, axis));
+  }
+  outRadius = radius * std::sqrt(scale2);
+}
+
+std::size_t cullSpheres(const Frustum &frustum, const SphereSoA &spheres,
+                        std::uint8_t *visible) {
+  static const SimdLevel level = detectSimdLevel();
+  return cullSpheres(level, frustum, spheres, visible);
+}
+
+std::size_t cullSpheres(SimdLevel level, const Frustum &frustum,
+                        const SphereSoA &spheres, std::uint8_t *visible) {
+  std::size_t done = 0;
+  std::size_t count = 0;
+#ifdef ECS_CULLING_SSE2
+  if (level >= SimdLevel::SSE2)
+    count = cullSSE2(frustum, spheres, visible, done);
+#else
+  (void)level;
+#endif
+  return count + cullScalar(frustum, spheres, done, visible);
+}
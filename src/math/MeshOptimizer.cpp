@@ -0,0 +1,228 @@
+#include "math/MeshOptimizer.hpp"
+#include <algorithm>
+#include <glm/glm.hpp>
+
+namespace {
+
+// Tipsify state: triangles around each vertex and how many of them are not
+// emitted yet
+struct Adjacency {
+  std::vector<unsigned int> offsets; // vertexCount + 1
+  std::vector<unsigned int> triangles;
+  std::vector<unsigned int> live;
+
+  Adjacency(const std::vector<unsigned int> &indices, std::size_t vertexCount)
+      : offsets(vertexCount + 1, 0), triangles(indices.size()),
+        live(vertexCount, 0) {
+    for (unsigned int v : indices)
+      ++live[v];
+    for (std::size_t v = 0; v < vertexCount; ++v)
+      offsets[v + 1] = offsets[v] + live[v];
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < indices.size(); ++i)
+      triangles[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+  }
+};
+
+} // namespace
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int> &indices,
+                                    std::size_t vertexCount,
+                                    unsigned cacheSize) {
+  VertexCacheStats stats;
+  if (indices.size() < 3 || vertexCount == 0)
+    return stats;
+  // A vertex is cached while fewer than cacheSize misses followed its own
+  std::vector<std::size_t> missTime(vertexCount, 0);
+  std::size_t time = cacheSize + 1;
+  std::size_t misses = 0;
+  for (unsigned int v : indices) {
+    if (time - missTime[v] > cacheSize) {
+      missTime[v] = time++;
+      ++misses;
+    }
+  }
+  stats.acmr = float(misses) / float(indices.size() / 3);
+  stats.atvr = float(misses) / float(vertexCount);
+  return stats;
+}
+
+std::vector<unsigned int>
+optimizeVertexCache(const std::vector<unsigned int> &indices,
+                    std::size_t vertexCount, unsigned cacheSize,
+                    std::vector<std::size_t> *clusterStarts) {
+  if (clusterStarts)
+    clusterStarts->clear();
+  std::vector<unsigned int> out;
+  if (indices.size() < 3 || vertexCount == 0)
+    return indices;
+  out.reserve(indices.size());
+
+  Adjacency adjacency(indices, vertexCount);
+  std::vector<unsigned int> &live = adjacency.live;
+  std::vector<std::size_t> missTime(vertexCount, 0);
+  std::size_t time = cacheSize + 1;
+  std::vector<char> emitted(indices.size() / 3, 0);
+  std::vector<unsigned int> deadEnds; // recently emitted, newest last
+  deadEnds.reserve(indices.size());
+  std::vector<unsigned int> candidates;
+  std::size_t scan = 0;
+
+  auto inCache = [&](unsigned int v) {
+    return time - missTime[v] <= cacheSize;
+  };
+  // Next vertex with triangles left: the latest emitted one, else the first
+  // in index order
+  auto skipDeadEnd = [&]() -> long {
+    while (!deadEnds.empty()) {
+      unsigned int v = deadEnds.back();
+      deadEnds.pop_back();
+      if (live[v] > 0)
+        return v;
+    }
+    for (; scan < vertexCount; ++scan)
+      if (live[scan] > 0)
+        return static_cast<long>(scan);
+    return -1;
+  };
+
+  long fanning = skipDeadEnd();
+  bool jumped = true;
+  while (fanning >= 0) {
+    // A cluster starts where the cache went cold
+    if (jumped && clusterStarts && !inCache(unsigned(fanning)))
+      clusterStarts->push_back(out.size());
+    candidates.clear();
+    for (unsigned int k = adjacency.offsets[fanning];
+         k < adjacency.offsets[fanning + 1]; ++k) {
+      unsigned int t = adjacency.triangles[k];
+      if (emitted[t])
+        continue;
+      emitted[t] = 1;
+      for (int c = 0; c < 3; ++c) {
+        unsigned int v = indices[t * 3 + c];
+        out.push_back(v);
+        deadEnds.push_back(v);
+        candidates.push_back(v);
+        --live[v];
+        if (!inCache(v))
+          missTime[v] = time++;
+      }
+    }
+    // Prefer the oldest cached vertex whose remaining fan still fits
+    long next = -1;
+    long bestPriority = -1;
+    for (unsigned int v : candidates) {
+      if (live[v] == 0)
+        continue;
+      long priority = 0;
+      if (time - missTime[v] + 2 * live[v] <= cacheSize)
+        priority = static_cast<long>(time - missTime[v]);
+      if (priority > bestPriority) {
+        bestPriority = priority;
+        next = v;
+      }
+    }
+    jumped = next < 0;
+    fanning = jumped ? skipDeadEnd() : next;
+  }
+  if (clusterStarts && (clusterStarts->empty() || clusterStarts->front() != 0))
+    clusterStarts->insert(clusterStarts->begin(), 0);
+  return out;
+}
+
+void optimizeOverdraw(Model &model,
+                      const std::vector<std::size_t> &clusterStarts,
+                      float threshold) {
+  std::vector<unsigned int> &indices = model.indices;
+  const std::size_t clusterCount = clusterStarts.size();
+  if (clusterCount < 2)
+    return;
+  auto clusterEnd = [&](std::size_t c) {
+    return c + 1 < clusterCount ? clusterStarts[c + 1] : indices.size();
+  };
+
+  // Area-weighted centers and normals
+  std::vector<glm::vec3> centers(clusterCount, glm::vec3(0.0f));
+  std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+  std::vector<float> areas(clusterCount, 0.0f);
+  glm::vec3 meshCenter(0.0f);
+  float meshArea = 0.0f;
+  for (std::size_t c = 0; c < clusterCount; ++c) {
+    for (std::size_t i = clusterStarts[c]; i < clusterEnd(c); i += 3) {
+      glm::vec3 a = model.position(indices[i]);
+      glm::vec3 b = model.position(indices[i + 1]);
+      glm::vec3 d = model.position(indices[i + 2]);
+      glm::vec3 n = glm::cross(b - a, d - a);
+      float area = glm::length(n);
+      centers[c] += (a + b + d) * (area / 3.0f);
+      normals[c] += n;
+      areas[c] += area;
+    }
+    meshCenter += centers[c];
+    meshArea += areas[c];
+  }
+  if (meshArea <= 0.0f)
+    return;
+  meshCenter /= meshArea;
+
+  std::vector<float> keys(clusterCount, 0.0f);
+  for (std::size_t c = 0; c < clusterCount; ++c) {
+    float length = glm::length(normals[c]);
+    if (areas[c] > 0.0f && length > 0.0f)
+      keys[c] = glm::dot(normals[c] / length,
+                         centers[c] / areas[c] - meshCenter);
+  }
+  std::vector<std::size_t> order(clusterCount);
+  for (std::size_t c = 0; c < clusterCount; ++c)
+    order[c] = c;
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::size_t a, std::size_t b) {
+                     return keys[a] > keys[b];
+                   });
+
+  std::vector<unsigned int> sorted;
+  sorted.reserve(indices.size());
+  for (std::size_t c : order)
+    sorted.insert(sorted.end(), indices.begin() + clusterStarts[c],
+                  indices.begin() + clusterEnd(c));
+  const std::size_t vertexCount = model.vertexCount();
+  if (analyzeVertexCache(sorted, vertexCount).acmr <=
+      analyzeVertexCache(indices, vertexCount).acmr * threshold)
+    indices.swap(sorted);
+}
+
+void optimizeVertexFetch(Model &model) {
+  const unsigned int unused = ~0u;
+  std::vector<unsigned int> remap(model.vertexCount(), unused);
+  std::vector<float> vertices;
+  vertices.reserve(model.vertices.size());
+  unsigned int next = 0;
+  for (unsigned int &v : model.indices) {
+    if (remap[v] == unused) {
+      remap[v] = next++;
+      const float *src = &model.vertices[v * Model::VERTEX_FLOATS];
+      vertices.insert(vertices.end(), src, src + Model::VERTEX_FLOATS);
+    }
+    v = remap[v];
+  }
+  model.vertices.swap(vertices);
+}
+
+MeshOptimizeStats optimizeMesh(Model &model) {
+  MeshOptimizeStats stats;
+  stats.before = analyzeVertexCache(model.indices, model.vertexCount());
+  std::vector<std::size_t> clusterStarts;
+  std::vector<unsigned int> reordered = optimizeVertexCache(
+      model.indices, model.vertexCount(), VERTEX_CACHE_SIZE, &clusterStarts);
+  // Files exported in a good order can beat the greedy fans, keep those
+  if (analyzeVertexCache(reordered, model.vertexCount()).acmr <
+      stats.before.acmr) {
+    model.indices.swap(reordered);
+    optimizeOverdraw(model, clusterStarts);
+    stats.clusters = clusterStarts.size();
+  }
+  optimizeVertexFetch(model);
+  stats.after = analyzeVertexCache(model.indices, model.vertexCount());
+  return stats;
+}
@@ -0,0 +1,300 @@
+#include "math/MeshSimplifier.hpp"
+#include "core/FlatHashMap.hpp"
+#include "math/MeshOptimizer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+// Sum of area-weighted squared distances to planes, as the symmetric 4x4
+// matrix of the paper, plus the summed weight to turn it into a mean
+struct Quadric {
+  double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+  double a11 = 0, a12 = 0, a13 = 0;
+  double a22 = 0, a23 = 0;
+  double a33 = 0;
+  double weight = 0;
+
+  // Plane dot(n, p) + d = 0 with unit n
+  void addPlane(const glm::vec3 &n, double d, double w) {
+    a00 += w * n.x * n.x;
+    a01 += w * n.x * n.y;
+    a02 += w * n.x * n.z;
+    a03 += w * n.x * d;
+    a11 += w * n.y * n.y;
+    a12 += w * n.y * n.z;
+    a13 += w * n.y * d;
+    a22 += w * n.z * n.z;
+    a23 += w * n.z * d;
+    a33 += w * d * d;
+    weight += w;
+  }
+
+  Quadric operator+(const Quadric &o) const {
+    Quadric q = *this;
+    q += o;
+    return q;
+  }
+  Quadric &operator+=(const Quadric &o) {
+    a00 += o.a00, a01 += o.a01, a02 += o.a02, a03 += o.a03;
+    a11 += o.a11, a12 += o.a12, a13 += o.a13;
+    a22 += o.a22, a23 += o.a23;
+    a33 += o.a33;
+    weight += o.weight;
+    return *this;
+  }
+
+  // Mean squared distance of p to the planes
+  double error(const glm::vec3 &p) const {
+    if (weight <= 0.0)
+      return 0.0;
+    const double x = p.x, y = p.y, z = p.z;
+    double e = a00 * x * x + a11 * y * y + a22 * z * z + a33 +
+               2.0 * (a01 * x * y + a02 * x * z + a12 * y * z + a03 * x +
+                      a13 * y + a23 * z);
+    return std::max(e, 0.0) / weight;
+  }
+};
+
+struct PositionKey {
+  float x, y, z;
+
+  bool operator==(const PositionKey &) const = default;
+};
+
+struct PositionKeyHash {
+  std::size_t operator()(const PositionKey &k) const noexcept {
+    // + 0.0f folds -0 into 0, which compares equal
+    float values[3] = {k.x + 0.0f, k.y + 0.0f, k.z + 0.0f};
+    std::uint32_t bits[3];
+    std::memcpy(bits, values, sizeof(bits));
+    std::uint64_t h = bits[0] * 0x9e3779b97f4a7c15ull;
+    h ^= (std::uint64_t(bits[1]) << 32 | bits[2]) * 0xc2b2ae3d27d4eb4full;
+    return static_cast<std::size_t>(h ^ (h >> 29));
+  }
+};
+
+struct EdgeHash {
+  std::size_t operator()(std::uint64_t k) const noexcept {
+    k *= 0x9e3779b97f4a7c15ull;
+    return static_cast<std::size_t>(k ^ (k >> 29));
+  }
+};
+
+std::uint64_t edgeKey(unsigned int a, unsigned int b) {
+  return std::uint64_t(a) << 32 | b;
+}
+
+struct Collapse {
+  unsigned int from;
+  unsigned int to;
+  double cost;
+};
+
+} // namespace
+
+std::vector<unsigned int> simplifyMesh(const Model &model,
+                                       const std::vector<unsigned int> &indices,
+                                       std::size_t targetIndexCount,
+                                       float maxError, float *error) {
+  if (error)
+    *error = 0.0f;
+  std::vector<unsigned int> result = indices;
+  const std::size_t vertexCount = model.vertexCount();
+  if (result.size() <= targetIndexCount || vertexCount == 0)
+    return result;
+
+  // First vertex at each position; seams put several vertices there
+  std::vector<unsigned int> position(vertexCount);
+  std::vector<unsigned int> wedges(vertexCount, 0);
+  FlatHashMap<PositionKey, unsigned int, PositionKeyHash> positions(
+      vertexCount);
+  for (std::size_t v = 0; v < vertexCount; ++v) {
+    glm::vec3 p = model.position(v);
+    auto [first, inserted] = positions.tryEmplace(
+        {p.x, p.y, p.z}, static_cast<unsigned int>(v));
+    position[v] = *first;
+    ++wedges[*first];
+  }
+
+  // Positions on seams, open borders and non-manifold edges stay put
+  std::vector<char> locked(vertexCount, 0);
+  for (std::size_t v = 0; v < vertexCount; ++v)
+    locked[v] = wedges[v] > 1;
+  FlatHashMap<std::uint64_t, unsigned int, EdgeHash> edges(result.size());
+  for (std::size_t i = 0; i < result.size(); i += 3)
+    for (int k = 0; k < 3; ++k)
+      ++*edges
+             .tryEmplace(edgeKey(position[result[i + k]],
+                                 position[result[i + (k + 1) % 3]]),
+                         0u)
+             .first;
+  for (std::size_t i = 0; i < result.size(); i += 3)
+    for (int k = 0; k < 3; ++k) {
+      unsigned int a = position[result[i + k]];
+      unsigned int b = position[result[i + (k + 1) % 3]];
+      const unsigned int *reverse = edges.find(edgeKey(b, a));
+      if (*edges.find(edgeKey(a, b)) != 1 || !reverse || *reverse != 1)
+        locked[a] = locked[b] = 1;
+    }
+
+  std::vector<Quadric> quadrics(vertexCount);
+  for (std::size_t i = 0; i < result.size(); i += 3) {
+    glm::vec3 p0 = model.position(result[i]);
+    glm::vec3 p1 = model.position(result[i + 1]);
+    glm::vec3 p2 = model.position(result[i + 2]);
+    glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+    float length = glm::length(n);
+    if (!(length > 0.0f))
+      continue;
+    n /= length;
+    for (int k = 0; k < 3; ++k)
+      quadrics[position[result[i + k]]].addPlane(n, -glm::dot(n, p0),
+                                                 length * 0.5);
+  }
+
+  const double limit = double(maxError) * model.boundsRadius;
+  double reached = 0.0; // squared
+  std::vector<unsigned int> offsets(vertexCount + 1);
+  std::vector<unsigned int> around;
+  std::vector<unsigned int> remap(vertexCount);
+  std::vector<char> touched(vertexCount);
+  std::vector<Collapse> collapses;
+
+  // Whether moving from onto to turns one of from's remaining triangles over
+  auto flips = [&](unsigned int from, unsigned int to) {
+    const glm::vec3 target = model.position(to);
+    for (unsigned int k = offsets[from]; k < offsets[from + 1]; ++k) {
+      const unsigned int *t = &result[around[k] * 3];
+      if (t[0] == to || t[1] == to || t[2] == to)
+        continue; // collapses away
+      glm::vec3 p[3], q[3];
+      for (int j = 0; j < 3; ++j) {
+        p[j] = model.position(t[j]);
+        q[j] = t[j] == from ? target : p[j];
+      }
+      glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+      glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+      if (glm::dot(before, after) <= 0.0f)
+        return true;
+    }
+    return false;
+  };
+
+  // Passes of independent collapses, cheapest first. A pass only takes
+  // collapses under passLimit, which doubles up to limit whenever nothing is
+  // left under it: without that, one pass would take expensive collapses
+  // that later passes could have avoided.
+  double passLimit = limit / 256.0;
+  while (result.size() > targetIndexCount) {
+    std::fill(offsets.begin(), offsets.end(), 0);
+    for (unsigned int v : result)
+      ++offsets[v + 1];
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    around.resize(result.size());
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for (std::size_t i = 0; i < result.size(); ++i)
+      around[fill[result[i]]++] = static_cast<unsigned int>(i / 3);
+
+    // Interior edges show up in both directions, from both triangles
+    collapses.clear();
+    for (std::size_t i = 0; i < result.size(); i += 3)
+      for (int k = 0; k < 3; ++k) {
+        unsigned int from = result[i + k];
+        unsigned int to = result[i + (k + 1) % 3];
+        if (locked[position[from]])
+          continue;
+        Quadric q = quadrics[position[from]] + quadrics[position[to]];
+        collapses.push_back({from, to, q.error(model.position(to))});
+      }
+    // Only the collapses the pass may take need an order
+    auto over = std::partition(
+        collapses.begin(), collapses.end(),
+        [&](const Collapse &c) { return c.cost <= passLimit * passLimit; });
+    double nextCost = -1.0; // cheapest collapse over passLimit
+    for (auto it = over; it != collapses.end(); ++it)
+      if (nextCost < 0.0 || it->cost < nextCost)
+        nextCost = it->cost;
+    std::sort(collapses.begin(), over,
+              [](const Collapse &a, const Collapse &b) {
+                if (a.cost != b.cost)
+                  return a.cost < b.cost;
+                return a.from != b.from ? a.from < b.from : a.to < b.to;
+              });
+
+    std::iota(remap.begin(), remap.end(), 0u);
+    std::fill(touched.begin(), touched.end(), 0);
+    const std::size_t excess = (result.size() - targetIndexCount) / 3;
+    std::size_t removed = 0;
+    std::size_t applied = 0;
+    for (auto it = collapses.begin(); it != over && removed < excess; ++it) {
+      const Collapse &c = *it;
+      if (touched[c.from] || touched[c.to] || flips(c.from, c.to))
+        continue;
+      // Neighbours are frozen for the pass, their flip tests would see
+      // stale triangles
+      for (unsigned int k = offsets[c.from]; k < offsets[c.from + 1]; ++k) {
+        const unsigned int *t = &result[around[k] * 3];
+        removed += t[0] == c.to || t[1] == c.to || t[2] == c.to;
+        touched[t[0]] = touched[t[1]] = touched[t[2]] = 1;
+      }
+      remap[c.from] = c.to;
+      quadrics[position[c.to]] += quadrics[position[c.from]];
+      reached = std::max(reached, c.cost);
+      ++applied;
+    }
+    if (applied == 0) {
+      // Straight to the next cost instead of rebuilding for nothing
+      if (nextCost < 0.0 || nextCost > limit * limit)
+        break;
+      passLimit = std::min(std::max(passLimit * 2.0, std::sqrt(nextCost)),
+                           limit);
+      continue;
+    }
+
+    std::size_t out = 0;
+    for (std::size_t i = 0; i < result.size(); i += 3) {
+      unsigned int a = remap[result[i]];
+      unsigned int b = remap[result[i + 1]];
+      unsigned int c = remap[result[i + 2]];
+      if (a == b || b == c || a == c)
+        continue;
+      result[out++] = a;
+      result[out++] = b;
+      result[out++] = c;
+    }
+    result.resize(out);
+  }
+
+  if (error && model.boundsRadius > 0.0f)
+    *error = static_cast<float>(std::sqrt(reached) / model.boundsRadius);
+  return result;
+}
+
+void generateLods(Model &model) {
+  const std::vector<unsigned int> full = model.indices;
+  model.lods.assign(1, {0, static_cast<std::uint32_t>(full.size()), 0.0f});
+  std::size_t previous = full.size();
+  float previousError = 0.0f;
+  for (std::size_t level = 1; level < Model::MAX_LODS; ++level) {
+    std::size_t target = full.size() >> level;
+    target -= target % 3;
+    float error = 0.0f;
+    std::vector<unsigned int> lod =
+        simplifyMesh(model, full, target, MAX_LOD_ERROR, &error);
+    if (lod.empty() || lod.size() * 10 > previous * 9)
+      break;
+    lod = optimizeVertexCache(lod, model.vertexCount());
+    // Greedy collapses may reach a coarser level with less error, selection
+    // expects it to grow with the level
+    previousError = std::max(previousError, error);
+    model.lods.push_back({static_cast<std::uint32_t>(model.indices.size()),
+                          static_cast<std::uint32_t>(lod.size()),
+                          previousError});
+    model.indices.insert(model.indices.end(), lod.begin(), lod.end());
+    previous = lod.size();
+  }
+}
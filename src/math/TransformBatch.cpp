@@ -0,0 +1,91 @@
+#include "math/TransformBatch.hpp"
+#include <cmath>
+
+namespace {
+
+const float DEG_TO_RAD = 0.017453292519943295f;
+
+void composeScalar(const TransformComponent *transforms, std::size_t count,
+                   glm::mat4 *out) {
+  for (std::size_t i = 0; i < count; ++i) {
+    const TransformComponent &tc = transforms[i];
+    float ax = tc.rotation[0] * DEG_TO_RAD;
+    float ay = tc.rotation[1] * DEG_TO_RAD;
+    float az = tc.rotation[2] * DEG_TO_RAD;
+    float sa = std::sin(ax), ca = std::cos(ax);
+    float sb = std::sin(ay), cb = std::cos(ay);
+    float sc = std::sin(az), cc = std::cos(az);
+
+    // Rx * Ry * Rz, column j scaled by scale[j]
+    glm::mat4 &m = out[i];
+    m[0][0] = cb * cc * tc.scale[0];
+    m[0][1] = (sa * sb * cc + ca * sc) * tc.scale[0];
+    m[0][2] = (-ca * sb * cc + sa * sc) * tc.scale[0];
+    m[0][3] = 0.0f;
+    m[1][0] = -cb * sc * tc.scale[1];
+    m[1][1] = (-sa * sb * sc + ca * cc) * tc.scale[1];
+    m[1][2] = (ca * sb * sc + sa * cc) * tc.scale[1];
+    m[1][3] = 0.0f;
+    m[2][0] = sb * tc.scale[2];
+    m[2][1] = -sa * cb * tc.scale[2];
+    m[2][2] = ca * cb * tc.scale[2];
+    m[2][3] = 0.0f;
+    m[3][0] = tc.position[0];
+    m[3][1] = tc.position[1];
+    m[3][2] = tc.position[2];
+    m[3][3] = 1.0f;
+  }
+}
+
+bool cpuHasAVX2() {
+#if (defined(__GNUC__) || defined(__clang__)) &&                              \
+    (defined(__x86_64__) || defined(__i386__))
+  static const bool supported = [] {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  }();
+  return supported;
+#else
+  return false;
+#endif
+}
+
+} // namespace
+
+SimdLevel detectSimdLevel() {
+  if (transform_batch::hasAVX2Kernel() && cpuHasAVX2())
+    return SimdLevel::AVX2;
+  if (transform_batch::hasSSE2Kernel())
+    return SimdLevel::SSE2;
+  return SimdLevel::Scalar;
+}
+
+const char *simdLevelName(SimdLevel level) {
+  switch (level) {
+  case SimdLevel::AVX2:
+    return "avx2";
+  case SimdLevel::SSE2:
+    return "sse2";
+  default:
+    return "scalar";
+  }
+}
+
+void composeModelMatrices(const TransformComponent *transforms,
+                          std::size_t count, glm::mat4 *out) {
+  static const SimdLevel level = detectSimdLevel();
+  composeModelMatrices(level, transforms, count, out);
+}
+
+void composeModelMatrices(SimdLevel level,
+                          const TransformComponent *transforms,
+                          std::size_t count, glm::mat4 *out) {
+  std::size_t done = 0;
+  if (level == SimdLevel::AVX2 && transform_batch::hasAVX2Kernel() &&
+      cpuHasAVX2()) {
+    done = transform_batch::composeAVX2(transforms, count, out);
+  } else if (level >= SimdLevel::SSE2 && transform_batch::hasSSE2Kernel()) {
+    done = transform_batch::composeSSE2(transforms, count, out);
+  }
+  composeScalar(transforms + done, count - done, out + done);
+}
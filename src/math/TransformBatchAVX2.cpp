@@ -0,0 +1,160 @@
+#include "math/TransformBatch.hpp"
+
+// Only called after a runtime CPU check. The TU is compiled for the
+// baseline ISA and just the kernels below are AVX2/FMA (target attribute):
+// with a TU-wide -mavx2, inline functions from headers (glm, std) would be
+// emitted as AVX2 code too, and the linker may keep those copies for the
+// whole program. So the kernels only touch raw floats and intrinsics.
+#if (defined(__GNUC__) || defined(__clang__)) &&                              \
+    (defined(__x86_64__) || defined(__i386__))
+#include <cstdint>
+#include <immintrin.h>
+
+#define AVX2_TARGET __attribute__((target("avx2,fma")))
+
+namespace {
+
+// 8-lane version of sincosDeg from TransformBatchSSE.cpp
+AVX2_TARGET inline void sincosDeg(__m256 deg, __m256 &outSin, __m256 &outCos) {
+  const __m256 signMask = _mm256_castsi256_ps(_mm256_set1_epi32(INT32_MIN));
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i two = _mm256_set1_epi32(2);
+  const __m256i four = _mm256_set1_epi32(4);
+
+  __m256 turns = _mm256_round_ps(
+      _mm256_mul_ps(deg, _mm256_set1_ps(1.0f / 360.0f)),
+      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  deg = _mm256_fnmadd_ps(turns, _mm256_set1_ps(360.0f), deg);
+  __m256 x = _mm256_mul_ps(deg, _mm256_set1_ps(0.017453292519943295f));
+
+  __m256 signSin = _mm256_and_ps(x, signMask);
+  x = _mm256_andnot_ps(signMask, x);
+
+  __m256 y = _mm256_mul_ps(x, _mm256_set1_ps(1.27323954473516f));
+  __m256i j = _mm256_cvttps_epi32(y);
+  j = _mm256_add_epi32(j, one);
+  j = _mm256_and_si256(j, _mm256_set1_epi32(~1));
+  y = _mm256_cvtepi32_ps(j);
+
+  __m256 swapSignSin =
+      _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(j, four), 29));
+  __m256 polyMask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(
+      _mm256_and_si256(j, two), _mm256_setzero_si256()));
+  __m256 signCos = _mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_andnot_si256(_mm256_sub_epi32(j, two), four), 29));
+  signSin = _mm256_xor_ps(signSin, swapSignSin);
+
+  x = _mm256_fmadd_ps(y, _mm256_set1_ps(-0.78515625f), x);
+  x = _mm256_fmadd_ps(y, _mm256_set1_ps(-2.4187564849853515625e-4f), x);
+  x = _mm256_fmadd_ps(y, _mm256_set1_ps(-3.77489497744594108e-8f), x);
+  __m256 z = _mm256_mul_ps(x, x);
+
+  __m256 c = _mm256_set1_ps(2.443315711809948e-5f);
+  c = _mm256_fmadd_ps(c, z, _mm256_set1_ps(-1.388731625493765e-3f));
+  c = _mm256_fmadd_ps(c, z, _mm256_set1_ps(4.166664568298827e-2f));
+  c = _mm256_mul_ps(_mm256_mul_ps(c, z), z);
+  c = _mm256_fnmadd_ps(z, _mm256_set1_ps(0.5f), c);
+  c = _mm256_add_ps(c, _mm256_set1_ps(1.0f));
+
+  __m256 s = _mm256_set1_ps(-1.9515295891e-4f);
+  s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(8.3321608736e-3f));
+  s = _mm256_fmadd_ps(s, z, _mm256_set1_ps(-1.6666654611e-1f));
+  s = _mm256_fmadd_ps(_mm256_mul_ps(s, z), x, x);
+
+  outSin = _mm256_xor_ps(_mm256_blendv_ps(c, s, polyMask), signSin);
+  outCos = _mm256_xor_ps(_mm256_blendv_ps(s, c, polyMask), signCos);
+}
+
+// out: column-major 4x4 float matrices
+AVX2_TARGET inline void storeColumn4(float *out, int col, __m128 x, __m128 y,
+                                     __m128 z, __m128 w) {
+  _MM_TRANSPOSE4_PS(x, y, z, w);
+  _mm_storeu_ps(out + col * 4, x);
+  _mm_storeu_ps(out + 16 + col * 4, y);
+  _mm_storeu_ps(out + 32 + col * 4, z);
+  _mm_storeu_ps(out + 48 + col * 4, w);
+}
+
+// Writes column `col` of eight matrices
+AVX2_TARGET inline void storeColumn(float *out, int col, __m256 x, __m256 y,
+                                    __m256 z, __m256 w) {
+  storeColumn4(out, col, _mm256_castps256_ps128(x), _mm256_castps256_ps128(y),
+               _mm256_castps256_ps128(z), _mm256_castps256_ps128(w));
+  storeColumn4(out + 64, col, _mm256_extractf128_ps(x, 1),
+               _mm256_extractf128_ps(y, 1), _mm256_extractf128_ps(z, 1),
+               _mm256_extractf128_ps(w, 1));
+}
+
+const std::size_t LANES = 8;
+
+// in: position x/y/z, rotation x/y/z, scale x/y/z of eight transforms,
+// one row each. out: eight column-major matrices.
+AVX2_TARGET void composeBatch(const float (*in)[LANES], float *out) {
+  __m256 sa, ca, sb, cb, sc, cc;
+  sincosDeg(_mm256_load_ps(in[3]), sa, ca);
+  sincosDeg(_mm256_load_ps(in[4]), sb, cb);
+  sincosDeg(_mm256_load_ps(in[5]), sc, cc);
+  __m256 scaleX = _mm256_load_ps(in[6]);
+  __m256 scaleY = _mm256_load_ps(in[7]);
+  __m256 scaleZ = _mm256_load_ps(in[8]);
+  const __m256 zero = _mm256_setzero_ps();
+
+  __m256 sasb = _mm256_mul_ps(sa, sb);
+  __m256 casb = _mm256_mul_ps(ca, sb);
+  __m256 r00 = _mm256_mul_ps(cb, cc);
+  __m256 r10 = _mm256_fmadd_ps(sasb, cc, _mm256_mul_ps(ca, sc));
+  __m256 r20 = _mm256_fnmadd_ps(casb, cc, _mm256_mul_ps(sa, sc));
+  __m256 r01 = _mm256_sub_ps(zero, _mm256_mul_ps(cb, sc));
+  __m256 r11 = _mm256_fnmadd_ps(sasb, sc, _mm256_mul_ps(ca, cc));
+  __m256 r21 = _mm256_fmadd_ps(casb, sc, _mm256_mul_ps(sa, cc));
+  __m256 r02 = sb;
+  __m256 r12 = _mm256_sub_ps(zero, _mm256_mul_ps(sa, cb));
+  __m256 r22 = _mm256_mul_ps(ca, cb);
+
+  storeColumn(out, 0, _mm256_mul_ps(r00, scaleX), _mm256_mul_ps(r10, scaleX),
+              _mm256_mul_ps(r20, scaleX), zero);
+  storeColumn(out, 1, _mm256_mul_ps(r01, scaleY), _mm256_mul_ps(r11, scaleY),
+              _mm256_mul_ps(r21, scaleY), zero);
+  storeColumn(out, 2, _mm256_mul_ps(r02, scaleZ), _mm256_mul_ps(r12, scaleZ),
+              _mm256_mul_ps(r22, scaleZ), zero);
+  storeColumn(out, 3, _mm256_load_ps(in[0]), _mm256_load_ps(in[1]),
+              _mm256_load_ps(in[2]), _mm256_set1_ps(1.0f));
+}
+
+} // namespace
+
+namespace transform_batch {
+
+bool hasAVX2Kernel() { return true; }
+
+std::size_t composeAVX2(const TransformComponent *transforms,
+                        std::size_t count, glm::mat4 *out) {
+  const std::size_t batches = count / LANES;
+  alignas(32) float in[9][LANES];
+  for (std::size_t b = 0; b < batches; ++b) {
+    const TransformComponent *t = transforms + b * LANES;
+    for (std::size_t l = 0; l < LANES; ++l) {
+      for (int k = 0; k < 3; ++k) {
+        in[k][l] = t[l].position[k];
+        in[3 + k][l] = t[l].rotation[k];
+        in[6 + k][l] = t[l].scale[k];
+      }
+    }
+    composeBatch(in, &out[b * LANES][0][0]);
+  }
+  return batches * LANES;
+}
+
+} // namespace transform_batch
+
+#else
+
+namespace transform_batch {
+bool hasAVX2Kernel() { return false; }
+std::size_t composeAVX2(const TransformComponent *, std::size_t,
+                        glm::mat4 *) {
+  return 0;
+}
+} // namespace transform_batch
+
+#endif
@@ -0,0 +1,144 @@
+#include "math/TransformBatch.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <cstdint>
+#include <emmintrin.h>
+
+namespace {
+
+// Cephes-style single precision sincos, 4 lanes. Input is in degrees and
+// is first wrapped to [-180, 180] so large accumulated angles stay accurate.
+inline void sincosDeg(__m128 deg, __m128 &outSin, __m128 &outCos) {
+  const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(INT32_MIN));
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i two = _mm_set1_epi32(2);
+  const __m128i four = _mm_set1_epi32(4);
+
+  __m128 turns = _mm_cvtepi32_ps(
+      _mm_cvtps_epi32(_mm_mul_ps(deg, _mm_set1_ps(1.0f / 360.0f))));
+  deg = _mm_sub_ps(deg, _mm_mul_ps(turns, _mm_set1_ps(360.0f)));
+  __m128 x = _mm_mul_ps(deg, _mm_set1_ps(0.017453292519943295f));
+
+  __m128 signSin = _mm_and_ps(x, signMask);
+  x = _mm_andnot_ps(signMask, x);
+
+  // Octant j (rounded up to even) and x - j * pi / 4 in three parts
+  __m128 y = _mm_mul_ps(x, _mm_set1_ps(1.27323954473516f));
+  __m128i j = _mm_cvttps_epi32(y);
+  j = _mm_add_epi32(j, one);
+  j = _mm_and_si128(j, _mm_set1_epi32(~1));
+  y = _mm_cvtepi32_ps(j);
+
+  __m128 swapSignSin =
+      _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, four), 29));
+  __m128 polyMask = _mm_castsi128_ps(
+      _mm_cmpeq_epi32(_mm_and_si128(j, two), _mm_setzero_si128()));
+  __m128 signCos = _mm_castsi128_ps(
+      _mm_slli_epi32(_mm_andnot_si128(_mm_sub_epi32(j, two), four), 29));
+  signSin = _mm_xor_ps(signSin, swapSignSin);
+
+  x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-0.78515625f)));
+  x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-2.4187564849853515625e-4f)));
+  x = _mm_add_ps(x, _mm_mul_ps(y, _mm_set1_ps(-3.77489497744594108e-8f)));
+  __m128 z = _mm_mul_ps(x, x);
+
+  __m128 c = _mm_set1_ps(2.443315711809948e-5f);
+  c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(-1.388731625493765e-3f));
+  c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(4.166664568298827e-2f));
+  c = _mm_mul_ps(_mm_mul_ps(c, z), z);
+  c = _mm_sub_ps(c, _mm_mul_ps(z, _mm_set1_ps(0.5f)));
+  c = _mm_add_ps(c, _mm_set1_ps(1.0f));
+
+  __m128 s = _mm_set1_ps(-1.9515295891e-4f);
+  s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(8.3321608736e-3f));
+  s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(-1.6666654611e-1f));
+  s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), x), x);
+
+  __m128 sinVal =
+      _mm_or_ps(_mm_and_ps(polyMask, s), _mm_andnot_ps(polyMask, c));
+  __m128 cosVal =
+      _mm_or_ps(_mm_and_ps(polyMask, c), _mm_andnot_ps(polyMask, s));
+  outSin = _mm_xor_ps(sinVal, signSin);
+  outCos = _mm_xor_ps(cosVal, signCos);
+}
+
+// Writes column `col` of four matrices from its x, y, z, w lanes
+inline void storeColumn(glm::mat4 *out, int col, __m128 x, __m128 y, __m128 z,
+                        __m128 w) {
+  _MM_TRANSPOSE4_PS(x, y, z, w);
+  _mm_storeu_ps(&out[0][col][0], x);
+  _mm_storeu_ps(&out[1][col][0], y);
+  _mm_storeu_ps(&out[2][col][0], z);
+  _mm_storeu_ps(&out[3][col][0], w);
+}
+
+} // namespace
+
+namespace transform_batch {
+
+bool hasSSE2Kernel() { return true; }
+
+std::size_t composeSSE2(const TransformComponent *transforms,
+                        std::size_t count, glm::mat4 *out) {
+  const std::size_t lanes = 4;
+  const std::size_t batches = count / lanes;
+  alignas(16) float in[9][lanes];
+  for (std::size_t b = 0; b < batches; ++b) {
+    const TransformComponent *t = transforms + b * lanes;
+    // AoS -> SoA
+    for (std::size_t l = 0; l < lanes; ++l) {
+      for (int k = 0; k < 3; ++k) {
+        in[k][l] = t[l].position[k];
+        in[3 + k][l] = t[l].rotation[k];
+        in[6 + k][l] = t[l].scale[k];
+      }
+    }
+    __m128 sa, ca, sb, cb, sc, cc;
+    sincosDeg(_mm_load_ps(in[3]), sa, ca);
+    sincosDeg(_mm_load_ps(in[4]), sb, cb);
+    sincosDeg(_mm_load_ps(in[5]), sc, cc);
+    __m128 scaleX = _mm_load_ps(in[6]);
+    __m128 scaleY = _mm_load_ps(in[7]);
+    __m128 scaleZ = _mm_load_ps(in[8]);
+    const __m128 zero = _mm_setzero_ps();
+
+    // Rx * Ry * Rz, see composeScalar
+    __m128 sasb = _mm_mul_ps(sa, sb);
+    __m128 casb = _mm_mul_ps(ca, sb);
+    __m128 r00 = _mm_mul_ps(cb, cc);
+    __m128 r10 = _mm_add_ps(_mm_mul_ps(sasb, cc), _mm_mul_ps(ca, sc));
+    __m128 r20 = _mm_sub_ps(_mm_mul_ps(sa, sc), _mm_mul_ps(casb, cc));
+    __m128 r01 = _mm_sub_ps(zero, _mm_mul_ps(cb, sc));
+    __m128 r11 = _mm_sub_ps(_mm_mul_ps(ca, cc), _mm_mul_ps(sasb, sc));
+    __m128 r21 = _mm_add_ps(_mm_mul_ps(casb, sc), _mm_mul_ps(sa, cc));
+    __m128 r02 = sb;
+    __m128 r12 = _mm_sub_ps(zero, _mm_mul_ps(sa, cb));
+    __m128 r22 = _mm_mul_ps(ca, cb);
+
+    glm::mat4 *m = out + b * lanes;
+    storeColumn(m, 0, _mm_mul_ps(r00, scaleX), _mm_mul_ps(r10, scaleX),
+                _mm_mul_ps(r20, scaleX), zero);
+    storeColumn(m, 1, _mm_mul_ps(r01, scaleY), _mm_mul_ps(r11, scaleY),
+                _mm_mul_ps(r21, scaleY), zero);
+    storeColumn(m, 2, _mm_mul_ps(r02, scaleZ), _mm_mul_ps(r12, scaleZ),
+                _mm_mul_ps(r22, scaleZ), zero);
+    storeColumn(m, 3, _mm_load_ps(in[0]), _mm_load_ps(in[1]),
+                _mm_load_ps(in[2]), _mm_set1_ps(1.0f));
+  }
+  return batches * lanes;
+}
+
+} // namespace transform_batch
+
+#else
+
+namespace transform_batch {
+bool hasSSE2Kernel() { return false; }
+std::size_t composeSSE2(const TransformComponent *, std::size_t,
+                        glm::mat4 *) {
+  return 0;
+}
+} // namespace transform_batch
+
+#endif
@@ -0,0 +1,124 @@
+#include "math/VertexQuantization.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+PositionQuantization positionQuantization(const Model &model) {
+  PositionQuantization q;
+  q.offset = model.boundsMin;
+  q.scale = model.boundsMax - model.boundsMin;
+  for (int axis = 0; axis < 3; ++axis)
+    if (!(q.scale[axis] > 0.0f))
+      q.scale[axis] = 1.0f;
+  return q;
+}
+
+std::uint16_t floatToHalf(float value) {
+  std::uint32_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const std::uint32_t sign = (bits >> 16) & 0x8000u;
+  const std::uint32_t magnitude = bits & 0x7fffffffu;
+  // Rebias the exponent (127 - 15 = 112) and round the dropped 13 bits
+  std::uint32_t half = (magnitude - (112u << 23) + (1u << 12)) >> 13;
+  if (magnitude < (113u << 23)) // below 2^-14
+    half = 0;
+  if (magnitude >= (143u << 23)) // 2^16 and up, or rounded to it
+    half = 0x7c00u;
+  if (magnitude > 0x7f800000u) // NaN
+    half = 0x7e00u;
+  return static_cast<std::uint16_t>(sign | half);
+}
+
+float halfToFloat(std::uint16_t half) {
+  const std::uint32_t sign = std::uint32_t(half & 0x8000u) << 16;
+  const std::uint32_t exponent = (half >> 10) & 0x1fu;
+  const std::uint32_t mantissa = half & 0x3ffu;
+  if (exponent == 0) {
+    float value = std::ldexp(float(mantissa), -24);
+    return sign ? -value : value;
+  }
+  std::uint32_t bits;
+  if (exponent == 31)
+    bits = sign | 0x7f800000u | (mantissa << 13);
+  else
+    bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+  float value;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+namespace {
+
+float signNotZero(float v) { return v >= 0.0f ? 1.0f : -1.0f; }
+
+std::int16_t toSnorm16(float v) {
+  return static_cast<std::int16_t>(
+      std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
+
+} // namespace
+
+void encodeOctahedral(const glm::vec3 &n, std::int16_t out[2]) {
+  // Project onto the octahedron |x| + |y| + |z| = 1, fold the lower half
+  glm::vec3 p = n / (std::fabs(n.x) + std::fabs(n.y) + std::fabs(n.z));
+  glm::vec2 e(p.x, p.y);
+  if (p.z < 0.0f)
+    e = glm::vec2((1.0f - std::fabs(p.y)) * signNotZero(p.x),
+                  (1.0f - std::fabs(p.x)) * signNotZero(p.y));
+  out[0] = toSnorm16(e.x);
+  out[1] = toSnorm16(e.y);
+}
+
+glm::vec3 decodeOctahedral(const std::int16_t in[2]) {
+  glm::vec2 e(std::max(in[0] / 32767.0f, -1.0f),
+              std::max(in[1] / 32767.0f, -1.0f));
+  glm::vec3 n(e.x, e.y, 1.0f - std::fabs(e.x) - std::fabs(e.y));
+  float t = std::max(-n.z, 0.0f);
+  n.x += n.x >= 0.0f ? -t : t;
+  n.y += n.y >= 0.0f ? -t : t;
+  return glm::normalize(n);
+}
+
+std::vector<CompactVertex> encodeCompactVertices(const Model &model) {
+  const PositionQuantization q = positionQuantization(model);
+  const std::size_t count = model.vertexCount();
+  std::vector<CompactVertex> out(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const float *v = &model.vertices[i * Model::VERTEX_FLOATS];
+    CompactVertex &c = out[i];
+    for (int axis = 0; axis < 3; ++axis) {
+      float unit = (v[axis] - q.offset[axis]) / q.scale[axis];
+      c.position[axis] = static_cast<std::uint16_t>(
+          std::lround(std::clamp(unit, 0.0f, 1.0f) * 65535.0f));
+    }
+    c.position[3] = 0;
+    const float *n = v + Model::NORMAL_OFFSET;
+    glm::vec3 normal(n[0], n[1], n[2]);
+    // Degenerate normals would divide by zero, any direction will do
+    if (!(std::fabs(n[0]) + std::fabs(n[1]) + std::fabs(n[2]) > 0.0f))
+      normal = glm::vec3(0.0f, 0.0f, 1.0f);
+    encodeOctahedral(normal, c.normal);
+    c.texcoord[0] = floatToHalf(v[Model::TEXCOORD_OFFSET]);
+    c.texcoord[1] = floatToHalf(v[Model::TEXCOORD_OFFSET + 1]);
+  }
+  return out;
+}
+
+void decodeCompactVertex(const CompactVertex &vertex,
+                         const PositionQuantization &quantization,
+                         float out[Model::VERTEX_FLOATS]) {
+  for (int axis = 0; axis < 3; ++axis)
+    out[axis] = vertex.position[axis] / 65535.0f * quantization.scale[axis] +
+                quantization.offset[axis];
+  glm::vec3 n = decodeOctahedral(vertex.normal);
+  out[Model::NORMAL_OFFSET] = n.x;
+  out[Model::NORMAL_OFFSET + 1] = n.y;
+  out[Model::NORMAL_OFFSET + 2] = n.z;
+  out[Model::TEXCOORD_OFFSET] = halfToFloat(vertex.texcoord[0]);
+  out[Model::TEXCOORD_OFFSET + 1] = halfToFloat(vertex.texcoord[1]);
+}
+
+std::vector<std::uint16_t>
+narrowIndices(const std::vector<unsigned int> &indices) {
+  return std::vector<std::uint16_t>(indices.begin(), indices.end());
+}
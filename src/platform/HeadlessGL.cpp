@@ -0,0 +1,76 @@
+#ifdef ECS_HAS_EGL
+#include "platform/HeadlessGL.hpp"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <glad/glad.h>
+#include <iostream>
+
+HeadlessGL::~HeadlessGL() {
+  if (!display)
+    return;
+  eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  if (context)
+    eglDestroyContext(display, context);
+  if (surface)
+    eglDestroySurface(display, surface);
+  eglTerminate(display);
+}
+
+bool HeadlessGL::create(int width, int height) {
+  auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+      eglGetProcAddress("eglGetPlatformDisplayEXT"));
+  EGLDisplay dpy = EGL_NO_DISPLAY;
+  if (getPlatformDisplay)
+    dpy = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,
+                             EGL_DEFAULT_DISPLAY, nullptr);
+  if (dpy == EGL_NO_DISPLAY)
+    dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  EGLint major, minor;
+  if (dpy == EGL_NO_DISPLAY || !eglInitialize(dpy, &major, &minor)) {
+    std::cerr << "HeadlessGL: no EGL display" << std::endl;
+    return false;
+  }
+  display = dpy;
+
+  // clang-format off
+  const EGLint configAttribs[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+      EGL_DEPTH_SIZE, 24,
+      EGL_NONE};
+  // clang-format on
+  EGLConfig config;
+  EGLint configCount = 0;
+  if (!eglChooseConfig(dpy, configAttribs, &config, 1, &configCount) ||
+      configCount == 0) {
+    std::cerr << "HeadlessGL: no matching EGL config" << std::endl;
+    return false;
+  }
+  const EGLint surfaceAttribs[] = {EGL_WIDTH, width, EGL_HEIGHT, height,
+                                   EGL_NONE};
+  surface = eglCreatePbufferSurface(dpy, config, surfaceAttribs);
+
+  eglBindAPI(EGL_OPENGL_API);
+  // clang-format off
+  const EGLint contextAttribs[] = {
+      EGL_CONTEXT_MAJOR_VERSION, 3,
+      EGL_CONTEXT_MINOR_VERSION, 3,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+      EGL_NONE};
+  // clang-format on
+  context = eglCreateContext(dpy, config, EGL_NO_CONTEXT, contextAttribs);
+  if (!surface || !context ||
+      !eglMakeCurrent(dpy, surface, surface, context)) {
+    std::cerr << "HeadlessGL: failed to create an OpenGL 3.3 context"
+              << std::endl;
+    return false;
+  }
+  if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+    std::cerr << "HeadlessGL: failed to load GL functions" << std::endl;
+    return false;
+  }
+  glViewport(0, 0, width, height);
+  return true;
+}
+#endif
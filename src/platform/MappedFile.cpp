@@ -0,0 +1,72 @@
+#include "platform/MappedFile.hpp"
+#include <fstream>
+#include <iostream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define ECS_HAS_MMAP 1
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+void MappedFile::close() {
+#ifdef ECS_HAS_MMAP
+  if (mapped)
+    munmap(const_cast<unsigned char *>(bytes), length);
+#endif
+  fallback.clear();
+  fallback.shrink_to_fit();
+  bytes = nullptr;
+  length = 0;
+  mapped = false;
+}
+
+bool MappedFile::open(const std::string &path) {
+  close();
+#ifdef ECS_HAS_MMAP
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "Cannot open file: " << path << std::endl;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    std::cerr << "Cannot stat file: " << path << std::endl;
+    return false;
+  }
+  length = static_cast<std::size_t>(st.st_size);
+  if (length == 0) {
+    // mmap refuses empty files, an empty view is fine
+    ::close(fd);
+    return true;
+  }
+  void *ptr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (ptr == MAP_FAILED) {
+    length = 0;
+    std::cerr << "Cannot map file: " << path << std::endl;
+    return false;
+  }
+  // Read front to back once
+  madvise(ptr, length, MADV_SEQUENTIAL);
+  bytes = static_cast<const unsigned char *>(ptr);
+  mapped = true;
+  return true;
+#else
+  std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+  if (!ifs.is_open()) {
+    std::cerr << "Cannot open file: " << path << std::endl;
+    return false;
+  }
+  fallback.resize(static_cast<std::size_t>(ifs.tellg()));
+  ifs.seekg(0);
+  ifs.read(reinterpret_cast<char *>(fallback.data()), fallback.size());
+  bytes = fallback.data();
+  length = fallback.size();
+  return true;
+#endif
+}
@@ -0,0 +1,371 @@
+#include "serialization/BinaryScene.hpp"
+#include "platform/MappedFile.hpp"
+#include "serialization/Serialization.hpp"
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <vector>
+
+// The file is written and read in host byte order
+static_assert(std::endian::native == std::endian::little,
+              "binary scenes are little-endian");
+
+namespace {
+
+const char MAGIC[4] = {'E', 'C', 'S', 'B'};
+const std::uint32_t NO_PARENT = ~0u;
+const ComponentMask KNOWN_COMPONENTS =
+    componentMask<TransformComponent, RenderComponent, LuaScriptComponent>();
+
+struct Header {
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t entityCount;
+  std::uint32_t groupCount;
+  std::uint32_t stringCount;
+  std::uint32_t reserved;
+  std::uint64_t stringsOffset;
+  std::uint64_t fileSize;
+};
+
+struct Group {
+  std::uint32_t mask;
+  std::uint32_t count;
+  std::uint64_t offset;
+};
+
+// Bytes of one group's data, without the final alignment
+std::uint64_t groupDataSize(ComponentMask mask, std::uint64_t count) {
+  std::uint64_t size = 0;
+  if (mask & componentBit<TransformComponent>())
+    size += count * (9 * sizeof(float) + sizeof(std::uint32_t));
+  if (mask & componentBit<RenderComponent>())
+    size += count * sizeof(std::uint32_t);
+  if (mask & componentBit<LuaScriptComponent>())
+    size += count * sizeof(std::uint32_t);
+  return size;
+}
+
+std::uint64_t align8(std::uint64_t n) { return (n + 7) & ~std::uint64_t(7); }
+
+class Writer {
+public:
+  std::vector<unsigned char> bytes;
+
+  template <typename T> void put(const T &value) {
+    const auto *p = reinterpret_cast<const unsigned char *>(&value);
+    bytes.insert(bytes.end(), p, p + sizeof(T));
+  }
+  void putBytes(const void *data, std::size_t size) {
+    const auto *p = static_cast<const unsigned char *>(data);
+    bytes.insert(bytes.end(), p, p + size);
+  }
+  void pad() { bytes.resize(align8(bytes.size()), 0); }
+};
+
+class StringTable {
+public:
+  std::uint32_t intern(const std::string &s) {
+    auto [it, inserted] =
+        indices.try_emplace(s, static_cast<std::uint32_t>(strings.size()));
+    if (inserted)
+      strings.push_back(s);
+    return it->second;
+  }
+
+  void write(Writer &out) const {
+    std::uint32_t offset = 0;
+    out.put(offset);
+    for (const std::string &s : strings) {
+      offset += static_cast<std::uint32_t>(s.size());
+      out.put(offset);
+    }
+    for (const std::string &s : strings)
+      out.putBytes(s.data(), s.size());
+    out.pad();
+  }
+
+  std::uint32_t size() const {
+    return static_cast<std::uint32_t>(strings.size());
+  }
+
+private:
+  std::unordered_map<std::string, std::uint32_t> indices;
+  std::vector<std::string> strings;
+};
+
+// Typed read access to the mapped file, every accessor checks bounds
+class Reader {
+public:
+  Reader(const unsigned char *data, std::size_t size)
+      : data(data), size(size) {}
+
+  bool contains(std::uint64_t offset, std::uint64_t bytes) const {
+    return offset <= size && bytes <= size - offset;
+  }
+  template <typename T> T read(std::uint64_t offset) const {
+    T value;
+    std::memcpy(&value, data + offset, sizeof(T));
+    return value;
+  }
+  const unsigned char *at(std::uint64_t offset) const { return data + offset; }
+
+private:
+  const unsigned char *data;
+  std::size_t size;
+};
+
+} // namespace
+
+bool saveSceneBinary(const World &world, const std::string &filename) {
+  // One group per non-empty archetype, entity ordinals follow file order
+  std::vector<const Archetype *> groups;
+  std::vector<std::uint32_t> ordinalOf(world.slotCount() + 1, NO_PARENT);
+  std::uint32_t entityCount = 0;
+  for (const Archetype &arch : world.getArchetypes()) {
+    if (arch.size() == 0)
+      continue;
+    groups.push_back(&arch);
+    for (Entity e : arch.entities)
+      ordinalOf[entityIndex(e)] = entityCount++;
+  }
+
+  Writer out;
+  out.bytes.reserve(sizeof(Header) + groups.size() * sizeof(Group) +
+                    entityCount * 48);
+  Header header{};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = BINARY_SCENE_VERSION;
+  header.entityCount = entityCount;
+  header.groupCount = static_cast<std::uint32_t>(groups.size());
+  out.put(header);
+
+  // The group table is patched with the offsets once they are known
+  const std::size_t tableOffset = out.bytes.size();
+  out.bytes.resize(tableOffset + groups.size() * sizeof(Group));
+  out.pad();
+
+  StringTable strings;
+  std::vector<float> floats;
+  std::vector<std::uint32_t> words;
+  for (std::size_t g = 0; g < groups.size(); ++g) {
+    const Archetype &arch = *groups[g];
+    const std::size_t n = arch.size();
+    Group group{arch.mask & KNOWN_COMPONENTS, static_cast<std::uint32_t>(n),
+                out.bytes.size()};
+    std::memcpy(out.bytes.data() + tableOffset + g * sizeof(Group), &group,
+                sizeof(Group));
+
+    if (arch.has<TransformComponent>()) {
+      const auto &col = arch.column<TransformComponent>();
+      for (auto member : {&TransformComponent::position,
+                          &TransformComponent::rotation,
+                          &TransformComponent::scale}) {
+        floats.clear();
+        for (const TransformComponent &tc : col)
+          floats.insert(floats.end(), (tc.*member).begin(),
+                        (tc.*member).end());
+        out.putBytes(floats.data(), floats.size() * sizeof(float));
+      }
+      words.clear();
+      for (const TransformComponent &tc : col)
+        words.push_back(tc.parent != INVALID_ENTITY && world.isAlive(tc.parent)
+                            ? ordinalOf[entityIndex(tc.parent)]
+                            : NO_PARENT);
+      out.putBytes(words.data(), words.size() * sizeof(std::uint32_t));
+    }
+    if (arch.has<RenderComponent>()) {
+      words.clear();
+      for (const RenderComponent &rc : arch.column<RenderComponent>())
+        words.push_back(strings.intern(rc.modelPath));
+      out.putBytes(words.data(), words.size() * sizeof(std::uint32_t));
+    }
+    if (arch.has<LuaScriptComponent>()) {
+      words.clear();
+      for (const LuaScriptComponent &sc : arch.column<LuaScriptComponent>())
+        words.push_back(strings.intern(sc.getScriptPath()));
+      out.putBytes(words.data(), words.size() * sizeof(std::uint32_t));
+    }
+    out.pad();
+  }
+
+  header.stringCount = strings.size();
+  header.stringsOffset = out.bytes.size();
+  strings.write(out);
+  header.fileSize = out.bytes.size();
+  std::memcpy(out.bytes.data(), &header, sizeof(Header));
+
+  std::ofstream ofs(filename, std::ios::binary);
+  if (!ofs.is_open()) {
+    std::cerr << "Cannot open file for saving scene: " << filename << std::endl;
+    return false;
+  }
+  ofs.write(reinterpret_cast<const char *>(out.bytes.data()),
+            static_cast<std::streamsize>(out.bytes.size()));
+  if (!ofs) {
+    std::cerr << "Cannot write scene: " << filename << std::endl;
+    return false;
+  }
+  std::cout << "Scene saved to " << filename << std::endl;
+  return true;
+}
+
+namespace {
+
+// resourceManager null: paths only
+bool loadBinary(World &world, ResourceManager *resourceManager,
+                const std::string &filename) {
+  MappedFile file;
+  if (!file.open(filename))
+    return false;
+  Reader in(file.data(), file.size());
+  auto fail = [&](const char *what) {
+    std::cerr << "Invalid binary scene " << filename << ": " << what
+              << std::endl;
+    return false;
+  };
+
+  if (!in.contains(0, sizeof(Header)))
+    return fail("truncated header");
+  const Header header = in.read<Header>(0);
+  if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+    return fail("bad magic");
+  if (header.version != BINARY_SCENE_VERSION)
+    return fail("unsupported version");
+  if (header.fileSize != file.size())
+    return fail("size mismatch");
+
+  // Strings, checked once so the groups can index them freely
+  const std::uint64_t stringsOffset = header.stringsOffset;
+  const std::uint64_t offsetsBytes =
+      (std::uint64_t(header.stringCount) + 1) * sizeof(std::uint32_t);
+  if (!in.contains(stringsOffset, offsetsBytes))
+    return fail("truncated string table");
+  const std::uint64_t charsOffset = stringsOffset + offsetsBytes;
+  std::vector<std::string> strings(header.stringCount);
+  for (std::uint32_t i = 0; i < header.stringCount; ++i) {
+    auto begin = in.read<std::uint32_t>(stringsOffset + i * 4);
+    auto end = in.read<std::uint32_t>(stringsOffset + (i + 1) * 4);
+    if (end < begin || !in.contains(charsOffset + begin, end - begin))
+      return fail("bad string offsets");
+    strings[i].assign(reinterpret_cast<const char *>(in.at(charsOffset)) +
+                          begin,
+                      end - begin);
+  }
+  // Each model path is requested once, not once per entity. Models are
+  // parsed in the background while the scene loads.
+  std::vector<ModelFuture> models(header.stringCount);
+
+  if (!in.contains(sizeof(Header),
+                   std::uint64_t(header.groupCount) * sizeof(Group)))
+    return fail("truncated group table");
+
+  std::vector<Entity> created;
+  created.reserve(header.entityCount);
+  std::vector<std::pair<Entity, std::uint32_t>> parentLinks;
+  std::uint64_t total = 0;
+  for (std::uint32_t g = 0; g < header.groupCount; ++g) {
+    const Group group = in.read<Group>(sizeof(Header) + g * sizeof(Group));
+    const std::uint64_t n = group.count;
+    total += n;
+    if ((group.mask & ~KNOWN_COMPONENTS) != 0)
+      return fail("unknown component");
+    if (total > header.entityCount ||
+        !in.contains(group.offset, groupDataSize(group.mask, n)))
+      return fail("truncated group");
+
+    const std::size_t first = created.size();
+    Archetype *arch = world.createEntities(group.mask, n, created);
+    if (!arch)
+      return false;
+    const std::size_t firstRow = arch->size() - n;
+
+    std::uint64_t offset = group.offset;
+    if (group.mask & componentBit<TransformComponent>()) {
+      auto &col = arch->column<TransformComponent>();
+      for (auto member : {&TransformComponent::position,
+                          &TransformComponent::rotation,
+                          &TransformComponent::scale}) {
+        const unsigned char *src = in.at(offset);
+        for (std::size_t i = 0; i < n; ++i)
+          std::memcpy((col[firstRow + i].*member).data(),
+                      src + i * 3 * sizeof(float), 3 * sizeof(float));
+        offset += n * 3 * sizeof(float);
+      }
+      for (std::size_t i = 0; i < n; ++i) {
+        auto parent = in.read<std::uint32_t>(offset + i * 4);
+        if (parent != NO_PARENT)
+          parentLinks.emplace_back(created[first + i], parent);
+      }
+      offset += n * sizeof(std::uint32_t);
+    }
+    if (group.mask & componentBit<RenderComponent>()) {
+      auto &col = arch->column<RenderComponent>();
+      for (std::size_t i = 0; i < n; ++i) {
+        auto index = in.read<std::uint32_t>(offset + i * 4);
+        if (index >= strings.size())
+          return fail("bad model path index");
+        RenderComponent &rc = col[firstRow + i];
+        rc.modelPath = strings[index];
+        if (!resourceManager)
+          continue;
+        if (!models[index].valid())
+          models[index] = resourceManager->loadModelAsync(strings[index]);
+        rc.pendingModel = models[index];
+        rc.resolveModel();
+      }
+      offset += n * sizeof(std::uint32_t);
+    }
+    if (group.mask & componentBit<LuaScriptComponent>()) {
+      auto &col = arch->column<LuaScriptComponent>();
+      for (std::size_t i = 0; i < n; ++i) {
+        auto index = in.read<std::uint32_t>(offset + i * 4);
+        if (index >= strings.size())
+          return fail("bad script path index");
+        col[firstRow + i].setScriptPath(strings[index]);
+      }
+    }
+  }
+
+  if (total != header.entityCount)
+    return fail("entity count mismatch");
+
+  for (const auto &[child, parent] : parentLinks) {
+    if (parent >= created.size() || !world.setParent(child, created[parent]))
+      std::cerr << "Invalid parent " << parent << " in " << filename
+                << std::endl;
+  }
+
+  std::cout << "Scene loaded from " << filename << std::endl;
+  return true;
+}
+
+} // namespace
+
+bool loadSceneBinary(World &world, ResourceManager &resourceManager,
+                     const std::string &filename) {
+  return loadBinary(world, &resourceManager, filename);
+}
+
+bool loadSceneBinary(World &world, const std::string &filename) {
+  return loadBinary(world, nullptr, filename);
+}
+
+bool isBinaryScene(const std::string &filename) {
+  std::ifstream ifs(filename, std::ios::binary);
+  char magic[4] = {};
+  return ifs.read(magic, sizeof(magic)) &&
+         std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool convertScene(const std::string &from, const std::string &to,
+                  SceneFormat format) {
+  // Only the paths are converted, no model is loaded
+  World world;
+  if (!loadScene(world, from))
+    return false;
+  return format == SceneFormat::Binary ? saveSceneBinary(world, to)
+                                       : saveScene(world, to);
+}
@@ -0,0 +1,311 @@
+#include "serialization/CookedMesh.hpp"
+#include "platform/MappedFile.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// The file is written and read in host byte order
+static_assert(std::endian::native == std::endian::little,
+              "cooked meshes are little-endian");
+
+namespace {
+
+const char MAGIC[4] = {'E', 'C', 'S', 'M'};
+
+struct Header {
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t vertexCount;
+  std::uint32_t indexCount;
+  std::uint32_t materialCount;
+  std::uint32_t lodCount;
+  std::uint64_t sourceSize;
+  std::int64_t sourceMtime;
+  std::uint64_t sourceHash;
+  float bounds[10]; // min, max, center, radius
+  std::uint64_t fileSize;
+};
+
+struct LodRecord {
+  std::uint32_t indexOffset;
+  std::uint32_t indexCount;
+  float error;
+  std::uint32_t reserved;
+};
+
+struct MaterialColors {
+  float diffuse[3];
+  float ambient[3];
+  float specular[3];
+  float shininess;
+};
+
+std::uint64_t align8(std::uint64_t n) { return (n + 7) & ~std::uint64_t(7); }
+
+std::uint64_t fnv1a(const unsigned char *data, std::size_t size) {
+  std::uint64_t h = 0xcbf29ce484222325ull;
+  for (std::size_t i = 0; i < size; ++i) {
+    h ^= data[i];
+    h *= 0x100000001b3ull;
+  }
+  return h;
+}
+
+class Writer {
+public:
+  std::vector<unsigned char> bytes;
+
+  template <typename T> void put(const T &value) {
+    putBytes(&value, sizeof(T));
+  }
+  void putBytes(const void *data, std::size_t size) {
+    const auto *p = static_cast<const unsigned char *>(data);
+    bytes.insert(bytes.end(), p, p + size);
+  }
+  void putString(const std::string &s) {
+    put(static_cast<std::uint32_t>(s.size()));
+    putBytes(s.data(), s.size());
+  }
+  void pad() { bytes.resize(align8(bytes.size()), 0); }
+};
+
+// Sequential reads that fail instead of running past the end
+class Reader {
+public:
+  Reader(const unsigned char *data, std::size_t size)
+      : data(data), size(size) {}
+
+  bool bytes(void *dst, std::uint64_t count) {
+    if (count > size - offset)
+      return false;
+    std::memcpy(dst, data + offset, count);
+    offset += count;
+    return true;
+  }
+  template <typename T> bool read(T &value) { return bytes(&value, sizeof(T)); }
+  bool string(std::string &s) {
+    std::uint32_t length;
+    if (!read(length) || length > size - offset)
+      return false;
+    s.assign(reinterpret_cast<const char *>(data + offset), length);
+    offset += length;
+    return true;
+  }
+  bool align() {
+    offset = std::min<std::uint64_t>(align8(offset), size);
+    return true;
+  }
+
+private:
+  const unsigned char *data;
+  std::uint64_t size;
+  std::uint64_t offset = 0;
+};
+
+} // namespace
+
+bool readMeshSourceKey(const std::string &sourcePath, MeshSourceKey &out) {
+  std::error_code ec;
+  auto mtime = std::filesystem::last_write_time(sourcePath, ec);
+  if (ec)
+    return false;
+  MappedFile file;
+  if (!file.open(sourcePath))
+    return false;
+  out.size = file.size();
+  out.mtime = static_cast<std::int64_t>(mtime.time_since_epoch().count());
+  out.hash = fnv1a(file.data(), file.size());
+  return true;
+}
+
+std::string cookedMeshPath(const std::string &cacheDir,
+                           const std::string &sourcePath) {
+  // The path hash tells apart sources with the same file name
+  char suffix[32];
+  std::snprintf(suffix, sizeof(suffix), ".%016llx.mesh",
+                static_cast<unsigned long long>(fnv1a(
+                    reinterpret_cast<const unsigned char *>(sourcePath.data()),
+                    sourcePath.size())));
+  std::filesystem::path name =
+      std::filesystem::path(sourcePath).filename().string() + suffix;
+  return (std::filesystem::path(cacheDir) / name).string();
+}
+
+bool saveCookedMesh(const Model &model, const MeshSourceKey &key,
+                    const std::string &filename) {
+  Writer out;
+  out.bytes.reserve(sizeof(Header) + model.vertices.size() * sizeof(float) +
+                    model.indices.size() * sizeof(std::uint32_t) + 256);
+  Header header{};
+  std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+  header.version = COOKED_MESH_VERSION;
+  header.vertexCount = static_cast<std::uint32_t>(model.vertexCount());
+  header.indexCount = static_cast<std::uint32_t>(model.indices.size());
+  header.materialCount = static_cast<std::uint32_t>(model.materials.size());
+  header.lodCount = static_cast<std::uint32_t>(model.lods.size());
+  header.sourceSize = key.size;
+  header.sourceMtime = key.mtime;
+  header.sourceHash = key.hash;
+  for (int i = 0; i < 3; ++i) {
+    header.bounds[i] = model.boundsMin[i];
+    header.bounds[3 + i] = model.boundsMax[i];
+    header.bounds[6 + i] = model.boundsCenter[i];
+  }
+  header.bounds[9] = model.boundsRadius;
+  out.put(header);
+
+  out.putBytes(model.vertices.data(),
+               header.vertexCount * Model::VERTEX_FLOATS * sizeof(float));
+  out.pad();
+  static_assert(sizeof(unsigned int) == sizeof(std::uint32_t));
+  out.putBytes(model.indices.data(),
+               model.indices.size() * sizeof(std::uint32_t));
+  out.pad();
+  for (const Model::Lod &lod : model.lods)
+    out.put(LodRecord{lod.indexOffset, lod.indexCount, lod.error, 0});
+  for (const Model::MaterialInfo &mat : model.materials) {
+    MaterialColors colors;
+    for (int i = 0; i < 3; ++i) {
+      colors.diffuse[i] = mat.diffuse_color[i];
+      colors.ambient[i] = mat.ambient_color[i];
+      colors.specular[i] = mat.specular_color[i];
+    }
+    colors.shininess = mat.shininess;
+    out.put(colors);
+    out.putString(mat.name);
+    out.putString(mat.diffuse_texname);
+    out.putString(mat.ambient_texname);
+    out.putString(mat.specular_texname);
+  }
+  out.pad();
+  header.fileSize = out.bytes.size();
+  std::memcpy(out.bytes.data(), &header, sizeof(Header));
+
+  std::error_code ec;
+  std::filesystem::path path(filename);
+  if (path.has_parent_path())
+    std::filesystem::create_directories(path.parent_path(), ec);
+  // Unique per thread, so concurrent cooks of one source don't mix
+  const std::string temp =
+      filename + "." +
+      std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) +
+      ".tmp";
+  {
+    std::ofstream ofs(temp, std::ios::binary);
+    if (!ofs.is_open()) {
+      std::cerr << "Cannot open file for saving cooked mesh: " << temp
+                << std::endl;
+      return false;
+    }
+    ofs.write(reinterpret_cast<const char *>(out.bytes.data()),
+              static_cast<std::streamsize>(out.bytes.size()));
+    if (!ofs) {
+      std::cerr << "Cannot write cooked mesh: " << temp << std::endl;
+      std::filesystem::remove(temp, ec);
+      return false;
+    }
+  }
+  std::filesystem::rename(temp, filename, ec);
+  if (ec) {
+    std::cerr << "Cannot write cooked mesh: " << filename << std::endl;
+    std::filesystem::remove(temp, ec);
+    return false;
+  }
+  return true;
+}
+
+bool loadCookedMesh(const std::string &filename, const MeshSourceKey &key,
+                    Model &out) {
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(filename, ec))
+    return false;
+  MappedFile file;
+  if (!file.open(filename))
+    return false;
+  auto fail = [&](const char *what) {
+    std::cerr << "Invalid cooked mesh " << filename << ": " << what
+              << std::endl;
+    return false;
+  };
+
+  Reader in(file.data(), file.size());
+  Header header;
+  if (!in.read(header) || std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+    return fail("bad header");
+  // Stale files are replaced silently
+  if (header.version != COOKED_MESH_VERSION || header.sourceSize != key.size ||
+      header.sourceMtime != key.mtime || header.sourceHash != key.hash)
+    return false;
+  if (header.fileSize != file.size())
+    return fail("size mismatch");
+  // The counts size the allocations below: the smallest file they imply
+  // (materials with empty strings) must fit before anything is allocated
+  const std::uint64_t indicesStart =
+      align8(sizeof(Header) + std::uint64_t(header.vertexCount) *
+                                  Model::VERTEX_FLOATS * sizeof(float));
+  const std::uint64_t lodsStart =
+      align8(indicesStart +
+             std::uint64_t(header.indexCount) * sizeof(std::uint32_t));
+  const std::uint64_t minimumSize =
+      lodsStart + std::uint64_t(header.lodCount) * sizeof(LodRecord) +
+      std::uint64_t(header.materialCount) *
+          (sizeof(MaterialColors) + 4 * sizeof(std::uint32_t));
+  if (minimumSize > file.size())
+    return fail("counts exceed the file");
+
+  out.vertices.resize(std::size_t(header.vertexCount) * Model::VERTEX_FLOATS);
+  out.indices.resize(header.indexCount);
+  if (!in.bytes(out.vertices.data(), out.vertices.size() * sizeof(float)) ||
+      !in.align() ||
+      !in.bytes(out.indices.data(), out.indices.size() * sizeof(std::uint32_t)))
+    return fail("truncated");
+  for (unsigned int index : out.indices)
+    if (index >= header.vertexCount)
+      return fail("index out of range");
+  in.align();
+  out.lods.clear();
+  out.lods.reserve(header.lodCount);
+  for (std::uint32_t l = 0; l < header.lodCount; ++l) {
+    LodRecord record;
+    if (!in.read(record))
+      return fail("truncated LODs");
+    if (record.indexCount % 3 != 0 ||
+        record.indexOffset > header.indexCount ||
+        record.indexCount > header.indexCount - record.indexOffset)
+      return fail("LOD out of range");
+    out.lods.push_back({record.indexOffset, record.indexCount, record.error});
+  }
+
+  out.materials.clear();
+  out.materials.reserve(header.materialCount);
+  for (std::uint32_t m = 0; m < header.materialCount; ++m) {
+    MaterialColors colors;
+    Model::MaterialInfo mat;
+    if (!in.read(colors) || !in.string(mat.name) ||
+        !in.string(mat.diffuse_texname) || !in.string(mat.ambient_texname) ||
+        !in.string(mat.specular_texname))
+      return fail("truncated materials");
+    mat.diffuse_color = glm::vec3(colors.diffuse[0], colors.diffuse[1],
+                                  colors.diffuse[2]);
+    mat.ambient_color = glm::vec3(colors.ambient[0], colors.ambient[1],
+                                  colors.ambient[2]);
+    mat.specular_color = glm::vec3(colors.specular[0], colors.specular[1],
+                                   colors.specular[2]);
+    mat.shininess = colors.shininess;
+    out.materials.push_back(std::move(mat));
+  }
+
+  const float *b = header.bounds;
+  out.boundsMin = glm::vec3(b[0], b[1], b[2]);
+  out.boundsMax = glm::vec3(b[3], b[4], b[5]);
+  out.boundsCenter = glm::vec3(b[6], b[7], b[8]);
+  out.boundsRadius = b[9];
+  return true;
+}
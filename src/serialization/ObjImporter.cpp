@@ -0,0 +1,492 @@
+#include "serialization/ObjImporter.hpp"
+#include "core/FlatHashMap.hpp"
+#include "core/ThreadPool.hpp"
+#include "platform/MappedFile.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string_view>
+
+namespace {
+
+// Smaller files are parsed as one chunk, task overhead would dominate
+const std::size_t MIN_CHUNK_BYTES = 1 << 20;
+
+struct ObjIndexHash {
+  std::size_t operator()(const ObjIndex &k) const noexcept {
+    std::uint64_t h = std::uint32_t(k.vertex) * 0x9e3779b97f4a7c15ull;
+    h ^= (std::uint64_t(std::uint32_t(k.texcoord)) << 32 |
+          std::uint32_t(k.normal)) *
+         0xc2b2ae3d27d4eb4full;
+    return static_cast<std::size_t>(h ^ (h >> 29));
+  }
+};
+
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Whitespace-separated tokens of one line
+class LineReader {
+public:
+  LineReader(const char *begin, const char *end) : p(begin), end(end) {}
+
+  std::string_view token() {
+    while (p < end && isSpace(*p))
+      ++p;
+    const char *start = p;
+    while (p < end && !isSpace(*p))
+      ++p;
+    return std::string_view(start, p - start);
+  }
+
+  // The rest of the line without surrounding whitespace
+  std::string_view rest() {
+    while (p < end && isSpace(*p))
+      ++p;
+    const char *last = end;
+    while (last > p && isSpace(last[-1]))
+      --last;
+    return std::string_view(p, last - p);
+  }
+
+private:
+  const char *p;
+  const char *end;
+};
+
+// Parsed as double and narrowed like tinyobjloader does, missing or invalid
+// numbers read as 0
+float parseFloat(std::string_view token) {
+  if (!token.empty() && token.front() == '+')
+    token.remove_prefix(1); // from_chars takes no plus sign
+  double value = 0.0;
+  if (std::from_chars(token.data(), token.data() + token.size(), value).ec !=
+      std::errc())
+    return 0.0f;
+  return static_cast<float>(value);
+}
+
+void parseFloats(LineReader &line, std::vector<float> &out, int count) {
+  for (int i = 0; i < count; ++i)
+    out.push_back(parseFloat(line.token()));
+}
+
+// Line-aligned piece of the file and what it contains. Negative (relative)
+// indices can point into earlier chunks, they are resolved against the
+// chunk's own elements here and shifted by the earlier chunks' counts when
+// merging.
+struct Chunk {
+  const char *begin = nullptr;
+  const char *end = nullptr;
+  std::vector<float> positions;
+  std::vector<float> texcoords;
+  std::vector<float> normals;
+  std::vector<ObjIndex> indices;
+  // Positions in indices holding a relative reference
+  std::vector<std::uint32_t> relativeVertices;
+  std::vector<std::uint32_t> relativeTexcoords;
+  std::vector<std::uint32_t> relativeNormals;
+  std::vector<std::string> materialLibs; // mtllib lines in file order
+  const char *errorAt = nullptr;          // first invalid line
+  // Per component, the most negative resolved relative index and its line,
+  // out of range if the earlier chunks have fewer elements
+  int lowestRelative[3] = {0, 0, 0};
+  const char *lowestRelativeAt[3] = {nullptr, nullptr, nullptr};
+};
+
+// One face corner before triangulation, bit i of relative set for
+// component i of index
+struct Corner {
+  ObjIndex index;
+  unsigned relative;
+};
+
+// Parses "v", "v/t", "v//n" or "v/t/n" on the line starting at lineStart
+bool parseCorner(std::string_view token, const char *lineStart, Chunk &chunk,
+                 Corner &out) {
+  const std::size_t counts[3] = {chunk.positions.size() / 3,
+                                 chunk.texcoords.size() / 2,
+                                 chunk.normals.size() / 3};
+  int *fields[3] = {&out.index.vertex, &out.index.texcoord, &out.index.normal};
+  out.index = {-1, -1, -1};
+  out.relative = 0;
+  const char *p = token.data();
+  const char *end = p + token.size();
+  for (int i = 0; i < 3 && p <= end; ++i) {
+    if (i > 0) {
+      if (p == end || *p != '/')
+        break;
+      ++p;
+    }
+    if (i > 0 && (p == end || *p == '/'))
+      continue; // empty field, as the texcoord in v//n
+    int value = 0;
+    auto result = std::from_chars(p, end, value);
+    if (result.ec != std::errc() || value == 0)
+      return false;
+    p = result.ptr;
+    if (value > 0) {
+      *fields[i] = value - 1;
+    } else {
+      *fields[i] = static_cast<int>(counts[i]) + value;
+      out.relative |= 1u << i;
+      if (*fields[i] < chunk.lowestRelative[i]) {
+        chunk.lowestRelative[i] = *fields[i];
+        chunk.lowestRelativeAt[i] = lineStart;
+      }
+    }
+  }
+  // The vertex is always there, relative ones may resolve to -1 here
+  return p == end;
+}
+
+bool parseFace(LineReader &line, const char *lineStart, Chunk &chunk,
+               std::vector<Corner> &corners) {
+  corners.clear();
+  for (std::string_view token = line.token(); !token.empty();
+       token = line.token()) {
+    Corner corner;
+    if (!parseCorner(token, lineStart, chunk, corner))
+      return false;
+    corners.push_back(corner);
+  }
+  // Fan around the first corner
+  auto push = [&](const Corner &c) {
+    const auto slot = static_cast<std::uint32_t>(chunk.indices.size());
+    if (c.relative & 1u)
+      chunk.relativeVertices.push_back(slot);
+    if (c.relative & 2u)
+      chunk.relativeTexcoords.push_back(slot);
+    if (c.relative & 4u)
+      chunk.relativeNormals.push_back(slot);
+    chunk.indices.push_back(c.index);
+  };
+  for (std::size_t k = 2; k < corners.size(); ++k) {
+    push(corners[0]);
+    push(corners[k - 1]);
+    push(corners[k]);
+  }
+  return true;
+}
+
+void parseChunk(Chunk &chunk) {
+  std::vector<Corner> corners;
+  const char *p = chunk.begin;
+  while (p < chunk.end) {
+    const char *eol = static_cast<const char *>(
+        std::memchr(p, '\n', static_cast<std::size_t>(chunk.end - p)));
+    if (!eol)
+      eol = chunk.end;
+    LineReader line(p, eol);
+    std::string_view tag = line.token();
+    if (tag == "v") {
+      parseFloats(line, chunk.positions, 3);
+    } else if (tag == "vt") {
+      parseFloats(line, chunk.texcoords, 2);
+    } else if (tag == "vn") {
+      parseFloats(line, chunk.normals, 3);
+    } else if (tag == "f") {
+      if (!parseFace(line, p, chunk, corners)) {
+        chunk.errorAt = p;
+        return;
+      }
+    } else if (tag == "mtllib") {
+      chunk.materialLibs.emplace_back(line.rest());
+    }
+    p = eol + 1;
+  }
+}
+
+std::vector<Chunk> splitChunks(const char *data, std::size_t size,
+                               ThreadPool *pool) {
+  std::size_t count = std::max<std::size_t>(1, size / MIN_CHUNK_BYTES);
+  // A few chunks per thread even out uneven lines
+  const std::size_t threads = pool ? pool->getWorkerCount() + 1 : 1;
+  count = std::min(count, threads * 4);
+  std::vector<Chunk> chunks;
+  const char *end = data + size;
+  const char *begin = data;
+  for (std::size_t i = 1; i <= count && begin < end; ++i) {
+    const char *split = i == count ? end : data + size / count * i;
+    if (split < begin)
+      split = begin;
+    const char *eol = static_cast<const char *>(
+        std::memchr(split, '\n', static_cast<std::size_t>(end - split)));
+    split = eol ? eol + 1 : end;
+    chunks.emplace_back();
+    chunks.back().begin = begin;
+    chunks.back().end = split;
+    begin = split;
+  }
+  return chunks;
+}
+
+// Concatenates the chunks in file order, resolving relative indices
+void mergeChunks(std::vector<Chunk> &chunks, ObjData &obj, ThreadPool *pool) {
+  struct Offsets {
+    std::size_t positions, texcoords, normals, indices;
+  };
+  std::vector<Offsets> offsets(chunks.size());
+  Offsets total{0, 0, 0, 0};
+  for (std::size_t i = 0; i < chunks.size(); ++i) {
+    offsets[i] = total;
+    total.positions += chunks[i].positions.size();
+    total.texcoords += chunks[i].texcoords.size();
+    total.normals += chunks[i].normals.size();
+    total.indices += chunks[i].indices.size();
+  }
+  obj.positions.resize(total.positions);
+  obj.texcoords.resize(total.texcoords);
+  obj.normals.resize(total.normals);
+  obj.indices.resize(total.indices);
+
+  TaskGroup group(pool);
+  for (std::size_t i = 0; i < chunks.size(); ++i) {
+    group.run([&, i] {
+      Chunk &c = chunks[i];
+      const Offsets &o = offsets[i];
+      std::copy(c.positions.begin(), c.positions.end(),
+                obj.positions.begin() + o.positions);
+      std::copy(c.texcoords.begin(), c.texcoords.end(),
+                obj.texcoords.begin() + o.texcoords);
+      std::copy(c.normals.begin(), c.normals.end(),
+                obj.normals.begin() + o.normals);
+      ObjIndex *indices = obj.indices.data() + o.indices;
+      std::copy(c.indices.begin(), c.indices.end(), indices);
+      for (std::uint32_t slot : c.relativeVertices)
+        indices[slot].vertex += static_cast<int>(o.positions / 3);
+      for (std::uint32_t slot : c.relativeTexcoords)
+        indices[slot].texcoord += static_cast<int>(o.texcoords / 2);
+      for (std::uint32_t slot : c.relativeNormals)
+        indices[slot].normal += static_cast<int>(o.normals / 3);
+      // Frees the chunk's memory as soon as it is copied
+      c = Chunk();
+    });
+  }
+  group.wait();
+}
+
+// Texture file of a map_* statement, skipping its options
+std::string parseTextureName(LineReader &line) {
+  std::string name;
+  for (std::string_view token = line.token(); !token.empty();
+       token = line.token()) {
+    int arguments = 0;
+    if (token == "-o" || token == "-s" || token == "-t")
+      arguments = 3;
+    else if (token == "-mm")
+      arguments = 2;
+    else if (token == "-blendu" || token == "-blendv" || token == "-boost" ||
+             token == "-clamp" || token == "-texres" || token == "-bm" ||
+             token == "-imfchan" || token == "-type")
+      arguments = 1;
+    else
+      name = token;
+    for (int i = 0; i < arguments; ++i)
+      line.token();
+  }
+  return name;
+}
+
+Model::MaterialInfo defaultMaterial() {
+  Model::MaterialInfo mat;
+  mat.diffuse_color = mat.ambient_color = mat.specular_color = glm::vec3(0.0f);
+  mat.shininess = 1.0f;
+  return mat;
+}
+
+// Appends the materials of an .mtl file, false if it can't be read. Like
+// tinyobjloader, the last material is kept even without a name.
+bool loadMtl(const std::string &path,
+             std::vector<Model::MaterialInfo> &materials) {
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(path, ec))
+    return false;
+  MappedFile file;
+  if (!file.open(path))
+    return false;
+  const char *p = reinterpret_cast<const char *>(file.data());
+  const char *end = p + file.size();
+  Model::MaterialInfo mat = defaultMaterial();
+  auto readColor = [](LineReader &line) {
+    glm::vec3 c;
+    for (int i = 0; i < 3; ++i)
+      c[i] = parseFloat(line.token());
+    return c;
+  };
+  while (p < end) {
+    const char *eol = static_cast<const char *>(
+        std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+    if (!eol)
+      eol = end;
+    LineReader line(p, eol);
+    std::string_view tag = line.token();
+    if (tag == "newmtl") {
+      if (!mat.name.empty())
+        materials.push_back(std::move(mat));
+      mat = defaultMaterial();
+      mat.name = line.rest();
+    } else if (tag == "Ka") {
+      mat.ambient_color = readColor(line);
+    } else if (tag == "Kd") {
+      mat.diffuse_color = readColor(line);
+    } else if (tag == "Ks") {
+      mat.specular_color = readColor(line);
+    } else if (tag == "Ns") {
+      mat.shininess = parseFloat(line.token());
+    } else if (tag == "map_Ka") {
+      mat.ambient_texname = parseTextureName(line);
+    } else if (tag == "map_Kd") {
+      mat.diffuse_texname = parseTextureName(line);
+    } else if (tag == "map_Ks") {
+      mat.specular_texname = parseTextureName(line);
+    }
+    p = eol + 1;
+  }
+  materials.push_back(std::move(mat));
+  return true;
+}
+
+} // namespace
+
+bool importObj(const std::string &path, Model &out, ThreadPool *pool) {
+  MappedFile file;
+  if (!file.open(path)) {
+    std::cerr << "Failed to load/parse .obj: " << path << std::endl;
+    return false;
+  }
+  const char *data = reinterpret_cast<const char *>(file.data());
+  std::vector<Chunk> chunks = splitChunks(data, file.size(), pool);
+  {
+    TaskGroup group(pool);
+    for (Chunk &chunk : chunks)
+      group.run([&chunk] { parseChunk(chunk); });
+  }
+  // Relative indices may reach into earlier chunks, not before the file
+  std::int64_t earlier[3] = {0, 0, 0};
+  for (const Chunk &chunk : chunks) {
+    if (chunk.errorAt) {
+      std::cerr << "Invalid face in " << path << " line "
+                << 1 + std::count(data, chunk.errorAt, '\n') << std::endl;
+      return false;
+    }
+    for (int i = 0; i < 3; ++i) {
+      if (earlier[i] + chunk.lowestRelative[i] < 0) {
+        std::cerr << "Index out of range in " << path << " line "
+                  << 1 + std::count(data, chunk.lowestRelativeAt[i], '\n')
+                  << std::endl;
+        return false;
+      }
+    }
+    earlier[0] += chunk.positions.size() / 3;
+    earlier[1] += chunk.texcoords.size() / 2;
+    earlier[2] += chunk.normals.size() / 3;
+  }
+
+  ObjData obj;
+  std::vector<std::string> materialLibs;
+  for (Chunk &chunk : chunks)
+    for (std::string &lib : chunk.materialLibs)
+      materialLibs.push_back(std::move(lib));
+  mergeChunks(chunks, obj, pool);
+  file.close();
+
+  // Every mtllib line loads the first of its files that exists
+  std::filesystem::path dir = std::filesystem::path(path).parent_path();
+  for (const std::string &line : materialLibs) {
+    LineReader names(line.data(), line.data() + line.size());
+    bool found = false;
+    for (std::string_view name = names.token(); !name.empty() && !found;
+         name = names.token())
+      found = loadMtl((dir / name).string(), obj.materials);
+    if (!found)
+      std::cerr << "Material library not found: " << line << " (" << path
+                << ")" << std::endl;
+  }
+
+  if (!buildModel(obj, out)) {
+    std::cerr << "Index out of range in " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+bool buildModel(const ObjData &obj, Model &out) {
+  out.vertices.clear();
+  out.indices.clear();
+  out.materials = obj.materials;
+
+  const bool hasNormals = !obj.normals.empty();
+  const bool hasTexcoords = !obj.texcoords.empty();
+  const auto positionCount = static_cast<std::int64_t>(obj.positions.size() / 3);
+  const auto texcoordCount = static_cast<std::int64_t>(obj.texcoords.size() / 2);
+  const auto normalCount = static_cast<std::int64_t>(obj.normals.size() / 3);
+
+  FlatHashMap<ObjIndex, unsigned int, ObjIndexHash> uniqueVertexMap(
+      obj.positions.size() / 3);
+  out.indices.reserve(obj.indices.size());
+  out.vertices.reserve(obj.positions.size() / 3 * Model::VERTEX_FLOATS);
+
+  for (const ObjIndex &idx : obj.indices) {
+    auto [slot, inserted] = uniqueVertexMap.tryEmplace(
+        idx, static_cast<unsigned int>(out.vertexCount()));
+    if (inserted) {
+      if (idx.vertex < 0 || idx.vertex >= positionCount ||
+          (hasTexcoords && idx.texcoord >= texcoordCount) ||
+          (hasNormals && idx.normal >= normalCount))
+        return false;
+      float vertex[Model::VERTEX_FLOATS] = {};
+      const float *v = &obj.positions[std::size_t(idx.vertex) * 3];
+      vertex[0] = v[0];
+      vertex[1] = v[1];
+      vertex[2] = v[2];
+      if (hasNormals && idx.normal >= 0) {
+        const float *n = &obj.normals[std::size_t(idx.normal) * 3];
+        vertex[Model::NORMAL_OFFSET + 0] = n[0];
+        vertex[Model::NORMAL_OFFSET + 1] = n[1];
+        vertex[Model::NORMAL_OFFSET + 2] = n[2];
+      }
+      if (hasTexcoords && idx.texcoord >= 0) {
+        const float *t = &obj.texcoords[std::size_t(idx.texcoord) * 2];
+        vertex[Model::TEXCOORD_OFFSET + 0] = t[0];
+        vertex[Model::TEXCOORD_OFFSET + 1] = t[1];
+      }
+      out.vertices.insert(out.vertices.end(), vertex,
+                          vertex + Model::VERTEX_FLOATS);
+    }
+    out.indices.push_back(*slot);
+  }
+
+  if (!hasNormals) {
+    size_t vertCount = out.vertexCount();
+    size_t faceCount = out.indices.size() / 3;
+    for (size_t f = 0; f < faceCount; ++f) {
+      unsigned int i0 = out.indices[3 * f + 0];
+      unsigned int i1 = out.indices[3 * f + 1];
+      unsigned int i2 = out.indices[3 * f + 2];
+      glm::vec3 v0 = out.position(i0);
+      glm::vec3 edge1 = out.position(i1) - v0;
+      glm::vec3 edge2 = out.position(i2) - v0;
+      glm::vec3 faceNormal = glm::normalize(glm::cross(edge1, edge2));
+      for (unsigned int vi : {i0, i1, i2}) {
+        float *n =
+            &out.vertices[vi * Model::VERTEX_FLOATS + Model::NORMAL_OFFSET];
+        n[0] += faceNormal.x;
+        n[1] += faceNormal.y;
+        n[2] += faceNormal.z;
+      }
+    }
+    for (size_t vi = 0; vi < vertCount; ++vi) {
+      float *n = &out.vertices[vi * Model::VERTEX_FLOATS + Model::NORMAL_OFFSET];
+      glm::vec3 normal = glm::normalize(glm::vec3(n[0], n[1], n[2]));
+      n[0] = normal.x;
+      n[1] = normal.y;
+      n[2] = normal.z;
+    }
+  }
+
+  out.computeBounds();
+  return true;
+}
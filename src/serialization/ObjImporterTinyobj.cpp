@@ -0,0 +1,72 @@
+#include "serialization/ObjImporter.hpp"
+#include <filesystem>
+#include <iostream>
+#include <tiny_obj_loader.h>
+
+bool importObjTinyobj(const std::string &path, Model &out) {
+  tinyobj::attrib_t attrib;
+  std::vector<tinyobj::shape_t> shapes;
+  std::vector<tinyobj::material_t> materials;
+
+  std::string err;
+
+  std::string basedir;
+  {
+    std::filesystem::path p(path);
+    if (p.has_parent_path()) {
+      basedir = p.parent_path().string() + "/";
+    } else {
+      basedir = "";
+    }
+  }
+
+  bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, path.c_str(),
+                              basedir.empty() ? nullptr : basedir.c_str(),
+                              /*triangulate=*/true);
+  if (!err.empty()) {
+    std::cerr << "tinyobjloader error: " << err << std::endl;
+  }
+  if (!ret) {
+    std::cerr << "Failed to load/parse .obj: " << path << std::endl;
+    return false;
+  }
+
+  ObjData obj;
+  obj.positions = std::move(attrib.vertices);
+  obj.texcoords = std::move(attrib.texcoords);
+  obj.normals = std::move(attrib.normals);
+
+  obj.materials.reserve(materials.size());
+  for (const auto &mat : materials) {
+    Model::MaterialInfo mi;
+    mi.name = mat.name;
+    mi.diffuse_color =
+        glm::vec3(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2]);
+    mi.ambient_color =
+        glm::vec3(mat.ambient[0], mat.ambient[1], mat.ambient[2]);
+    mi.specular_color =
+        glm::vec3(mat.specular[0], mat.specular[1], mat.specular[2]);
+    mi.shininess = mat.shininess;
+    mi.diffuse_texname = mat.diffuse_texname;
+    mi.ambient_texname = mat.ambient_texname;
+    mi.specular_texname = mat.specular_texname;
+    obj.materials.push_back(std::move(mi));
+  }
+
+  size_t estimatedIndices = 0;
+  for (const auto &shape : shapes) {
+    estimatedIndices += shape.mesh.indices.size();
+  }
+  obj.indices.reserve(estimatedIndices);
+  for (const auto &shape : shapes) {
+    for (const tinyobj::index_t &idx : shape.mesh.indices)
+      obj.indices.push_back(
+          {idx.vertex_index, idx.texcoord_index, idx.normal_index});
+  }
+
+  if (!buildModel(obj, out)) {
+    std::cerr << "Index out of range in " << path << std::endl;
+    return false;
+  }
+  return true;
+}
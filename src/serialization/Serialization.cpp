@@ -1,115 +1,421 @@
 #include "serialization/Serialization.hpp"
 #include "nlohmann/json.hpp"
+#include "serialization/BinaryScene.hpp"
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <utility>
+#include <vector>
 
 using json = nlohmann::json;
 
-bool saveScene(const World &world, const std::string &filename) {
-  json jScene;
-  jScene["entities"] = json::array();
+namespace {
 
-  for (Entity e : world.getEntities()) {
-    json jEntity;
-    jEntity["id"] = e;
+// Output buffer of one entity, flushed to the stream entity by entity
+class JsonWriter {
+public:
+  std::string text;
+
+  void raw(const char *s) { text += s; }
+
+  void number(float value) {
+    // Shortest text that reads back as the same float
+    if (!std::isfinite(value)) {
+      text += "null";
+      return;
+    }
+    char buf[32];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    text.append(buf, result.ptr);
+  }
+
+  void number(std::uint32_t value) {
+    char buf[16];
+    auto result = std::to_chars(buf, buf + sizeof(buf), value);
+    text.append(buf, result.ptr);
+  }
+
+  void vec3(const std::array<float, 3> &v) {
+    text += '[';
+    for (int i = 0; i < 3; ++i) {
+      if (i)
+        text += ", ";
+      number(v[i]);
+    }
+    text += ']';
+  }
+
+  void string(const std::string &s) {
+    text += '"';
+    for (char c : s) {
+      switch (c) {
+      case '"':
+        text += "\\\"";
+        break;
+      case '\\':
+        text += "\\\\";
+        break;
+      case '\n':
+        text += "\\n";
+        break;
+      case '\t':
+        text += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buf[8];
+          std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+          text += buf;
+        } else {
+          text += c;
+        }
+      }
+    }
+    text += '"';
+  }
+};
+
+// Builds entities while nlohmann's SAX parser walks the file, so no DOM of
+// the whole scene exists at any time. An entity is committed to the World
+// when its object ends (keys may come in any order). Unknown keys are skipped.
+class SceneSaxHandler : public json::json_sax_t {
+public:
+  // resourceManager null: paths only
+  SceneSaxHandler(World &world, ResourceManager *resourceManager,
+                  const std::string &filename)
+      : world(world), resourceManager(resourceManager), filename(filename) {}
+
+  bool sawEntities = false;
+  std::string parseErrorMessage;
+
+  bool null() override {
+    return scalar(std::numeric_limits<double>::quiet_NaN());
+  }
+  bool boolean(bool) override { return invalidValue(); }
+  bool number_integer(number_integer_t value) override {
+    return scalar(double(value));
+  }
+  bool number_unsigned(number_unsigned_t value) override {
+    if (top() == Context::Entity && currentKey == "id") {
+      entity.hasId = value <= std::numeric_limits<Entity>::max();
+      entity.id = static_cast<Entity>(value);
+      return true;
+    }
+    if (top() == Context::Transform && currentKey == "parent") {
+      entity.hasParent = value <= std::numeric_limits<Entity>::max();
+      entity.parent = static_cast<Entity>(value);
+      return true;
+    }
+    return scalar(double(value));
+  }
+  bool number_float(number_float_t value, const string_t &) override {
+    return scalar(value);
+  }
+  bool string(string_t &value) override {
+    if (top() == Context::Render && currentKey == "modelPath")
+      entity.render.modelPath = std::move(value);
+    else if (top() == Context::Script && currentKey == "scriptPath")
+      entity.script.setScriptPath(std::move(value));
+    else
+      return invalidValue();
+    return true;
+  }
+  bool binary(binary_t &) override { return true; }
 
-    if (world.hasTransform(e)) {
-      const auto *tc = world.getTransform(e);
-      json jTrans;
-      jTrans["position"] = {tc->position[0], tc->position[1], tc->position[2]};
-      jTrans["rotation"] = {tc->rotation[0], tc->rotation[1], tc->rotation[2]};
-      jTrans["scale"] = {tc->scale[0], tc->scale[1], tc->scale[2]};
-      jEntity["TransformComponent"] = jTrans;
+  bool start_object(std::size_t) override {
+    Context next = Context::Skip;
+    if (stack.empty()) {
+      next = Context::Root;
+    } else if (top() == Context::Entities) {
+      entity = EntityState();
+      next = Context::Entity;
+    } else if (top() == Context::Entity) {
+      if (currentKey == "TransformComponent") {
+        entity.hasTransform = true;
+        next = Context::Transform;
+      } else if (currentKey == "RenderComponent") {
+        entity.hasRender = true;
+        next = Context::Render;
+      } else if (currentKey == "LuaScriptComponent") {
+        entity.hasScript = true;
+        next = Context::Script;
+      }
     }
-    if (world.hasRender(e)) {
-      const auto *rc = world.getRender(e);
-      json jRender;
-      jRender["modelPath"] = rc->modelPath;
-      jEntity["RenderComponent"] = jRender;
+    stack.push_back(next);
+    return true;
+  }
+
+  bool end_object() override {
+    Context closed = top();
+    stack.pop_back();
+    if (closed == Context::Entity)
+      commitEntity();
+    return true;
+  }
+
+  bool start_array(std::size_t) override {
+    Context next = Context::Skip;
+    if (top() == Context::Root && currentKey == "entities") {
+      sawEntities = true;
+      next = Context::Entities;
+    } else if (top() == Context::Transform) {
+      vector = nullptr;
+      if (currentKey == "position")
+        vector = &entity.transform.position;
+      else if (currentKey == "rotation")
+        vector = &entity.transform.rotation;
+      else if (currentKey == "scale")
+        vector = &entity.transform.scale;
+      if (vector) {
+        vectorSize = 0;
+        next = Context::Vector;
+      }
     }
-    if (world.hasScript(e)) {
-      const auto *sc = world.getScript(e);
-      json jScript;
-      jScript["scriptPath"] = sc->scriptPath;
-      jEntity["LuaScriptComponent"] = jScript;
+    stack.push_back(next);
+    return true;
+  }
+
+  bool end_array() override {
+    if (top() == Context::Vector && vectorSize != 3)
+      entity.invalid = true;
+    stack.pop_back();
+    return true;
+  }
+
+  bool key(string_t &value) override {
+    currentKey = std::move(value);
+    return true;
+  }
+
+  bool parse_error(std::size_t, const std::string &,
+                   const nlohmann::detail::exception &ex) override {
+    parseErrorMessage = ex.what();
+    return false;
+  }
+
+  // Links saved parent ids once every entity exists
+  void linkParents() {
+    if (parentLinks.empty())
+      return;
+    std::sort(idMap.begin(), idMap.end());
+    for (const auto &[child, savedParent] : parentLinks) {
+      auto it = std::lower_bound(idMap.begin(), idMap.end(),
+                                 std::make_pair(savedParent, Entity(0)));
+      if (it == idMap.end() || it->first != savedParent ||
+          !world.setParent(child, it->second))
+        std::cerr << "Invalid parent " << savedParent << " in " << filename
+                  << std::endl;
     }
-    jScene["entities"].push_back(jEntity);
   }
 
-  std::ofstream ofs(filename);
+private:
+  enum class Context {
+    Root,
+    Entities,
+    Entity,
+    Transform,
+    Vector,
+    Render,
+    Script,
+    Skip
+  };
+
+  struct EntityState {
+    bool hasId = false;
+    bool hasTransform = false;
+    bool hasRender = false;
+    bool hasScript = false;
+    bool hasParent = false;
+    bool invalid = false;
+    Entity id = INVALID_ENTITY;
+    Entity parent = INVALID_ENTITY;
+    TransformComponent transform;
+    RenderComponent render;
+    LuaScriptComponent script;
+  };
+
+  World &world;
+  ResourceManager *resourceManager;
+  const std::string &filename;
+
+  std::vector<Context> stack;
+  std::string currentKey;
+  EntityState entity;
+  std::array<float, 3> *vector = nullptr;
+  int vectorSize = 0;
+
+  // Saved id -> new entity, parents are linked once all entities exist
+  std::vector<std::pair<Entity, Entity>> idMap;
+  std::vector<std::pair<Entity, Entity>> parentLinks;
+  // Consecutive entities mostly share their model
+  std::string lastModelPath;
+  ModelFuture lastModel;
+
+  Context top() const { return stack.empty() ? Context::Skip : stack.back(); }
+
+  bool scalar(double value) {
+    if (top() != Context::Vector)
+      return invalidValue();
+    if (vectorSize < 3)
+      (*vector)[vectorSize] = static_cast<float>(value);
+    ++vectorSize;
+    return true;
+  }
+
+  // Values of known keys with the wrong type make the entity invalid
+  bool invalidValue() {
+    if (top() == Context::Vector) {
+      ++vectorSize;
+      entity.invalid = true;
+    } else if (top() == Context::Entity && currentKey == "id") {
+      entity.hasId = false;
+    } else if ((top() == Context::Transform &&
+                (currentKey == "parent" || currentKey == "position" ||
+                 currentKey == "rotation" || currentKey == "scale")) ||
+               (top() == Context::Render && currentKey == "modelPath") ||
+               (top() == Context::Script && currentKey == "scriptPath")) {
+      entity.invalid = true;
+    }
+    return true;
+  }
+
+  void commitEntity() {
+    if (!entity.hasId) {
+      std::cerr << "Entity without valid 'id' field" << std::endl;
+      return;
+    }
+    if (entity.invalid) {
+      std::cerr << "Invalid components of entity " << entity.id << " in "
+                << filename << std::endl;
+      return;
+    }
+
+    // Creating new Entity without saving ID.
+    // Could be reworked with saving IDs if entities interactions needed
+    Entity newE = world.createEntity();
+    idMap.emplace_back(entity.id, newE);
+
+    if (entity.hasTransform) {
+      world.addComponent(newE, entity.transform);
+      if (entity.hasParent)
+        parentLinks.emplace_back(newE, entity.parent);
+    }
+    if (entity.hasRender) {
+      // Models are parsed in the background while the scene loads
+      if (resourceManager) {
+        if (!lastModel.valid() || entity.render.modelPath != lastModelPath) {
+          lastModel = resourceManager->loadModelAsync(entity.render.modelPath);
+          lastModelPath = entity.render.modelPath;
+        }
+        entity.render.pendingModel = lastModel;
+        entity.render.resolveModel();
+      }
+      world.addComponent(newE, entity.render);
+    }
+    if (entity.hasScript)
+      world.addComponent(newE, entity.script);
+  }
+};
+
+} // namespace
+
+bool saveScene(const World &world, const std::string &filename) {
+  std::ofstream ofs(filename, std::ios::binary);
   if (!ofs.is_open()) {
     std::cerr << "Cannot open file for saving scene: " << filename << std::endl;
     return false;
   }
-  ofs << jScene.dump(4);
+
+  // One entity per line, written as soon as it is formatted
+  JsonWriter out;
+  ofs << "{\n    \"entities\": [";
+  bool first = true;
+  for (Entity e : world.getEntities()) {
+    out.text.clear();
+    out.raw(first ? "\n        {\"id\": " : ",\n        {\"id\": ");
+    first = false;
+    out.number(e);
+
+    if (const auto *tc = world.getTransform(e)) {
+      out.raw(", \"TransformComponent\": {\"position\": ");
+      out.vec3(tc->position);
+      out.raw(", \"rotation\": ");
+      out.vec3(tc->rotation);
+      out.raw(", \"scale\": ");
+      out.vec3(tc->scale);
+      if (tc->parent != INVALID_ENTITY && world.isAlive(tc->parent)) {
+        out.raw(", \"parent\": ");
+        out.number(tc->parent);
+      }
+      out.raw("}");
+    }
+    if (const auto *rc = world.getRender(e)) {
+      out.raw(", \"RenderComponent\": {\"modelPath\": ");
+      out.string(rc->modelPath);
+      out.raw("}");
+    }
+    if (const auto *sc = world.getScript(e)) {
+      out.raw(", \"LuaScriptComponent\": {\"scriptPath\": ");
+      out.string(sc->getScriptPath());
+      out.raw("}");
+    }
+    out.raw("}");
+    ofs.write(out.text.data(), static_cast<std::streamsize>(out.text.size()));
+  }
+  ofs << "\n    ]\n}\n";
   ofs.close();
+  if (!ofs) {
+    std::cerr << "Cannot write scene: " << filename << std::endl;
+    return false;
+  }
   std::cout << "Scene saved to " << filename << std::endl;
   return true;
 }
 
-bool loadScene(World &world, ResourceManager &resourceManager,
-               const std::string &filename) {
-  std::ifstream ifs(filename);
+namespace {
+
+bool loadJson(World &world, ResourceManager *resourceManager,
+              const std::string &filename) {
+  std::ifstream ifs(filename, std::ios::binary);
   if (!ifs.is_open()) {
     std::cerr << "Cannot open scene file: " << filename << std::endl;
     return false;
   }
-  json jScene;
-  try {
-    ifs >> jScene;
-  } catch (const std::exception &e) {
-    std::cerr << "JSON parse error in " << filename << ": " << e.what()
-              << std::endl;
+
+  // Empty World implied. Entities are created while parsing, memory use
+  // does not depend on the file size.
+  SceneSaxHandler handler(world, resourceManager, filename);
+  if (!json::sax_parse(ifs, &handler)) {
+    std::cerr << "JSON parse error in " << filename << ": "
+              << handler.parseErrorMessage << std::endl;
     return false;
   }
-
-  if (!jScene.contains("entities") || !jScene["entities"].is_array()) {
+  if (!handler.sawEntities) {
     std::cerr << "Invalid scene format: missing 'entities' array" << std::endl;
     return false;
   }
+  handler.linkParents();
 
-  // Empty World implied
-  for (const auto &jEntity : jScene["entities"]) {
-    if (!jEntity.contains("id") || !jEntity["id"].is_number_unsigned()) {
-      std::cerr << "Entity without valid 'id' field" << std::endl;
-      continue;
-    }
-    Entity e = static_cast<Entity>(jEntity["id"].get<uint32_t>());
+  std::cout << "Scene loaded from " << filename << std::endl;
+  return true;
+}
 
-    // Creating new Entity without saving ID.
-    // Could be reworked with saving IDs if entities interactions needed
-    Entity newE = world.createEntity();
+} // namespace
 
-    if (jEntity.contains("TransformComponent")) {
-      const auto &jTrans = jEntity["TransformComponent"];
-      TransformComponent tc;
-      auto pos = jTrans["position"];
-      tc.position = {pos[0].get<float>(), pos[1].get<float>(),
-                     pos[2].get<float>()};
-      auto rot = jTrans["rotation"];
-      tc.rotation = {rot[0].get<float>(), rot[1].get<float>(),
-                     rot[2].get<float>()};
-      auto scl = jTrans["scale"];
-      tc.scale = {scl[0].get<float>(), scl[1].get<float>(),
-                  scl[2].get<float>()};
-      world.addComponent(newE, tc);
-    }
-    if (jEntity.contains("RenderComponent")) {
-      const auto &jRender = jEntity["RenderComponent"];
-      RenderComponent rc;
-      rc.modelPath = jRender["modelPath"].get<std::string>();
-      rc.model = resourceManager.loadModel(rc.modelPath);
-      // For materials
-      world.addComponent(newE, rc);
-    }
-    if (jEntity.contains("LuaScriptComponent")) {
-      const auto &jScript = jEntity["LuaScriptComponent"];
-      LuaScriptComponent sc;
-      sc.scriptPath = jScript["scriptPath"].get<std::string>();
-      world.addComponent(newE, sc);
-    }
-  }
+bool loadScene(World &world, ResourceManager &resourceManager,
+               const std::string &filename) {
+  if (isBinaryScene(filename))
+    return loadSceneBinary(world, resourceManager, filename);
+  return loadJson(world, &resourceManager, filename);
+}
 
-  std::cout << "Scene loaded from " << filename << std::endl;
-  return true;
+bool loadScene(World &world, const std::string &filename) {
+  if (isBinaryScene(filename))
+    return loadSceneBinary(world, filename);
+  return loadJson(world, nullptr, filename);
 }
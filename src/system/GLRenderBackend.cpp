@@ -0,0 +1,229 @@
+#include "system/GLRenderBackend.hpp"
+#include "math/VertexQuantization.hpp"
+#include <cstddef>
+#include <glad/glad.h>
+#include <iostream>
+
+namespace {
+
+// Cofactor matrix of the upper 3x3: transpose(inverse()) up to a positive
+// factor, which the fragment shader normalizes away
+glm::mat3 normalMatrix(const glm::mat4 &m) {
+  glm::vec3 c0(m[0][0], m[0][1], m[0][2]);
+  glm::vec3 c1(m[1][0], m[1][1], m[1][2]);
+  glm::vec3 c2(m[2][0], m[2][1], m[2][2]);
+  glm::mat3 n(glm::cross(c1, c2), glm::cross(c2, c0), glm::cross(c0, c1));
+  // Mirroring transforms would flip the normals
+  if (glm::dot(c0, n[0]) < 0.0f)
+    n = glm::mat3(-n[0], -n[1], -n[2]);
+  return n;
+}
+
+} // namespace
+
+GLRenderBackend::GLRenderBackend() {
+  glGenBuffers(1, &instanceVBO);
+  glGenBuffers(1, &frameUBO);
+  glBindBuffer(GL_UNIFORM_BUFFER, frameUBO);
+  glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameData), nullptr, GL_DYNAMIC_DRAW);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+GLRenderBackend::~GLRenderBackend() {
+  glDeleteBuffers(1, &instanceVBO);
+  glDeleteBuffers(1, &frameUBO);
+}
+
+std::uint32_t GLRenderBackend::addShader(Shader *shader) {
+  if (!shader->bindUniformBlock("FrameData", FRAME_DATA_BINDING))
+    std::cerr << "Shader " << shader->getID() << " has no FrameData block"
+              << std::endl;
+  shaders.push_back({shader, shader->getUniformLocation("useTexture"),
+                     shader->getUniformLocation("objectColor"),
+                     shader->getUniformLocation("positionScale"),
+                     shader->getUniformLocation("positionOffset"),
+                     shader->getUniformLocation("octahedralNormals")});
+  return static_cast<std::uint32_t>(shaders.size() - 1);
+}
+
+void GLRenderBackend::setFrameData(const FrameData &frame) {
+  glBindBuffer(GL_UNIFORM_BUFFER, frameUBO);
+  glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameData), &frame);
+  glBindBuffer(GL_UNIFORM_BUFFER, 0);
+  glBindBufferBase(GL_UNIFORM_BUFFER, FRAME_DATA_BINDING, frameUBO);
+}
+
+std::uint32_t GLRenderBackend::addMaterial(const Material &material) {
+  materials.push_back(material);
+  return static_cast<std::uint32_t>(materials.size() - 1);
+}
+
+void GLRenderBackend::beginSubmit(const std::vector<DrawPacket> &packets) {
+  instances.resize(packets.size());
+  for (std::size_t i = 0; i < packets.size(); ++i) {
+    instances[i].model = *packets[i].transform;
+    instances[i].normalMatrix = normalMatrix(*packets[i].transform);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+  glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(InstanceData),
+               instances.data(), GL_STREAM_DRAW);
+  currentShader = nullptr;
+  currentModel = nullptr;
+}
+
+void GLRenderBackend::setShader(std::uint32_t shader) {
+  const ShaderEntry *next = &shaders[shader];
+  if (next == currentShader)
+    return;
+  next->shader->use();
+  currentShader = next;
+  // The model may stay bound across the switch
+  if (currentModel)
+    setVertexFormatUniforms();
+}
+
+void GLRenderBackend::setMaterial(std::uint32_t material) {
+  const Material &m = materials[material];
+  currentShader->shader->setBool(currentShader->useTexture, m.useTexture);
+  currentShader->shader->setVec3(currentShader->objectColor, m.color);
+}
+
+void GLRenderBackend::setModel(Model *model, std::uint32_t lod) {
+  currentLod = model->lod(lod);
+  if (model == currentModel)
+    return;
+  if (!model->uploadedToGPU) {
+    uploadModelToGPU(model);
+  }
+  glBindVertexArray(model->VAO);
+  currentModel = model;
+  setVertexFormatUniforms();
+}
+
+void GLRenderBackend::setVertexFormatUniforms() {
+  const Shader *shader = currentShader->shader;
+  if (currentModel->compactVertices) {
+    PositionQuantization q = positionQuantization(*currentModel);
+    shader->setVec3(currentShader->positionScale, q.scale);
+    shader->setVec3(currentShader->positionOffset, q.offset);
+  } else {
+    shader->setVec3(currentShader->positionScale, glm::vec3(1.0f));
+    shader->setVec3(currentShader->positionOffset, glm::vec3(0.0f));
+  }
+  shader->setBool(currentShader->octahedralNormals,
+                  currentModel->compactVertices);
+}
+
+void GLRenderBackend::drawInstances(std::size_t first, std::size_t count) {
+  bindInstanceAttributes(first);
+  const std::size_t indexSize = currentModel->shortIndices
+                                    ? sizeof(std::uint16_t)
+                                    : sizeof(unsigned int);
+  glDrawElementsInstanced(
+      GL_TRIANGLES, static_cast<GLsizei>(currentLod.indexCount),
+      currentModel->shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT,
+      (void *)(currentLod.indexOffset * indexSize),
+      static_cast<GLsizei>(count));
+}
+
+void GLRenderBackend::endSubmit() {
+  glBindVertexArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Points the per-instance attributes of the bound VAO at instances[first]
+void GLRenderBackend::bindInstanceAttributes(std::size_t first) {
+  glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+  const GLsizei stride = sizeof(InstanceData);
+  std::size_t base = first * sizeof(InstanceData);
+  for (int col = 0; col < 4; ++col)
+    glVertexAttribPointer(3 + col, 4, GL_FLOAT, GL_FALSE, stride,
+                          (void *)(base + offsetof(InstanceData, model) +
+                                   col * sizeof(glm::vec4)));
+  for (int col = 0; col < 3; ++col)
+    glVertexAttribPointer(7 + col, 3, GL_FLOAT, GL_FALSE, stride,
+                          (void *)(base + offsetof(InstanceData, normalMatrix) +
+                                   col * sizeof(glm::vec3)));
+}
+
+void GLRenderBackend::uploadModelToGPU(Model *model) {
+  glGenVertexArrays(1, &model->VAO);
+  glGenBuffers(1, &model->VBO);
+  glGenBuffers(1, &model->EBO);
+
+  glBindVertexArray(model->VAO);
+
+  // location = 0 : position (vec3)
+  // location = 1 : normal   (vec3, or octahedral vec2 if compact)
+  // location = 2 : texcoord (vec2)
+  glBindBuffer(GL_ARRAY_BUFFER, model->VBO);
+  model->compactVertices = compactVertices;
+  if (compactVertices) {
+    std::vector<CompactVertex> packed = encodeCompactVertices(*model);
+    glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(CompactVertex),
+                 packed.data(), GL_STATIC_DRAW);
+    const GLsizei stride = sizeof(CompactVertex);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+                          (void *)offsetof(CompactVertex, position));
+    // Scaled in the shader, GL versions disagree on snorm conversion
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_FALSE, stride,
+                          (void *)offsetof(CompactVertex, normal));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride,
+                          (void *)offsetof(CompactVertex, texcoord));
+  } else {
+    // Vertices are already interleaved in the buffer layout
+    glBufferData(GL_ARRAY_BUFFER, model->vertices.size() * sizeof(float),
+                 model->vertices.data(), GL_STATIC_DRAW);
+    const GLsizei stride = (GLsizei)(Model::VERTEX_FLOATS * sizeof(float));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void *)0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride,
+                          (void *)(Model::NORMAL_OFFSET * sizeof(float)));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride,
+                          (void *)(Model::TEXCOORD_OFFSET * sizeof(float)));
+  }
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model->EBO);
+  model->shortIndices = fitsShortIndices(model->vertexCount());
+  const std::size_t indexSize = model->shortIndices ? sizeof(std::uint16_t)
+                                                    : sizeof(unsigned int);
+  if (model->shortIndices) {
+    std::vector<std::uint16_t> narrow = narrowIndices(model->indices);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 narrow.size() * sizeof(std::uint16_t), narrow.data(),
+                 GL_STATIC_DRAW);
+  } else {
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 model->indices.size() * sizeof(unsigned int),
+                 model->indices.data(), GL_STATIC_DRAW);
+  }
+  model->gpuBytes =
+      model->vertexCount() * (compactVertices
+                                  ? sizeof(CompactVertex)
+                                  : Model::VERTEX_FLOATS * sizeof(float)) +
+      model->indices.size() * indexSize;
+
+  // location = 3..9 : per-instance data, see bindInstanceAttributes
+  glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+  for (GLuint loc = 3; loc <= 9; ++loc) {
+    glEnableVertexAttribArray(loc);
+    glVertexAttribDivisor(loc, 1);
+  }
+
+  glBindVertexArray(0);
+  model->uploadedToGPU = true;
+  if (releaseCpuData)
+    model->releaseCpuData();
+}
+
+void GLRenderBackend::deleteModelBuffers(unsigned int vao, unsigned int vbo,
+                                         unsigned int ebo) {
+  glDeleteVertexArrays(1, &vao);
+  glDeleteBuffers(1, &vbo);
+  glDeleteBuffers(1, &ebo);
+}
@@ -0,0 +1,91 @@
+#include "system/RenderQueue.hpp"
+#include <algorithm>
+
+std::uint64_t RenderQueue::makeKey(std::uint32_t shader, std::uint32_t material,
+                                   std::uint32_t model, std::uint32_t lod,
+                                   float depth01) {
+  const std::uint32_t depthMax = (1u << 21) - 1;
+  float d = std::clamp(depth01, 0.0f, 1.0f);
+  std::uint64_t depth = static_cast<std::uint64_t>(d * depthMax);
+  return (std::uint64_t(shader & 0xFF) << 56) |
+         (std::uint64_t(material & 0xFFFF) << 40) |
+         (std::uint64_t(model & 0xFFFF) << 24) |
+         (std::uint64_t(lod & 0x7) << 21) | depth;
+}
+
+void RenderQueue::sort() {
+  const std::size_t n = packets.size();
+  if (n < 2)
+    return;
+  scratch.resize(n);
+
+  // All eight histograms in one read of the keys
+  std::size_t counts[8][256] = {};
+  for (const DrawPacket &p : packets)
+    for (int pass = 0; pass < 8; ++pass)
+      ++counts[pass][(p.key >> (pass * 8)) & 0xFF];
+
+  DrawPacket *src = packets.data();
+  DrawPacket *dst = scratch.data();
+  for (int pass = 0; pass < 8; ++pass) {
+    std::size_t *count = counts[pass];
+    const int shift = pass * 8;
+    if (count[(src[0].key >> shift) & 0xFF] == n)
+      continue;
+    std::size_t offset = 0;
+    for (int b = 0; b < 256; ++b) {
+      std::size_t c = count[b];
+      count[b] = offset;
+      offset += c;
+    }
+    for (std::size_t i = 0; i < n; ++i)
+      dst[count[(src[i].key >> shift) & 0xFF]++] = src[i];
+    std::swap(src, dst);
+  }
+  if (src != packets.data())
+    packets.swap(scratch);
+}
+
+RenderQueue::Stats RenderQueue::submit(RenderBackend &backend) const {
+  Stats stats;
+  stats.packets = packets.size();
+  if (packets.empty())
+    return stats;
+
+  backend.beginSubmit(packets);
+  const DrawPacket *prev = nullptr;
+  std::size_t runStart = 0;
+  for (std::size_t i = 0; i < packets.size(); ++i) {
+    const DrawPacket &p = packets[i];
+    bool shaderChanged = !prev || p.shader != prev->shader;
+    bool materialChanged = shaderChanged || p.material != prev->material;
+    bool modelChanged = materialChanged || p.model != prev->model ||
+                        p.lod != prev->lod;
+    if (!modelChanged) {
+      prev = &p;
+      continue;
+    }
+    if (prev) {
+      backend.drawInstances(runStart, i - runStart);
+      ++stats.draws;
+    }
+    if (shaderChanged) {
+      backend.setShader(p.shader);
+      ++stats.shaderChanges;
+    }
+    if (materialChanged) {
+      backend.setMaterial(p.material);
+      ++stats.materialChanges;
+    }
+    if (!prev || p.model != prev->model || p.lod != prev->lod) {
+      backend.setModel(p.model, p.lod);
+      ++stats.modelChanges;
+    }
+    runStart = i;
+    prev = &p;
+  }
+  backend.drawInstances(runStart, packets.size() - runStart);
+  ++stats.draws;
+  backend.endSubmit();
+  return stats;
+}
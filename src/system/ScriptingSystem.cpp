@@ -1,22 +1,57 @@
 #include "system/ScriptingSystem.hpp"
+#include <atomic>
 #include <cmath>
+#include <fstream>
 #include <iostream>
 
-// Lua global variables:
-// "world_ptr" — lightuserdata pointiong to World*
-// "entity_id" — current entity
-// "dt" — delta time
+// Lua globals:
+// "dt" — delta time of the frame
+// "get_position", "set_position", "rotate" — closures over this system
+// Per-entity environment (scripts not marked "-- batch"):
+// "entity_id" — the entity the script instance belongs to
+// "transform" — proxy of its TransformComponent: x, y, z (position),
+//   rx, ry, rz (rotation, deg), sx, sy, sz (scale); writes mark it dirty
 
-ScriptingSystem::ScriptingSystem(World *world) : world(world) {
+namespace {
+
+std::atomic<std::uint32_t> lastSerial{0};
+
+// First line of batched scripts
+const std::string BATCH_MARKER = "-- batch";
+
+bool hasBatchMarker(const std::string &path) {
+  std::ifstream file(path);
+  std::string line;
+  if (!std::getline(file, line))
+    return false;
+  line.erase(line.find_last_not_of(" \t\r") + 1);
+  return line == BATCH_MARKER;
+}
+
+// lua_Writer collecting a dumped chunk
+int writeChunk(lua_State *, const void *data, size_t size, void *out) {
+  static_cast<std::string *>(out)->append(static_cast<const char *>(data),
+                                          size);
+  return 0;
+}
+
+} // namespace
+
+ScriptingSystem::ScriptingSystem(World *world)
+    : world(world), serial(++lastSerial) {
+  world->trackScriptRemovals();
   L = luaL_newstate();
   if (!L) {
     std::cerr << "Failed to create Lua state" << std::endl;
     return;
   }
   luaL_openlibs(L);
-  // Saving World pointer into global variable
-  lua_pushlightuserdata(L, static_cast<void *>(world));
-  lua_setglobal(L, "world_ptr");
+
+  // Environments read through to the globals
+  lua_newtable(L);
+  lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+  lua_setfield(L, -2, "__index");
+  envMetatable = luaL_ref(L, LUA_REGISTRYINDEX);
 
   registerFunctions();
 }
@@ -34,76 +69,229 @@ void ScriptingSystem::init() {
 void ScriptingSystem::update(float dt) {
   if (!L)
     return;
+  lua_pushnumber(L, dt);
+  lua_setglobal(L, "dt");
+  releaseBindings();
+  for (std::uint32_t id : batchedScripts) {
+    scripts[id].entities.clear();
+    scripts[id].transforms.clear();
+  }
   // For every Entity with LuaScriptComponent:
-  for (Entity e : world->getEntities()) {
-    auto sc = world->getScript(e);
-    if (sc) {
-      // Check if loaded
-      std::string loadedFlag = "script_" + std::to_string(e) + "_loaded";
-      lua_getglobal(L, loadedFlag.c_str());
-      bool isLoaded = lua_toboolean(L, -1);
-      lua_pop(L, 1);
-      if (!isLoaded) {
-        // Load
-        int status = luaL_dofile(L, sc->scriptPath.c_str());
-        if (status != LUA_OK) {
-          const char *msg = lua_tostring(L, -1);
-          std::cerr << "Lua load error for entity " << e << ": "
-                    << (msg ? msg : "unknown") << std::endl;
-          lua_pop(L, 1);
-        } else {
-          // Mark loaded
-          lua_pushboolean(L, 1);
-          lua_setglobal(L, loadedFlag.c_str());
-        }
-      }
-      callLuaUpdate(e, dt);
+  world->view<LuaScriptComponent>().each([&](Entity e,
+                                             LuaScriptComponent &sc) {
+    const std::uint32_t slot = entityIndex(e);
+    if (slot >= bindings.size())
+      bindings.resize(slot + 1);
+    Binding &binding = bindings[slot];
+    // New component or path, or an id from another ScriptingSystem
+    if (sc.owner != serial) {
+      sc.scriptId = compileScript(sc.scriptPath);
+      sc.owner = serial;
     }
-  }
+    // New entity in the slot, or its script was changed
+    if (binding.entity != e || binding.script != sc.scriptId)
+      bind(binding, e, sc.scriptId);
+    Script &script = scripts[binding.script];
+    if (script.updateBatch != LUA_NOREF) {
+      script.entities.push_back(e);
+      script.transforms.push_back(world->getTransform(e));
+      return;
+    }
+    callLuaUpdate(e, binding);
+  });
+  // Scripts can't add or remove components, the pointers stay valid
+  currentEntity = INVALID_ENTITY;
+  for (std::uint32_t id : batchedScripts)
+    callLuaUpdateBatch(id, dt);
 }
 
-void ScriptingSystem::registerFunctions() {
-  // Register global functions
-  lua_register(L, "get_position", l_get_position);
-  lua_register(L, "set_position", l_set_position);
-  lua_register(L, "rotate", l_rotate);
+void ScriptingSystem::pushEnvironment() {
+  lua_newtable(L);
+  lua_rawgeti(L, LUA_REGISTRYINDEX, envMetatable);
+  lua_setmetatable(L, -2);
 }
 
-// Get World*from global var
-World *ScriptingSystem::getWorldFromLua(lua_State *L) {
-  lua_getglobal(L, "world_ptr");
-  World *w = static_cast<World *>(lua_touserdata(L, -1));
+int ScriptingSystem::runChunk(const Script &script) {
+  int status = luaL_loadbufferx(L, script.chunk.data(), script.chunk.size(),
+                                script.path.c_str(), "b");
+  if (status == LUA_OK) {
+    lua_pushvalue(L, -2);
+    lua_setupvalue(L, -2, 1); // _ENV of the main chunk
+    status = lua_pcall(L, 0, 0, 0);
+  }
+  return status;
+}
+
+std::uint32_t ScriptingSystem::compileScript(const std::string &path) {
+  auto it = scriptIds.find(path);
+  if (it != scriptIds.end())
+    return it->second;
+  Script script;
+  script.path = path;
+  if (luaL_loadfile(L, path.c_str()) != LUA_OK) {
+    const char *msg = lua_tostring(L, -1);
+    std::cerr << "Lua load error in " << path << ": "
+              << (msg ? msg : "unknown") << std::endl;
+  } else {
+    // Instances load the bytecode: every load is a new closure with its
+    // own _ENV upvalue, which one shared closure couldn't give them
+    lua_dump(L, writeChunk, &script.chunk, 0);
+    script.batched = hasBatchMarker(path);
+  }
   lua_pop(L, 1);
-  return w;
+  const std::uint32_t id = static_cast<std::uint32_t>(scripts.size());
+  scripts.push_back(std::move(script));
+  scriptIds.emplace(path, id);
+  if (scripts[id].batched)
+    loadBatch(id);
+  return id;
 }
 
-// Get current Entity from global var
-Entity ScriptingSystem::getCurrentEntity(lua_State *L) {
-  lua_getglobal(L, "entity_id");
-  if (!lua_isinteger(L, -1)) {
+void ScriptingSystem::loadBatch(std::uint32_t id) {
+  Script &script = scripts[id];
+  currentEntity = INVALID_ENTITY;
+  pushEnvironment();
+  if (runChunk(script) != LUA_OK) {
+    const char *msg = lua_tostring(L, -1);
+    std::cerr << "Lua load error in " << script.path << ": "
+              << (msg ? msg : "unknown") << std::endl;
+    lua_pop(L, 2); // message, environment
+    return;
+  }
+  lua_getfield(L, -1, "update_batch");
+  if (!lua_isfunction(L, -1)) {
+    std::cerr << "Batched script " << script.path
+              << " defines no update_batch" << std::endl;
+    lua_pop(L, 2);
+    return;
+  }
+  script.updateBatch = luaL_ref(L, LUA_REGISTRYINDEX);
+  script.env = luaL_ref(L, LUA_REGISTRYINDEX);
+  *static_cast<std::uint32_t *>(lua_newuserdata(L, sizeof(std::uint32_t))) =
+      id;
+  luaL_setmetatable(L, BATCH_METATABLE);
+  script.batch = luaL_ref(L, LUA_REGISTRYINDEX);
+  batchedScripts.push_back(id);
+}
+
+void ScriptingSystem::bind(Binding &binding, Entity e, std::uint32_t id) {
+  unbind(binding);
+  binding.entity = e;
+  binding.script = id;
+  const Script &script = scripts[binding.script];
+  // Batched scripts run once per frame, not per entity
+  if (script.chunk.empty() || script.batched)
+    return;
+
+  pushEnvironment();
+  lua_pushinteger(L, static_cast<lua_Integer>(e));
+  lua_setfield(L, -2, "entity_id");
+  // Made once here, so reading and writing it allocates nothing
+  *static_cast<Entity *>(lua_newuserdata(L, sizeof(Entity))) = e;
+  luaL_setmetatable(L, TRANSFORM_METATABLE);
+  lua_setfield(L, -2, "transform");
+
+  currentEntity = e;
+  if (runChunk(script) != LUA_OK) {
+    const char *msg = lua_tostring(L, -1);
+    std::cerr << "Lua load error for entity " << e << ": "
+              << (msg ? msg : "unknown") << std::endl;
+    lua_pop(L, 2); // message, environment
+    return;
+  }
+  lua_getfield(L, -1, "update");
+  if (lua_isfunction(L, -1))
+    binding.update = luaL_ref(L, LUA_REGISTRYINDEX);
+  else
     lua_pop(L, 1);
-    return INVALID_ENTITY;
+  binding.env = luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+void ScriptingSystem::unbind(Binding &binding) {
+  luaL_unref(L, LUA_REGISTRYINDEX, binding.update);
+  luaL_unref(L, LUA_REGISTRYINDEX, binding.env);
+  binding = Binding{};
+}
+
+void ScriptingSystem::releaseBindings() {
+  if (world->takeScriptRemovals(removals)) {
+    // Cleared World, every binding is dead
+    for (Binding &binding : bindings)
+      if (binding.entity != INVALID_ENTITY)
+        unbind(binding);
   }
-  Entity e = static_cast<Entity>(lua_tointeger(L, -1));
+  for (Entity e : removals) {
+    const std::uint32_t slot = entityIndex(e);
+    if (slot < bindings.size() && bindings[slot].entity == e)
+      unbind(bindings[slot]);
+  }
+}
+
+void ScriptingSystem::registerFunctions() {
+  // Global functions with this system as upvalue
+  const luaL_Reg functions[] = {{"get_position", l_get_position},
+                                {"set_position", l_set_position},
+                                {"rotate", l_rotate},
+                                {nullptr, nullptr}};
+  lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+  lua_pushlightuserdata(L, this);
+  luaL_setfuncs(L, functions, 1);
+  lua_pop(L, 1);
+
+  // Metatable of the transform proxies, same upvalue
+  const luaL_Reg transformMethods[] = {{"__index", l_transform_index},
+                                       {"__newindex", l_transform_newindex},
+                                       {nullptr, nullptr}};
+  luaL_newmetatable(L, TRANSFORM_METATABLE);
+  lua_pushlightuserdata(L, this);
+  luaL_setfuncs(L, transformMethods, 1);
   lua_pop(L, 1);
-  return e;
+
+  // Metatable of update_batch()'s entities, methods in __index
+  const luaL_Reg batchMethods[] = {{"entity", l_batch_entity},
+                                   {"position", l_batch_position},
+                                   {"set_position", l_batch_set_position},
+                                   {"rotation", l_batch_rotation},
+                                   {"set_rotation", l_batch_set_rotation},
+                                   {"translate", l_batch_translate},
+                                   {"rotate", l_batch_rotate},
+                                   {nullptr, nullptr}};
+  luaL_newmetatable(L, BATCH_METATABLE);
+  lua_newtable(L);
+  lua_pushlightuserdata(L, this);
+  luaL_setfuncs(L, batchMethods, 1);
+  lua_setfield(L, -2, "__index");
+  lua_pushlightuserdata(L, this);
+  lua_pushcclosure(L, l_batch_len, 1);
+  lua_setfield(L, -2, "__len");
+  lua_pop(L, 1);
+}
+
+ScriptingSystem *ScriptingSystem::getSystem(lua_State *L) {
+  return static_cast<ScriptingSystem *>(
+      lua_touserdata(L, lua_upvalueindex(1)));
 }
 
-// Lua: get_position(): returns table {x, y, z}
+World *ScriptingSystem::getWorldFromLua(lua_State *L) {
+  return getSystem(L)->world;
+}
+
+// Entity whose script is running
+Entity ScriptingSystem::getCurrentEntity(lua_State *L) {
+  return getSystem(L)->currentEntity;
+}
+
+// Lua: get_position(): returns x, y, z, or nil without a transform
 int ScriptingSystem::l_get_position(lua_State *L) {
   World *w = getWorldFromLua(L);
   Entity e = getCurrentEntity(L);
   if (w && e != INVALID_ENTITY) {
     TransformComponent *tc = w->getTransform(e);
     if (tc) {
-      lua_newtable(L);
       lua_pushnumber(L, tc->position[0]);
-      lua_rawseti(L, -2, 1);
       lua_pushnumber(L, tc->position[1]);
-      lua_rawseti(L, -2, 2);
       lua_pushnumber(L, tc->position[2]);
-      lua_rawseti(L, -2, 3);
-      return 1;
+      return 3;
     }
   }
   // if no transform or error return nil
@@ -124,6 +312,7 @@ int ScriptingSystem::l_set_position(lua_State *L) {
         tc->position[0] = static_cast<float>(lua_tonumber(L, 1));
         tc->position[1] = static_cast<float>(lua_tonumber(L, 2));
         tc->position[2] = static_cast<float>(lua_tonumber(L, 3));
+        w->markDirty(e, *tc);
       } else {
         std::cerr << "set_position: invalid arguments" << std::endl;
       }
@@ -132,40 +321,57 @@ int ScriptingSystem::l_set_position(lua_State *L) {
   return 0;
 }
 
-// Lua: rotate(axisTable, angle)
-// axisTable: table {x,y,z}, angle: deg
+namespace {
+
+void rotateAround(TransformComponent &tc, float ax, float ay, float az,
+                  float angle) {
+  // For simplicity: if axis matches with X/Y/Z (1,0,0) or (0,1,0) or
+  // (0,0,1), just add angle to rotation.
+  if (fabs(ax - 1.0f) < 1e-3f && fabs(ay) < 1e-3f && fabs(az) < 1e-3f) {
+    tc.rotation[0] += angle;
+  } else if (fabs(ay - 1.0f) < 1e-3f && fabs(ax) < 1e-3f && fabs(az) < 1e-3f) {
+    tc.rotation[1] += angle;
+  } else if (fabs(az - 1.0f) < 1e-3f && fabs(ax) < 1e-3f && fabs(ay) < 1e-3f) {
+    tc.rotation[2] += angle;
+  } else {
+    // Complex axis: add proportionally
+    tc.rotation[0] += ax * angle;
+    tc.rotation[1] += ay * angle;
+    tc.rotation[2] += az * angle;
+  }
+}
+
+} // namespace
+
+// Lua: rotate(x, y, z, angle), or rotate(axisTable, angle) as before
+// axis: x, y, z or table {x,y,z}, angle: deg
 int ScriptingSystem::l_rotate(lua_State *L) {
   World *w = getWorldFromLua(L);
   Entity e = getCurrentEntity(L);
   if (w && e != INVALID_ENTITY) {
     TransformComponent *tc = w->getTransform(e);
     if (tc) {
-      // Expectiong table and number
-      if (lua_gettop(L) >= 2 && lua_istable(L, 1) && lua_isnumber(L, 2)) {
+      if (lua_gettop(L) >= 4 && lua_isnumber(L, 1) && lua_isnumber(L, 2) &&
+          lua_isnumber(L, 3) && lua_isnumber(L, 4)) {
+        rotateAround(*tc, static_cast<float>(lua_tonumber(L, 1)),
+                     static_cast<float>(lua_tonumber(L, 2)),
+                     static_cast<float>(lua_tonumber(L, 3)),
+                     static_cast<float>(lua_tonumber(L, 4)));
+        w->markDirty(e, *tc);
+      } else if (lua_gettop(L) >= 2 && lua_istable(L, 1) &&
+                 lua_isnumber(L, 2)) {
+        // The table costs a garbage allocation per call, kept for old
+        // scripts
         lua_rawgeti(L, 1, 1);
         lua_rawgeti(L, 1, 2);
         lua_rawgeti(L, 1, 3);
-        if (lua_isnumber(L, -3) && lua_isnumber(L, -2) && lua_isnumber(L, -1)) {
-          float ax = static_cast<float>(lua_tonumber(L, -3));
-          float ay = static_cast<float>(lua_tonumber(L, -2));
-          float az = static_cast<float>(lua_tonumber(L, -1));
-          float angle = static_cast<float>(lua_tonumber(L, 2));
-          // For simplicity: if axis matches with X/Y/Z (1,0,0) or (0,1,0) or
-          // (0,0,1), just add angle to rotation.
-          if (fabs(ax - 1.0f) < 1e-3f && fabs(ay) < 1e-3f && fabs(az) < 1e-3f) {
-            tc->rotation[0] += angle;
-          } else if (fabs(ay - 1.0f) < 1e-3f && fabs(ax) < 1e-3f &&
-                     fabs(az) < 1e-3f) {
-            tc->rotation[1] += angle;
-          } else if (fabs(az - 1.0f) < 1e-3f && fabs(ax) < 1e-3f &&
-                     fabs(ay) < 1e-3f) {
-            tc->rotation[2] += angle;
-          } else {
-            // Complex axis: add proportionally
-            tc->rotation[0] += ax * angle;
-            tc->rotation[1] += ay * angle;
-            tc->rotation[2] += az * angle;
-          }
+        if (lua_isnumber(L, -3) && lua_isnumber(L, -2) &&
+            lua_isnumber(L, -1)) {
+          rotateAround(*tc, static_cast<float>(lua_tonumber(L, -3)),
+                       static_cast<float>(lua_tonumber(L, -2)),
+                       static_cast<float>(lua_tonumber(L, -1)),
+                       static_cast<float>(lua_tonumber(L, 2)));
+          w->markDirty(e, *tc);
         }
         lua_pop(L, 3); // clear axis vals
       } else {
@@ -176,23 +382,197 @@ int ScriptingSystem::l_rotate(lua_State *L) {
   return 0;
 }
 
-// Calls Lua update() for Entuty e, passing dt via global var.
-void ScriptingSystem::callLuaUpdate(Entity e, float dt) {
-  // Setting entity_id and dt
-  lua_pushinteger(L, static_cast<lua_Integer>(e));
-  lua_setglobal(L, "entity_id");
+// Component value behind a transform proxy key, nullptr if unknown
+float *ScriptingSystem::transformField(TransformComponent &tc,
+                                       const char *key) {
+  std::array<float, 3> *vec = &tc.position;
+  if (key[0] == 'r') {
+    vec = &tc.rotation;
+    ++key;
+  } else if (key[0] == 's') {
+    vec = &tc.scale;
+    ++key;
+  }
+  if (key[0] < 'x' || key[0] > 'z' || key[1] != '\0')
+    return nullptr;
+  return &(*vec)[key[0] - 'x'];
+}
+
+// Lua: transform.key, the transform proxy's __index
+int ScriptingSystem::l_transform_index(lua_State *L) {
+  const Entity e =
+      *static_cast<Entity *>(luaL_checkudata(L, 1, TRANSFORM_METATABLE));
+  TransformComponent *tc = getWorldFromLua(L)->getTransform(e);
+  const char *key = luaL_checkstring(L, 2);
+  float *field = tc ? transformField(*tc, key) : nullptr;
+  if (!field)
+    return luaL_error(L, "transform has no field '%s'", key);
+  lua_pushnumber(L, *field);
+  return 1;
+}
+
+// Lua: transform.key = value, the transform proxy's __newindex
+int ScriptingSystem::l_transform_newindex(lua_State *L) {
+  const Entity e =
+      *static_cast<Entity *>(luaL_checkudata(L, 1, TRANSFORM_METATABLE));
+  TransformComponent *tc = getWorldFromLua(L)->getTransform(e);
+  const char *key = luaL_checkstring(L, 2);
+  float *field = tc ? transformField(*tc, key) : nullptr;
+  if (!field)
+    return luaL_error(L, "transform has no field '%s'", key);
+  *field = static_cast<float>(luaL_checknumber(L, 3));
+  getWorldFromLua(L)->markDirty(e, *tc);
+  return 0;
+}
+
+// Batch of the method's self argument
+ScriptingSystem::Script &ScriptingSystem::checkBatch(lua_State *L) {
+  const std::uint32_t id =
+      *static_cast<std::uint32_t *>(luaL_checkudata(L, 1, BATCH_METATABLE));
+  return getSystem(L)->scripts[id];
+}
+
+// Transform of the entity at 1-based index arg, nullptr if it has none
+TransformComponent *ScriptingSystem::checkBatchTransform(lua_State *L,
+                                                         const Script &batch,
+                                                         int arg) {
+  const lua_Integer i = luaL_checkinteger(L, arg);
+  luaL_argcheck(L, i >= 1 && i <= lua_Integer(batch.entities.size()), arg,
+                "index out of range");
+  return batch.transforms[i - 1];
+}
+
+// Lua: #entities
+int ScriptingSystem::l_batch_len(lua_State *L) {
+  lua_pushinteger(L, static_cast<lua_Integer>(checkBatch(L).entities.size()));
+  return 1;
+}
+
+// Lua: entities:entity(i): entity id
+int ScriptingSystem::l_batch_entity(lua_State *L) {
+  const Script &batch = checkBatch(L);
+  checkBatchTransform(L, batch, 2);
+  lua_pushinteger(L, batch.entities[lua_tointeger(L, 2) - 1]);
+  return 1;
+}
+
+// Lua: entities:position(i): x, y, z, or nil without a transform
+int ScriptingSystem::l_batch_position(lua_State *L) {
+  TransformComponent *tc = checkBatchTransform(L, checkBatch(L), 2);
+  if (!tc) {
+    lua_pushnil(L);
+    return 1;
+  }
+  lua_pushnumber(L, tc->position[0]);
+  lua_pushnumber(L, tc->position[1]);
+  lua_pushnumber(L, tc->position[2]);
+  return 3;
+}
+
+// Lua: entities:set_position(i, x, y, z)
+int ScriptingSystem::l_batch_set_position(lua_State *L) {
+  const Script &batch = checkBatch(L);
+  TransformComponent *tc = checkBatchTransform(L, batch, 2);
+  if (tc) {
+    tc->position[0] = static_cast<float>(luaL_checknumber(L, 3));
+    tc->position[1] = static_cast<float>(luaL_checknumber(L, 4));
+    tc->position[2] = static_cast<float>(luaL_checknumber(L, 5));
+    getWorldFromLua(L)->markDirty(batch.entities[lua_tointeger(L, 2) - 1],
+                                  *tc);
+  }
+  return 0;
+}
+
+// Lua: entities:rotation(i): x, y, z in deg, or nil without a transform
+int ScriptingSystem::l_batch_rotation(lua_State *L) {
+  TransformComponent *tc = checkBatchTransform(L, checkBatch(L), 2);
+  if (!tc) {
+    lua_pushnil(L);
+    return 1;
+  }
+  lua_pushnumber(L, tc->rotation[0]);
+  lua_pushnumber(L, tc->rotation[1]);
+  lua_pushnumber(L, tc->rotation[2]);
+  return 3;
+}
+
+// Lua: entities:set_rotation(i, x, y, z)
+int ScriptingSystem::l_batch_set_rotation(lua_State *L) {
+  const Script &batch = checkBatch(L);
+  TransformComponent *tc = checkBatchTransform(L, batch, 2);
+  if (tc) {
+    tc->rotation[0] = static_cast<float>(luaL_checknumber(L, 3));
+    tc->rotation[1] = static_cast<float>(luaL_checknumber(L, 4));
+    tc->rotation[2] = static_cast<float>(luaL_checknumber(L, 5));
+    getWorldFromLua(L)->markDirty(batch.entities[lua_tointeger(L, 2) - 1],
+                                  *tc);
+  }
+  return 0;
+}
+
+// Lua: entities:translate(x, y, z): moves every entity of the batch
+int ScriptingSystem::l_batch_translate(lua_State *L) {
+  const Script &batch = checkBatch(L);
+  const float x = static_cast<float>(luaL_checknumber(L, 2));
+  const float y = static_cast<float>(luaL_checknumber(L, 3));
+  const float z = static_cast<float>(luaL_checknumber(L, 4));
+  World *w = getWorldFromLua(L);
+  for (std::size_t i = 0; i < batch.transforms.size(); ++i) {
+    TransformComponent *tc = batch.transforms[i];
+    if (!tc)
+      continue;
+    tc->position[0] += x;
+    tc->position[1] += y;
+    tc->position[2] += z;
+    w->markDirty(batch.entities[i], *tc);
+  }
+  return 0;
+}
+
+// Lua: entities:rotate(x, y, z, angle): rotate() for every entity
+int ScriptingSystem::l_batch_rotate(lua_State *L) {
+  const Script &batch = checkBatch(L);
+  const float ax = static_cast<float>(luaL_checknumber(L, 2));
+  const float ay = static_cast<float>(luaL_checknumber(L, 3));
+  const float az = static_cast<float>(luaL_checknumber(L, 4));
+  const float angle = static_cast<float>(luaL_checknumber(L, 5));
+  World *w = getWorldFromLua(L);
+  for (std::size_t i = 0; i < batch.transforms.size(); ++i) {
+    TransformComponent *tc = batch.transforms[i];
+    if (!tc)
+      continue;
+    rotateAround(*tc, ax, ay, az, angle);
+    w->markDirty(batch.entities[i], *tc);
+  }
+  return 0;
+}
+
+// Calls update_batch(entities, dt) of script id, if it has entities
+void ScriptingSystem::callLuaUpdateBatch(std::uint32_t id, float dt) {
+  const Script &script = scripts[id];
+  if (script.entities.empty())
+    return;
+  lua_rawgeti(L, LUA_REGISTRYINDEX, script.updateBatch);
+  lua_rawgeti(L, LUA_REGISTRYINDEX, script.batch);
   lua_pushnumber(L, dt);
-  lua_setglobal(L, "dt");
+  if (lua_pcall(L, 2, 0, 0) != LUA_OK) {
+    const char *msg = lua_tostring(L, -1);
+    std::cerr << "Lua runtime error in update_batch of " << script.path
+              << ": " << (msg ? msg : "unknown") << std::endl;
+    lua_pop(L, 1);
+  }
+}
 
-  lua_getglobal(L, "update");
-  if (lua_isfunction(L, -1)) {
-    if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
-      const char *msg = lua_tostring(L, -1);
-      std::cerr << "Lua runtime error in update for entity " << e << ": "
-                << (msg ? msg : "unknown") << std::endl;
-      lua_pop(L, 1);
-    }
-  } else {
+// Calls the update() bound for e
+void ScriptingSystem::callLuaUpdate(Entity e, const Binding &binding) {
+  if (binding.update == LUA_NOREF)
+    return;
+  currentEntity = e;
+  lua_rawgeti(L, LUA_REGISTRYINDEX, binding.update);
+  if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
+    const char *msg = lua_tostring(L, -1);
+    std::cerr << "Lua runtime error in update for entity " << e << ": "
+              << (msg ? msg : "unknown") << std::endl;
     lua_pop(L, 1);
   }
 }
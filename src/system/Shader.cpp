@@ -28,28 +28,80 @@ Shader::Shader(const std::string &vertexSrc, const std::string &fragmentSrc) {
 
   glDeleteShader(vertex);
   glDeleteShader(fragment);
+
+  reflectUniforms();
 }
 
 Shader::~Shader() { glDeleteProgram(ID); }
 
 void Shader::use() const { glUseProgram(ID); }
 
+int Shader::getUniformLocation(const std::string &name) const {
+  auto it = uniformLocations.find(name);
+  return it != uniformLocations.end() ? it->second : -1;
+}
+
+bool Shader::bindUniformBlock(const std::string &blockName,
+                              unsigned int binding) const {
+  unsigned int index = glGetUniformBlockIndex(ID, blockName.c_str());
+  if (index == GL_INVALID_INDEX)
+    return false;
+  glUniformBlockBinding(ID, index, binding);
+  return true;
+}
+
 void Shader::setBool(const std::string &name, bool value) const {
-  glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+  setBool(getUniformLocation(name), value);
 }
 void Shader::setInt(const std::string &name, int value) const {
-  glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+  setInt(getUniformLocation(name), value);
 }
 void Shader::setFloat(const std::string &name, float value) const {
-  glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+  setFloat(getUniformLocation(name), value);
 }
-#include <glm/gtc/type_ptr.hpp>
 void Shader::setMat4(const std::string &name, const glm::mat4 &mat) const {
-  glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE,
-                     glm::value_ptr(mat));
+  setMat4(getUniformLocation(name), mat);
 }
 void Shader::setVec3(const std::string &name, const glm::vec3 &vec) const {
-  glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, glm::value_ptr(vec));
+  setVec3(getUniformLocation(name), vec);
+}
+
+#include <glm/gtc/type_ptr.hpp>
+void Shader::setBool(int location, bool value) const {
+  glUniform1i(location, (int)value);
+}
+void Shader::setInt(int location, int value) const {
+  glUniform1i(location, value);
+}
+void Shader::setFloat(int location, float value) const {
+  glUniform1f(location, value);
+}
+void Shader::setMat4(int location, const glm::mat4 &mat) const {
+  glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(mat));
+}
+void Shader::setVec3(int location, const glm::vec3 &vec) const {
+  glUniform3fv(location, 1, glm::value_ptr(vec));
+}
+
+// Default-block uniforms only, members of uniform blocks have no location
+void Shader::reflectUniforms() {
+  int count = 0;
+  glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+  char name[256];
+  for (int i = 0; i < count; ++i) {
+    GLsizei length = 0;
+    GLint size = 0;
+    GLenum type = 0;
+    glGetActiveUniform(ID, i, sizeof(name), &length, &size, &type, name);
+    int location = glGetUniformLocation(ID, name);
+    if (location < 0)
+      continue;
+    std::string key(name, length);
+    // Arrays are reported as "name[0]", also accept the bare name
+    if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0)
+      uniformLocations[key.substr(0, key.size() - 3)] = location;
+    uniformLocations[key] = location;
+  }
 }
 
 void Shader::checkCompileErrors(unsigned int shader,
@@ -0,0 +1,108 @@
+#include "system/SystemScheduler.hpp"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+void SystemScheduler::addSystem(const std::string &name,
+                                const SystemAccess &access,
+                                std::function<void()> run) {
+  systems.push_back({name, access, std::move(run)});
+  stats.push_back({name});
+}
+
+void SystemScheduler::resetStats() {
+  for (SystemStats &s : stats)
+    s = {s.name};
+}
+
+void SystemScheduler::runTimed(std::size_t i) {
+  auto start = std::chrono::steady_clock::now();
+  systems[i].run();
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  SystemStats &s = stats[i];
+  ++s.runs;
+  s.totalSeconds += elapsed.count();
+  s.maxSeconds = std::max(s.maxSeconds, elapsed.count());
+}
+
+void SystemScheduler::runFrame() {
+  const std::size_t n = systems.size();
+  if (n == 0)
+    return;
+
+  // Edge i -> j for every conflicting pair, i registered first
+  std::vector<std::vector<std::size_t>> successors(n);
+  std::vector<std::size_t> remaining(n, 0);
+  for (std::size_t j = 0; j < n; ++j) {
+    for (std::size_t i = 0; i < j; ++i) {
+      if (systems[i].access.conflictsWith(systems[j].access)) {
+        successors[i].push_back(j);
+        ++remaining[j];
+      }
+    }
+  }
+
+  const bool parallel = pool && pool->getWorkerCount() > 0;
+  std::mutex mutex;
+  std::condition_variable changed;
+  std::deque<std::size_t> mainQueue;
+  std::vector<std::size_t> running;
+  std::size_t finished = 0;
+
+  // All of the helpers below expect mutex to be held
+  auto begin = [&](std::size_t i) {
+    for (std::size_t other : running) {
+      (void)other;
+      assert(!systems[i].access.conflictsWith(systems[other].access) &&
+             "conflicting systems scheduled concurrently");
+    }
+    running.push_back(i);
+  };
+  std::function<void(std::size_t)> dispatch;
+  auto end = [&](std::size_t i) {
+    running.erase(std::find(running.begin(), running.end(), i));
+    ++finished;
+    for (std::size_t next : successors[i])
+      if (--remaining[next] == 0)
+        dispatch(next);
+    changed.notify_all();
+  };
+  dispatch = [&](std::size_t i) {
+    if (!parallel || systems[i].access.mainThread) {
+      mainQueue.push_back(i);
+      return;
+    }
+    pool->submit([&, i] {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        begin(i);
+      }
+      runTimed(i);
+      std::lock_guard<std::mutex> lock(mutex);
+      end(i);
+    });
+  };
+
+  std::unique_lock<std::mutex> lock(mutex);
+  for (std::size_t i = 0; i < n; ++i)
+    if (remaining[i] == 0)
+      dispatch(i);
+
+  while (finished < n) {
+    if (mainQueue.empty()) {
+      changed.wait(lock);
+      continue;
+    }
+    std::size_t i = mainQueue.front();
+    mainQueue.pop_front();
+    begin(i);
+    lock.unlock();
+    runTimed(i);
+    lock.lock();
+    end(i);
+  }
+}
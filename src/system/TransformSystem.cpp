@@ -0,0 +1,258 @@
+#include "system/TransformSystem.hpp"
+#include "math/TransformBatch.hpp"
+#include <algorithm>
+
+namespace {
+// Dirty batches above this size are split over the thread pool
+const std::size_t PARALLEL_BATCH = 4096;
+// Changed subtrees are walked one by one while there are fewer than one per
+// this many nodes, above that a linear pass in depth order is cheaper
+const std::size_t LINEAR_PASS_RATIO = 8;
+// Fewest waiting parents worth a sweep for ones destroyed meanwhile
+const std::size_t MIN_WAITING_PURGE = 64;
+} // namespace
+
+void TransformSystem::reset() {
+  nodes.assign(world->slotCount() + 1, Node{});
+  localMatrices.assign(nodes.size(), glm::mat4(1.0f));
+  worldMatrices.assign(nodes.size(), glm::mat4(1.0f));
+  nodeCount = 0;
+  order.clear();
+  orderValid = false;
+  waiting.clear();
+  waitingPurgeSize = MIN_WAITING_PURGE;
+}
+
+// Breadth first from the roots, so every level follows the one above
+void TransformSystem::sortByDepth() {
+  order.clear();
+  for (std::uint32_t slot = 1; slot < nodes.size(); ++slot)
+    if (nodes[slot].entity != INVALID_ENTITY && nodes[slot].parent == NO_NODE)
+      order.push_back(slot);
+  for (std::size_t i = 0; i < order.size(); ++i)
+    for (std::uint32_t c = nodes[order[i]].firstChild; c != NO_NODE;
+         c = nodes[c].nextSibling)
+      order.push_back(c);
+  orderValid = true;
+}
+
+void TransformSystem::unlink(std::uint32_t slot) {
+  Node &node = nodes[slot];
+  if (node.parent == NO_NODE)
+    return;
+  if (node.prevSibling != NO_NODE)
+    nodes[node.prevSibling].nextSibling = node.nextSibling;
+  else
+    nodes[node.parent].firstChild = node.nextSibling;
+  if (node.nextSibling != NO_NODE)
+    nodes[node.nextSibling].prevSibling = node.prevSibling;
+  node.parent = node.nextSibling = node.prevSibling = NO_NODE;
+}
+
+// Children become roots, their world matrices are redone this update
+void TransformSystem::removeNode(std::uint32_t slot) {
+  unlink(slot);
+  std::uint32_t child = nodes[slot].firstChild;
+  while (child != NO_NODE) {
+    Node &c = nodes[child];
+    std::uint32_t next = c.nextSibling;
+    c.parent = c.nextSibling = c.prevSibling = NO_NODE;
+    orphans.push_back(child);
+    child = next;
+  }
+  nodes[slot] = Node{};
+  --nodeCount;
+  orderValid = false;
+}
+
+// Attaches slot under parent's node; missing or destroyed parents, and ones
+// that would close a cycle (possible when components are replaced
+// wholesale), leave it a root. A live parent without a TransformComponent
+// is waited for, see update().
+void TransformSystem::link(std::uint32_t slot, Entity parent) {
+  std::uint32_t to = NO_NODE;
+  Entity waitsFor = INVALID_ENTITY;
+  if (parent != INVALID_ENTITY) {
+    std::uint32_t p = entityIndex(parent);
+    if (p < nodes.size() && nodes[p].entity == parent) {
+      // Already linked there, which was checked for a cycle then
+      if (nodes[slot].parent == p)
+        return;
+      to = p;
+      for (std::uint32_t a = p; a != NO_NODE; a = nodes[a].parent)
+        if (a == slot)
+          to = NO_NODE;
+    } else if (world->isAlive(parent)) {
+      waitsFor = parent;
+      if (nodes[slot].waitsFor != parent)
+        waiting[parent].push_back(nodes[slot].entity);
+    }
+  }
+  nodes[slot].waitsFor = waitsFor;
+  if (nodes[slot].parent == to)
+    return;
+  orderValid = false;
+  unlink(slot);
+  if (to == NO_NODE)
+    return;
+  Node &node = nodes[slot];
+  node.parent = to;
+  node.nextSibling = nodes[to].firstChild;
+  if (node.nextSibling != NO_NODE)
+    nodes[node.nextSibling].prevSibling = slot;
+  nodes[to].firstChild = slot;
+}
+
+void TransformSystem::update() {
+  if (!built) {
+    // Every transform so far, then only what the World logs
+    world->trackTransformChanges();
+    world->takeTransformChanges(changes);
+    changes.clear();
+    world->view<TransformComponent>().each(
+        [&](Entity e, TransformComponent &) { changes.push_back(e); });
+    reset();
+    built = true;
+  } else if (world->takeTransformChanges(changes)) {
+    reset();
+  }
+  if (nodes.size() < world->slotCount() + 1) {
+    nodes.resize(world->slotCount() + 1);
+    localMatrices.resize(nodes.size(), glm::mat4(1.0f));
+    worldMatrices.resize(nodes.size(), glm::mat4(1.0f));
+  }
+  ++stamp;
+  orphans.clear();
+
+  // Destroyed nodes go and new ones come first, so parents logged after
+  // their children are found when linking. Children that waited for a new
+  // node are relinked with the logged ones.
+  dirtyNodes.clear();
+  dirtyTransforms.clear();
+  for (std::size_t i = 0; i < changes.size(); ++i) {
+    const Entity e = changes[i];
+    std::uint32_t slot = entityIndex(e);
+    TransformComponent *tc = world->getTransform(e);
+    if (!tc) {
+      if (nodes[slot].entity == e)
+        removeNode(slot);
+      continue;
+    }
+    if (nodes[slot].queued == stamp)
+      continue;
+    nodes[slot].queued = stamp;
+    tc->dirty = false;
+    dirtyNodes.push_back(slot);
+    dirtyTransforms.push_back(*tc);
+    if (nodes[slot].entity != e) {
+      if (nodes[slot].entity != INVALID_ENTITY)
+        removeNode(slot);
+      nodes[slot].entity = e;
+      ++nodeCount;
+      orderValid = false;
+      auto it = waiting.empty() ? waiting.end() : waiting.find(e);
+      if (it != waiting.end()) {
+        changes.insert(changes.end(), it->second.begin(), it->second.end());
+        waiting.erase(it);
+      }
+    }
+  }
+
+  // Logged nodes take their component's parent and local matrix
+  const std::size_t dirtyCount = dirtyNodes.size();
+  for (std::size_t k = 0; k < dirtyCount; ++k)
+    link(dirtyNodes[k], dirtyTransforms[k].parent);
+  dirtyMatrices.resize(dirtyCount);
+  {
+    TaskGroup group(dirtyCount > PARALLEL_BATCH ? threadPool : nullptr);
+    for (std::size_t begin = 0; begin < dirtyCount; begin += PARALLEL_BATCH) {
+      std::size_t count = std::min(PARALLEL_BATCH, dirtyCount - begin);
+      group.run([this, begin, count] {
+        composeModelMatrices(dirtyTransforms.data() + begin, count,
+                             dirtyMatrices.data() + begin);
+      });
+    }
+    group.wait();
+  }
+  for (std::size_t k = 0; k < dirtyCount; ++k)
+    localMatrices[dirtyNodes[k]] = dirtyMatrices[k];
+
+  // Changed nodes and orphans start the propagation
+  const bool linear =
+      (orphans.size() + dirtyCount) * LINEAR_PASS_RATIO >= nodeCount;
+  roots.clear();
+  for (const std::vector<std::uint32_t> *list : {&orphans, &dirtyNodes})
+    for (std::uint32_t slot : *list) {
+      // Orphans may have been destroyed or logged themselves
+      if (nodes[slot].entity == INVALID_ENTITY || nodes[slot].rooted == stamp)
+        continue;
+      nodes[slot].rooted = stamp;
+      if (!linear)
+        roots.push_back(slot);
+    }
+  lastUpdatedCount = linear ? propagateInOrder() : propagateFromRoots();
+
+  // Children of parents destroyed before they got a transform
+  if (waiting.size() > waitingPurgeSize) {
+    std::erase_if(waiting, [&](const auto &entry) {
+      return !world->isAlive(entry.first);
+    });
+    waitingPurgeSize = std::max(MIN_WAITING_PURGE, 2 * waiting.size());
+  }
+}
+
+// Each subtree walked once, from its topmost changed node
+std::size_t TransformSystem::propagateFromRoots() {
+  std::size_t updated = 0;
+  for (std::uint32_t root : roots) {
+    bool covered = false;
+    for (std::uint32_t a = nodes[root].parent; a != NO_NODE && !covered;
+         a = nodes[a].parent)
+      covered = nodes[a].rooted == stamp;
+    if (covered)
+      continue;
+    stack.push_back(root);
+    while (!stack.empty()) {
+      std::uint32_t slot = stack.back();
+      stack.pop_back();
+      const Node &node = nodes[slot];
+      worldMatrices[slot] = node.parent == NO_NODE
+                                ? localMatrices[slot]
+                                : worldMatrices[node.parent] *
+                                      localMatrices[slot];
+      ++updated;
+      for (std::uint32_t c = node.firstChild; c != NO_NODE;
+           c = nodes[c].nextSibling)
+        stack.push_back(c);
+    }
+  }
+  return updated;
+}
+
+// Parents come before their children, so one pass carries every change
+// down; rooted then marks every node whose world matrix was redone
+std::size_t TransformSystem::propagateInOrder() {
+  if (!orderValid)
+    sortByDepth();
+  std::size_t updated = 0;
+  for (std::uint32_t slot : order) {
+    Node &node = nodes[slot];
+    if (node.rooted != stamp &&
+        (node.parent == NO_NODE || nodes[node.parent].rooted != stamp))
+      continue;
+    node.rooted = stamp;
+    worldMatrices[slot] = node.parent == NO_NODE
+                              ? localMatrices[slot]
+                              : worldMatrices[node.parent] *
+                                    localMatrices[slot];
+    ++updated;
+  }
+  return updated;
+}
+
+const glm::mat4 *TransformSystem::getWorldMatrix(Entity e) const {
+  std::uint32_t index = entityIndex(e);
+  if (index >= nodes.size() || nodes[index].entity != e)
+    return nullptr;
+  return &worldMatrices[index];
+}
@@ -0,0 +1,111 @@
+// Runs systems with conflicting component access on the scheduler and fails
+// (exit status 1) if two conflicting systems ever run at the same time, or
+// run in other than registration order. Registered with ctest.
+#include "system/SystemScheduler.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const std::size_t FRAMES = 200;
+
+// Detects overlapping execution of conflicting systems at runtime
+struct AccessTracker {
+  std::atomic<int> readers[COMPONENT_TYPE_COUNT] = {};
+  std::atomic<int> writers[COMPONENT_TYPE_COUNT] = {};
+  std::atomic<int> violations{0};
+
+  void enter(const SystemAccess &a) {
+    for (std::size_t c = 0; c < COMPONENT_TYPE_COUNT; ++c) {
+      ComponentMask bit = ComponentMask(1) << c;
+      if (a.writes & bit) {
+        if (writers[c].fetch_add(1) != 0 || readers[c].load() != 0)
+          violations.fetch_add(1);
+      } else if (a.reads & bit) {
+        readers[c].fetch_add(1);
+        if (writers[c].load() != 0)
+          violations.fetch_add(1);
+      }
+    }
+  }
+  void leave(const SystemAccess &a) {
+    for (std::size_t c = 0; c < COMPONENT_TYPE_COUNT; ++c) {
+      ComponentMask bit = ComponentMask(1) << c;
+      if (a.writes & bit)
+        writers[c].fetch_sub(1);
+      else if (a.reads & bit)
+        readers[c].fetch_sub(1);
+    }
+  }
+};
+
+void spin(std::chrono::microseconds duration) {
+  auto until = std::chrono::steady_clock::now() + duration;
+  while (std::chrono::steady_clock::now() < until) {
+  }
+}
+
+// Returns the number of failures
+int runWithWorkers(unsigned workers) {
+  const std::vector<SystemAccess> accesses = {
+      SystemAccess().write<TransformComponent>(),
+      SystemAccess().read<TransformComponent, RenderComponent>(),
+      SystemAccess().write<LuaScriptComponent>(),
+      SystemAccess().read<RenderComponent>(),
+      SystemAccess().read<TransformComponent>(),
+      SystemAccess().write<RenderComponent>().onMainThread(),
+      SystemAccess().read<LuaScriptComponent>(),
+      SystemAccess().read<TransformComponent>(),
+      SystemAccess().write<TransformComponent, LuaScriptComponent>(),
+  };
+  const std::size_t n = accesses.size();
+
+  AccessTracker tracker;
+  // Per system, the frame it last finished
+  std::vector<std::atomic<std::size_t>> finished(n);
+  std::atomic<std::size_t> frame{0};
+  std::atomic<int> outOfOrder{0};
+
+  ThreadPool pool(workers ? workers : 1);
+  SystemScheduler scheduler(workers ? &pool : nullptr);
+  for (std::size_t i = 0; i < n; ++i) {
+    scheduler.addSystem("test", accesses[i], [&, i] {
+      const std::size_t f = frame.load();
+      // Every earlier conflicting system has finished this frame
+      for (std::size_t j = 0; j < i; ++j)
+        if (accesses[j].conflictsWith(accesses[i]) && finished[j].load() != f)
+          outOfOrder.fetch_add(1);
+      tracker.enter(accesses[i]);
+      spin(std::chrono::microseconds(20));
+      tracker.leave(accesses[i]);
+      finished[i].store(f);
+    });
+  }
+  for (std::size_t f = 1; f <= FRAMES; ++f) {
+    frame.store(f);
+    scheduler.runFrame();
+  }
+
+  std::size_t skipped = 0;
+  for (std::size_t i = 0; i < n; ++i)
+    skipped += finished[i].load() != FRAMES;
+  const int overlaps = tracker.violations.load();
+  std::printf("%u workers: %d overlaps, %d out of order, %zu not run\n",
+              workers, overlaps, outOfOrder.load(), skipped);
+  return overlaps + outOfOrder.load() + int(skipped);
+}
+
+} // namespace
+
+int main() {
+  int failures = 0;
+  for (unsigned workers : {0u, 1u, 2u, 4u, 8u})
+    failures += runWithWorkers(workers);
+  if (failures > 0) {
+    std::fprintf(stderr, "FAILED\n");
+    return 1;
+  }
+  return 0;
+}